@@ -10,10 +10,49 @@
 #include <memory>
 #include <cmath>
 #include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <shaman/half_types.h>
+
+#ifdef SHAMAN_QUAD_PRECISION
+#include <shaman/quad_precision.h>
+#endif
 
 #ifdef SHAMAN_TAGGED_ERROR
 #include <shaman/tagged/error_sum.h>
+#if (defined(SHAMAN_TAPE) + defined(SHAMAN_POOLED_ERROR) + defined(SHAMAN_TOPK_ERROR)) > 1
+#error "The SHAMAN_TAPE, SHAMAN_POOLED_ERROR and SHAMAN_TOPK_ERROR flags cannot be used together."
+#endif
+#ifdef SHAMAN_TAPE
+// the error composants are recorded on a tape and attributed on demand
+#include <shaman/tagged/error_tape.h>
+template<typename errorType> using error_composants = error_tape<errorType>;
+#elif defined(SHAMAN_POOLED_ERROR)
+// the error composants are propagated forward, in blocks shared between the numbers
+#include <shaman/tagged/error_pool.h>
+template<typename errorType> using error_composants = error_pool<errorType>;
+#elif defined(SHAMAN_TOPK_ERROR)
+// only the composants of the SHAMAN_TOPK largest tags are propagated forward
+#include <shaman/tagged/error_topk.h>
+template<typename errorType> using error_composants = error_topk<errorType>;
 #else
+// the error composants are propagated forward
+template<typename errorType> using error_composants = error_sum<errorType>;
+#endif
+#else
+#ifdef SHAMAN_TAPE
+#error "The SHAMAN_TAPE flag requires the SHAMAN_TAGGED_ERROR flag."
+#endif
+#ifdef SHAMAN_POOLED_ERROR
+#error "The SHAMAN_POOLED_ERROR flag requires the SHAMAN_TAGGED_ERROR flag."
+#endif
+#ifdef SHAMAN_TOPK_ERROR
+#error "The SHAMAN_TOPK_ERROR flag requires the SHAMAN_TAGGED_ERROR flag."
+#endif
+#ifdef SHAMAN_CALL_PATH
+#error "The SHAMAN_CALL_PATH flag requires the SHAMAN_TAGGED_ERROR flag."
+#endif
 #define FUNCTION_BLOCK
 #define LOCAL_BLOCK(text)
 #endif
@@ -25,9 +64,100 @@
 #define CONSTEXPR14
 #endif
 
+// constexpr arithmetic operators, used if we are in C++20 or more (the EFT can then tell constant evaluation apart)
+// the error of constant expressions (such as 'constexpr Sdouble third = Sdouble(1) / 3;') is then computed at compile time
+// NOTE: not available with tagged error, the error composants are not literal types
+#if defined(__cpp_lib_is_constant_evaluated) && !defined(SHAMAN_TAGGED_ERROR)
+#define SHAMAN_CONSTEXPR_ARITHMETIC
+#define CONSTEXPR20 constexpr
+#else
+#define CONSTEXPR20
+#endif
+
+// hints that a condition is rarely true
+#if defined(__GNUC__) || defined(__clang__)
+#define SHAMAN_UNLIKELY(condition) __builtin_expect(static_cast<bool>(condition), 0)
+#else
+#define SHAMAN_UNLIKELY(condition) (condition)
+#endif
+
+#ifdef SHAMAN_PRECISION_ADVISOR
+#ifndef SHAMAN_TAGGED_ERROR
+#error "The SHAMAN_PRECISION_ADVISOR flag requires the SHAMAN_TAGGED_ERROR flag."
+#endif
+namespace Shaman
+{
+    template<typename numberType, typename errorType> void recordPrecision(numberType number, errorType error);
+}
+#endif
+
+#ifdef SHAMAN_CANCELLATION
+#ifndef SHAMAN_TAGGED_ERROR
+#error "The SHAMAN_CANCELLATION flag requires the SHAMAN_TAGGED_ERROR flag."
+#endif
+namespace Shaman
+{
+    template<typename numberType> void recordCancellation(numberType n1, numberType n2, numberType result);
+}
+#endif
+
+#ifdef SHAMAN_OPERATION_COUNTERS
+#include <shaman/tagged/global_vars.h>
+namespace Shaman
+{
+    template<typename Stype> void countOperation(Operation operation, unsigned long long count = 1);
+
+    #ifdef SHAMAN_CONSTEXPR_ARITHMETIC
+    // the operations evaluated at compile time are not counted
+    template<typename Stype> constexpr void countRuntimeOperation(Operation operation)
+    {
+        if (not std::is_constant_evaluated()) countOperation<Stype>(operation);
+    }
+    #else
+    template<typename Stype> inline void countRuntimeOperation(Operation operation)
+    {
+        countOperation<Stype>(operation);
+    }
+    #endif
+}
+// counts an operation performed on a Snum in the current block (see Shaman::displayOperationCounts)
+#define SHAMAN_COUNT_OPERATION(operation) Shaman::countRuntimeOperation<Snum>(Shaman::Operation::operation)
+#else
+#define SHAMAN_COUNT_OPERATION(operation)
+#endif
+
+namespace Shaman
+{
+    /*
+     * converts an error into a (possibly narrower) error type
+     * an error too large for the error type becomes an infinity of its sign (the error is never underestimated)
+     * a non-zero error too small for the error type becomes the smallest denormal of its sign (the number is never deemed exact)
+     */
+    template<typename errorType, typename T, typename std::enable_if<not std::is_same<T,errorType>::value, int>::type = 0>
+    inline constexpr errorType narrow_error(T error)
+    {
+        return (error > T(std::numeric_limits<errorType>::max())) ? std::numeric_limits<errorType>::infinity() :
+               (error < T(std::numeric_limits<errorType>::lowest())) ? -std::numeric_limits<errorType>::infinity() :
+               ((error != T(0)) and (static_cast<errorType>(error) == errorType(0))) ?
+                   ((error > T(0)) ? std::numeric_limits<errorType>::denorm_min() : -std::numeric_limits<errorType>::denorm_min()) :
+               static_cast<errorType>(error);
+    }
+
+    template<typename errorType, typename T, typename std::enable_if<std::is_same<T,errorType>::value, int>::type = 0>
+    inline constexpr errorType narrow_error(T error)
+    {
+        return error;
+    }
+}
+
 //-------------------------------------------------------------------------------------------------
 // SHAMAN CLASS
 
+#ifdef SHAMAN_PACKED
+// aligns the fields on 4 bytes so that a S<double,float,...> takes 12 bytes rather than 16
+#pragma pack(push, 4)
+#endif
+
 /*
  * the base SHAMAN class, represents a number and its error
  */
@@ -41,27 +171,33 @@ public:
     errorType error; // approximation of the current error
 
 #ifdef SHAMAN_TAGGED_ERROR
-    error_sum<errorType> errorComposants; // composants of the error
+    error_composants<errorType> errorComposants; // composants of the error
     // base constructors
     inline constexpr S(): number(), error(), errorComposants() {};
     inline constexpr S(numberType numberArg): number(numberArg), error(), errorComposants() {}; // we accept implicit cast from T to S<T>
-    inline CONSTEXPR14 S(numberType numberArg, errorType errorArg, error_sum<errorType> errorCompArg): number(numberArg), error(errorArg), errorComposants(errorCompArg)
+    inline CONSTEXPR14 S(numberType numberArg, errorType errorArg, error_composants<errorType> errorCompArg): number(numberArg), error(errorArg), errorComposants(std::move(errorCompArg))
     {
         #ifdef SHAMAN_FLUSH_NANINF
         if(not std::isfinite(errorArg))
         {
             error = errorType();
-            errorComposants = error_sum<errorType>();
+            errorComposants = error_composants<errorType>();
         }
         #endif
+        #ifdef SHAMAN_PRECISION_ADVISOR
+        Shaman::recordPrecision(number, error);
+        #endif
     };
+    // with an error computed in another precision
+    template<typename E, typename = typename std::enable_if<std::is_floating_point<E>::value and not std::is_same<E,errorType>::value>::type>
+    inline CONSTEXPR14 S(numberType numberArg, E errorArg, error_composants<errorType> errorCompArg): S(numberArg, Shaman::narrow_error<errorType>(errorArg), std::move(errorCompArg)) {};
     // from floating point
     template<typename T,
             typename = typename std::enable_if<std::is_floating_point<T>::value, T>::type,
             typename = typename std::enable_if<not std::is_same<T,numberType>::value, T>::type >
     inline CONSTEXPR14 explicit S(T x): number(x), error(), errorComposants()
     {
-        const errorType castError = errorType(x - number);
+        const errorType castError = Shaman::narrow_error<errorType>(x - number);
         error = castError;
         errorComposants.addError(castError);
     };
@@ -73,6 +209,10 @@ public:
         error = castError;
         errorComposants.addError(castError);
     };
+    // from S type with the same number type but another error type
+    template<typename e, typename p,
+             typename = typename std::enable_if<not std::is_same<S<numberType,e,p>,S>::value, e>::type >
+    inline CONSTEXPR14 S(const S<numberType,e,p>& s): number(s.number), error(Shaman::narrow_error<errorType>(s.error)), errorComposants(s.errorComposants) {};
     // from other S type
     template<typename n, typename e, typename p,
              typename = typename std::enable_if<not std::is_same<n,numberType>::value, n>::type >
@@ -85,7 +225,7 @@ public:
     // from other volatile S type
     template<typename n, typename e, typename p,
              typename = typename std::enable_if<not std::is_same<n,numberType>::value, n>::type >
-    inline CONSTEXPR14 S(const volatile S<n,e,p>& s): number(s.number), error(s.error), errorComposants(const_cast<error_sum<e>&>(s.errorComposants))
+    inline CONSTEXPR14 S(const volatile S<n,e,p>& s): number(s.number), error(s.error), errorComposants(const_cast<error_composants<e>&>(s.errorComposants))
     {
         const errorType castError = errorType(s.number - number);
         error += castError;
@@ -104,14 +244,21 @@ public:
         }
         #endif
     };
+    // with an error computed in another precision
+    template<typename E, typename = typename std::enable_if<std::is_floating_point<E>::value and not std::is_same<E,errorType>::value>::type>
+    inline CONSTEXPR14 S(numberType numberArg, E errorArg): S(numberArg, Shaman::narrow_error<errorType>(errorArg)) {};
     // from floating point
     template<typename T,
             typename = typename std::enable_if<std::is_floating_point<T>::value, T>::type,
             typename = typename std::enable_if<not std::is_same<T,numberType>::value, T>::type >
-    inline constexpr explicit S(T x): number(x), error(x - numberType(x)) {};
+    inline constexpr explicit S(T x): number(x), error(Shaman::narrow_error<errorType>(x - numberType(x))) {};
     // from integer
     template<typename T, typename = typename std::enable_if<std::is_integral<T>::value, T>::type>
     inline constexpr S(T x): number(x), error(preciseType(x) - numberType(x)) {};
+    // from S type with the same number type but another error type
+    template<typename e, typename p,
+            typename = typename std::enable_if<not std::is_same<S<numberType,e,p>,S>::value, e>::type>
+    inline constexpr S(const S<numberType,e,p>& s): number(s.number), error(Shaman::narrow_error<errorType>(s.error)) {};
     // from other S type
     template<typename n, typename e, typename p,
             typename = typename std::enable_if<not std::is_same<n,numberType>::value, n>::type>
@@ -135,16 +282,19 @@ public:
     inline explicit operator float() const { return (float) number; };
     inline explicit operator double() const { return (double) number; };
     inline explicit operator long double() const { return (long double) number; };
+#ifdef SHAMAN_QUAD_PRECISION
+    inline explicit operator __float128() const { return (__float128) number; };
+#endif
 
     // arithmetic operators
-    S& operator++();
-    S& operator--();
-    S& operator++(int);
-    S& operator--(int);
-    S& operator+=(const S& n);
-    S& operator-=(const S& n);
-    S& operator*=(const S& n);
-    S& operator/=(const S& n);
+    CONSTEXPR20 S& operator++();
+    CONSTEXPR20 S& operator--();
+    CONSTEXPR20 S& operator++(int);
+    CONSTEXPR20 S& operator--(int);
+    CONSTEXPR20 S& operator+=(const S& n);
+    CONSTEXPR20 S& operator-=(const S& n);
+    CONSTEXPR20 S& operator*=(const S& n);
+    CONSTEXPR20 S& operator/=(const S& n);
 
     // methods
     static numberType digits(numberType number, errorType error);
@@ -155,24 +305,29 @@ public:
     // unstability detection
     static bool non_significant(numberType number, errorType error);
     bool non_significant() const;
-    static void checkUnstableBranch(S n1, S n2);
+    static void checkUnstableBranch(const S& n1, const S& n2);
+    static void checkUnstableBranch(numberType number1, errorType error1, numberType number2, errorType error2);
 };
 
+#ifdef SHAMAN_PACKED
+#pragma pack(pop)
+#endif
+
 // some macro to shorten template notations
 #define templated template<typename numberType, typename errorType, typename preciseType>
 #define Snum S<numberType,errorType,preciseType>
-#define Serror error_sum<errorType>
+#define Serror error_composants<errorType>
 
 //-------------------------------------------------------------------------------------------------
 // SHAMAN OPERATIONS
 
 // arithmetic operators
-templated const Snum operator+(const Snum& n);
-templated const Snum operator-(const Snum& n);
-templated const Snum operator+(const Snum& n1, const Snum& n2);
-templated const Snum operator-(const Snum& n1, const Snum& n2);
-templated const Snum operator*(const Snum& n1, const Snum& n2);
-templated const Snum operator/(const Snum& n1, const Snum& n2);
+templated CONSTEXPR20 const Snum operator+(const Snum& n);
+templated CONSTEXPR20 const Snum operator-(const Snum& n);
+templated CONSTEXPR20 const Snum operator+(const Snum& n1, const Snum& n2);
+templated CONSTEXPR20 const Snum operator-(const Snum& n1, const Snum& n2);
+templated CONSTEXPR20 const Snum operator*(const Snum& n1, const Snum& n2);
+templated CONSTEXPR20 const Snum operator/(const Snum& n1, const Snum& n2);
 
 // boolean operators
 templated bool operator==(const Snum& n1, const Snum& n2);
@@ -185,8 +340,14 @@ templated bool operator>=(const Snum& n1, const Snum& n2);
 // shaman specific functions
 namespace Shaman
 {
+    class Session;
+    inline Session& session();
     static void unstability();
     static void displayUnstableBranches();
+    static void displayPrecisionAdvice(double toleratedDigitLoss = 1.);
+    static void displayCancellations(int minBitsLost = 10);
+    static void displayOperationCounts(const std::vector<double>& nanosecondsPerOperation = {});
+    templated void observe(const Snum& output);
 }
 
 // streaming operator
@@ -197,13 +358,23 @@ templated std::istream& operator>>(std::istream& is, Snum& v);
 // TYPES
 
 #ifdef NO_SHAMAN
+using Shalf = Shaman::half;
+using Sbfloat16 = Shaman::bfloat16;
 using Sfloat = float;
 using Sdouble = double;
+using Sdouble_compact = double;
 using Slong_double = long double;
 #else
+using Shalf = S<Shaman::half, float, double>;
+using Sbfloat16 = S<Shaman::bfloat16, float, double>;
 using Sfloat = S<float, float, double>;
 using Sdouble = S<double, double, long double>;
+using Sdouble_compact = S<double, float, long double>; // stores its error in a float
+#ifdef SHAMAN_QUAD_PRECISION
+using Slong_double = S<long double, long double, __float128>;
+#else
 using Slong_double = S<long double, long double, long double>;
+#endif
 #endif //NO_SHAMAN
 
 //-------------------------------------------------------------------------------------------------
@@ -215,12 +386,16 @@ using Slong_double = S<long double, long double, long double>;
 #include <shaman/traits.h>
 #include <shaman/helpers/shaman_complex.h>
 #include <shaman/helpers/shaman_openmp.h>
+#if defined(SHAMAN_EXTERN_TEMPLATES) && !defined(NO_SHAMAN)
+#include <shaman/instantiations.h>
+#endif
 
 //-------------------------------------------------------------------------------------------------
 
 #undef templated
 #undef Snum
 #undef Serror
+#undef SHAMAN_COUNT_OPERATION
 
 #endif //SHAMAN_H
 
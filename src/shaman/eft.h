@@ -3,14 +3,17 @@
 
 #include <utility> // for std::swap
 #include <cmath>
+#include <limits>
+#include <type_traits>
 
 /*
  * ERROR FREE TRANSFORM
  *
  * gives us the exact error|remainder of an arithmetic operation using :
- * - twoSum for + (might be killed by aggressive compilation in the absence of protection)
+ * - twoSum for + (protected against aggressive compilation by barriers, see detail::barrier)
  * - std::fma for *, /, sqrt (reliable independent of the compilations flags)
- * - fastTwoSum for src::fma via errorFma (rarely|never useful, might be killed by aggressive compilation)
+ * - fastTwoSum for src::fma via errorFma (rarely|never useful, protected like twoSum)
+ * - plain twoSum and Dekker's product during constant evaluation (C++20, see EFT::constant)
  *
  * NOTE :
  * see the handbook of floating point arithmetic for an exact analysis
@@ -21,18 +24,132 @@
  * However it was shown that these EFT stay accurate even with directed rounding (toward infinite)
  * (Numerical validation of compensated algorithms with stochastic arithmetic)
 */
+
+// __builtin_assoc_barrier (gcc 12+) protects an expression from reassociation without spilling it to memory
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_assoc_barrier)
+#define SHAMAN_ASSOC_BARRIER
+#endif
+#endif
+
+// C++20 can tell constant evaluation apart, the EFT are then constexpr (the barriers and std::fma are not)
+// NOTE: the lane types (such as std::experimental::simd) and the half types are never evaluated at compile time
+#if defined(__cpp_lib_is_constant_evaluated)
+#define SHAMAN_CONSTANT_EVALUATION
+#define SHAMAN_EFT_CONSTEXPR constexpr
+#else
+#define SHAMAN_EFT_CONSTEXPR
+#endif
+
 namespace EFT
 {
+    namespace detail
+    {
+        // fma found by argument dependent lookup so that lane types (such as std::experimental::simd) can provide their own
+        template<typename T>
+        inline T fma(const T& n1, const T& n2, const T& n3)
+        {
+            using std::fma;
+            return fma(n1, n2, n3);
+        }
+
+        // returns x unchanged but forbids the compiler from reassociating or simplifying the operations that produced it
+        // with the operations that use it (as -ffast-math would do) while leaving it in a register
+        // NOTE falls back to a volatile store (a spill to memory) when the compiler provides no barrier
+        template<typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+        inline T barrier(T x)
+        {
+        #if defined(SHAMAN_ASSOC_BARRIER)
+            return __builtin_assoc_barrier(x);
+        #elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+            asm("" : "+xm"(x)); // the compiler cannot see through the empty asm and picks a register if it can
+            return x;
+        #else
+            volatile T result = x;
+            return result;
+        #endif
+        }
+
+        // barrier for lane types (such as std::experimental::simd) which are not accepted by the builtin
+        // NOTE this barrier does store the value to memory (once, where a volatile would reload it at each use)
+        template<typename T, typename std::enable_if<not std::is_arithmetic<T>::value, int>::type = 0>
+        inline T barrier(T x)
+        {
+        #if defined(__GNUC__)
+            asm("" : "+m"(x));
+        #endif
+            return x;
+        }
+    }
+
+    /*
+     * EFT used when evaluating a constant expression
+     * the compiler then computes exactly the operations as written (in round to nearest) : no barrier is needed
+     * and the products are split (Dekker's algorithm) rather than going through an fma
+     */
+    namespace constant
+    {
+        template<typename T>
+        constexpr T TwoSum(const T n1, const T n2, const T result)
+        {
+            const T n22 = result - n1;
+            const T n11 = result - n22;
+            return (n1 - n11) + (n2 - n22);
+        }
+
+        template<typename T>
+        constexpr T FastTwoSum(const T n1, const T n2, const T result)
+        {
+            return n2 - (result - n1);
+        }
+
+        // Veltkamp's splitting : returns the upper half of the digits of x (x - high is exact and holds the lower half)
+        template<typename T>
+        constexpr T highHalf(const T x)
+        {
+            const T splitter = static_cast<T>((1ull << ((std::numeric_limits<T>::digits + 1) / 2)) + 1ull);
+            const T scaled = splitter * x;
+            return scaled - (scaled - x);
+        }
+
+        // exact value of n1*n2 - result (what fma(n1, n2, -result) computes)
+        // WARNING the splitting overflows for |n| close to the largest number of the type
+        template<typename T>
+        constexpr T TwoProd(const T n1, const T n2, const T result)
+        {
+            const T high1 = highHalf(n1);
+            const T low1 = n1 - high1;
+            const T high2 = highHalf(n2);
+            const T low2 = n2 - high2;
+            return (((high1 * high2 - result) + high1 * low2) + low1 * high2) + low1 * low2;
+        }
+
+        // exact value of n1 - n2*result (the remainder is representable and n2*result is close to n1)
+        template<typename T>
+        constexpr T RemainderDiv(const T n1, const T n2, const T result)
+        {
+            const T product = n2 * result;
+            return (n1 - product) - TwoProd(n2, result, product);
+        }
+    }
+
     // basic EFT for a sum
     // WARNING requires rounding to nearest (see Priest)
-    // NOTE the volatile keyword is there to avoid the operation being optimized away by a compiler using associativity rules
+    // NOTE the barriers are there to avoid the operation being optimized away by a compiler using associativity rules
     template<typename T>
-    inline const T TwoSum(const T n1, const T n2, const volatile T result)
+    inline SHAMAN_EFT_CONSTEXPR const T TwoSum(const T n1, const T n2, const T result)
     {
-        T n22 = result - n1;
-        T n11 = result - n22;
-        volatile T epsilon2 = n2 - n22;
-        volatile T epsilon1 = n1 - n11;
+        #ifdef SHAMAN_CONSTANT_EVALUATION
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            if (std::is_constant_evaluated()) return constant::TwoSum(n1, n2, result);
+        }
+        #endif
+        const T sum = detail::barrier(result);
+        T n22 = detail::barrier(T(sum - n1));
+        T n11 = detail::barrier(T(sum - n22));
+        T epsilon2 = detail::barrier(T(n2 - n22));
+        T epsilon1 = detail::barrier(T(n1 - n11));
         T error = epsilon1 + epsilon2;
         return error;
     }
@@ -42,18 +159,30 @@ namespace EFT
     // NOTE proof for rounding toward zero in "Error-Free Transformation in Rounding Mode toward Zero"
     // WARNING proved only for rounding to nearest and toward zero
     template<typename T>
-    inline const T FastTwoProd(const T n1, const T n2, const T result)
+    inline SHAMAN_EFT_CONSTEXPR const T FastTwoProd(const T n1, const T n2, const T result)
     {
-        T error = std::fma(n1, n2, -result);
+        #ifdef SHAMAN_CONSTANT_EVALUATION
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            if (std::is_constant_evaluated()) return constant::TwoProd(n1, n2, result);
+        }
+        #endif
+        T error = detail::fma(n1, n2, T(-result));
         return error;
     }
 
     // computes the remainder of the division
     // see Handbook of floating point arithmetic
     template<typename T>
-    inline const T RemainderDiv(const T n1, const T n2, const T result)
+    inline SHAMAN_EFT_CONSTEXPR const T RemainderDiv(const T n1, const T n2, const T result)
     {
-        T remainder = -std::fma(n2, result, -n1);
+        #ifdef SHAMAN_CONSTANT_EVALUATION
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            if (std::is_constant_evaluated()) return constant::RemainderDiv(n1, n2, result);
+        }
+        #endif
+        T remainder = -detail::fma(n2, result, T(-n1));
         return remainder;
     }
 
@@ -62,19 +191,25 @@ namespace EFT
     template<typename T>
     inline const T RemainderSqrt(const T n, const T result)
     {
-        T remainder = -std::fma(result, result, -n);
+        T remainder = -detail::fma(result, result, T(-n));
         return remainder;
     }
 
     // fast EFT for a sum
     // NOTE requires hypothesis on the inputs (n1 > n2)
     // WARNING requires rounding to nearest (see Priest)
-    // NOTE the volatile keyword is there to avoid the operation being optimized away by a compiler using associativity rules
+    // NOTE the barriers are there to avoid the operation being optimized away by a compiler using associativity rules
     template<typename T>
-    inline const T FastTwoSum(const T n1, const T n2, const volatile T result)
+    inline SHAMAN_EFT_CONSTEXPR const T FastTwoSum(const T n1, const T n2, const T result)
     {
-        T n22 = result - n1;
-        volatile T error = n2 - n22;
+        #ifdef SHAMAN_CONSTANT_EVALUATION
+        if constexpr (std::is_floating_point<T>::value)
+        {
+            if (std::is_constant_evaluated()) return constant::FastTwoSum(n1, n2, result);
+        }
+        #endif
+        T n22 = detail::barrier(T(detail::barrier(result) - n1));
+        T error = detail::barrier(T(n2 - n22));
         return error;
     }
 
@@ -109,7 +244,8 @@ namespace EFT
     template<typename T>
     inline const T ErrorFma(const T n1, const T n2, const T n3, const T result)
     {
-        T u1 = n1 * n2;
+        // the barrier keeps the product from being contracted into an fma with the sums below
+        T u1 = detail::barrier(T(n1 * n2));
         T u2 = FastTwoProd(n1, n2, u1);
 
         T alpha1 = n3 + u2;
@@ -118,7 +254,7 @@ namespace EFT
         T beta1 = u1 + alpha1;
         T beta2 = TwoSum(u1, alpha1, beta1);
 
-        T gamma = (beta1 - result) + beta2;
+        T gamma = detail::barrier(T(beta1 - result)) + beta2;
         T error1 = gamma + alpha2;
         T error2 = FastTwoSum(gamma, alpha2, error1);
 
@@ -127,4 +263,8 @@ namespace EFT
     }
 }
 
+#undef SHAMAN_ASSOC_BARRIER
+#undef SHAMAN_CONSTANT_EVALUATION
+#undef SHAMAN_EFT_CONSTEXPR
+
 #endif //SHAMAN_EFT_H
@@ -16,14 +16,14 @@
 // defines overload for function taking two arguments
 #define set_Sfunction2_casts(FUN) \
     template<typename N, typename E, typename P, typename arithmeticTYPE(T)> \
-    inline auto FUN (const S<N,E,P>& n1, const T& n2) -> SreturnType(n1.number,n2)\
+    inline auto FUN (const S<N,E,P>& n1, const T& n2) -> SreturnTypeOf(n1,n2)\
     { \
-        return FUN(SreturnType(n1.number,n2)(n1), SreturnType(n1.number,n2)(n2)); \
+        return FUN(SreturnTypeOf(n1,n2)(n1), SreturnTypeOf(n1,n2)(n2)); \
     } \
     template<typename N, typename E, typename P, typename arithmeticTYPE(T)> \
-    inline auto FUN (const T& n1, const S<N,E,P>& n2) -> SreturnType(n1, n2.number)\
+    inline auto FUN (const T& n1, const S<N,E,P>& n2) -> SreturnTypeOf(n2,n1)\
     { \
-        return FUN(SreturnType(n1,n2.number)(n1), SreturnType(n1,n2.number)(n2)); \
+        return FUN(SreturnTypeOf(n2,n1)(n1), SreturnTypeOf(n2,n1)(n2)); \
     } \
     template<typename N1, typename E1, typename P1, typename N2, typename E2, typename P2> \
     inline auto FUN (const S<N1,E1,P1>& n1, const S<N2,E2,P2>& n2) -> SreturnType(n1.number, n2.number) \
@@ -69,13 +69,63 @@
         return FUN(SreturnType3(n1,n2,n3.number)(n1), SreturnType3(n1,n2,n3.number)(n2), SreturnType3(n1,n2,n3.number)(n3)); \
     }
 
+//-----------------------------------------------------------------------------
+// FUNCTION ERROR
+
+namespace Shaman
+{
+    namespace detail
+    {
+        /*
+         * number of binary digits of a precise type
+         * (std::numeric_limits is not specialized for __float128 by every standard library)
+         */
+        template<typename T>
+        struct precise_digits : std::integral_constant<int, std::numeric_limits<T>::digits> {};
+
+        #ifdef SHAMAN_QUAD_PRECISION
+        template<>
+        struct precise_digits<__float128> : std::integral_constant<int, FLT128_MANT_DIG> {};
+        #endif
+
+        /*
+         * returns the total error of result, the value computed for f(n.number) : f(n.corrected_number()) - result
+         *
+         * if preciseType is not more precise than numberType (Slong_double without SHAMAN_QUAD_PRECISION)
+         * the corrected number usually rounds back to the number and the propagated error would be lost,
+         * we then use the first order approximation f'(number)*error with a forward finite difference for the derivative
+         * (the rounding error of the function itself cannot be measured in that case)
+         */
+        template<typename numberType, typename errorType, typename preciseType, typename Function>
+        inline preciseType functionTotalError(Function f, const Snum& n, numberType result)
+        {
+            const preciseType correctedNumber = n.corrected_number();
+            const bool isPrecise = precise_digits<preciseType>::value > precise_digits<numberType>::value;
+            if(isPrecise or (n.error == 0) or (correctedNumber != preciseType(n.number)))
+            {
+                return f(correctedNumber) - result;
+            }
+
+            const preciseType number = n.number;
+            const preciseType preciseResult = f(number);
+            // the step balances the truncation error of the difference with the rounding error of f
+            const preciseType step = std::sqrt(std::numeric_limits<preciseType>::epsilon()) * std::max(std::abs(number), preciseType(1));
+            const preciseType shiftedNumber = (n.error > 0) ? number + step : number - step;
+            const preciseType derivative = (f(shiftedNumber) - preciseResult) / (shiftedNumber - number);
+            const preciseType functionError = preciseResult - result;
+            // the derivative is not finite on a pole
+            return std::isfinite(derivative) ? functionError + derivative * preciseType(n.error) : functionError;
+        }
+    }
+}
+
 #ifdef SHAMAN_TAGGED_ERROR
 #define SHAMAN_FUNCTION(functionName) \
     templated const Snum functionName (const Snum& n) \
     { \
+        SHAMAN_COUNT_OPERATION(function); \
         numberType result = std::functionName(n.number); \
-        preciseType preciseCorrectedResult = std::functionName(n.corrected_number()); \
-        preciseType totalError = preciseCorrectedResult - result; \
+        preciseType totalError = Shaman::detail::functionTotalError([](preciseType x) -> preciseType {return std::functionName(x);}, n, result); \
         Serror newErrorComp; \
         if(n.error == 0.) \
         { \
@@ -95,9 +145,9 @@
     #define SHAMAN_FUNCTION(functionName) \
     templated const Snum functionName (const Snum& n) \
     { \
+        SHAMAN_COUNT_OPERATION(function); \
         numberType result = std::functionName(n.number); \
-        preciseType preciseCorrectedResult = std::functionName(n.corrected_number()); \
-        preciseType totalError = preciseCorrectedResult - result; \
+        preciseType totalError = Shaman::detail::functionTotalError([](preciseType x) -> preciseType {return std::functionName(x);}, n, result); \
         return Snum(result, totalError); \
     }
 #endif
@@ -123,6 +173,7 @@ SHAMAN_FUNCTION(atan);
 // acos
 templated const Snum acos(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::acos(n.number);
 
     preciseType preciseCorrectedResult;
@@ -164,6 +215,7 @@ templated const Snum acos(const Snum& n)
 // asin
 templated const Snum asin(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::asin(n.number);
 
     preciseType preciseCorrectedResult;
@@ -205,6 +257,7 @@ templated const Snum asin(const Snum& n)
 // atan2
 templated const Snum atan2(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::atan2(n1.number, n2.number);
     preciseType preciseCorrectedResult = std::atan2(n1.corrected_number(), n2.corrected_number());
     preciseType totalError = preciseCorrectedResult - result;
@@ -267,6 +320,7 @@ SHAMAN_FUNCTION(asinh);
 // acosh
 templated const Snum acosh(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::acosh(n.number);
 
     preciseType preciseCorrectedResult;
@@ -304,6 +358,7 @@ templated const Snum acosh(const Snum& n)
 // atanh
 templated const Snum atanh(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::atanh(n.number);
 
     preciseType preciseCorrectedResult;
@@ -403,6 +458,7 @@ templated const Snum ldexp(const Snum& n, int exp)
 // log
 templated const Snum log(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::log(n.number);
 
     preciseType totalError;
@@ -449,6 +505,7 @@ templated const Snum log(const Snum& n)
 // log10
 templated const Snum log10(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::log10(n.number);
 
     preciseType totalError;
@@ -541,6 +598,7 @@ templated const Snum modf(const Snum& n, Snum* intpart)
 // log1p
 templated const Snum log1p(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::log1p(n.number);
 
     preciseType totalError;
@@ -587,6 +645,7 @@ templated const Snum log1p(const Snum& n)
 // log2
 templated const Snum log2(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::log2(n.number);
 
     preciseType totalError;
@@ -633,6 +692,7 @@ templated const Snum log2(const Snum& n)
 // logb
 templated const Snum logb(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::logb(n.number);
 
     preciseType totalError;
@@ -737,6 +797,7 @@ SHAMAN_FUNCTION(cbrt);
 // pow
 templated const Snum pow(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::pow(n1.number, n2.number);
     preciseType preciseCorrectedResult = std::pow(n1.corrected_number(), n2.corrected_number());
     preciseType totalError = preciseCorrectedResult - result;
@@ -792,6 +853,7 @@ set_Sfunction2_casts(pow);
 // sqrt
 templated const Snum sqrt(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::sqrt(n.number);
     errorType newError;
 
@@ -813,7 +875,7 @@ templated const Snum sqrt(const Snum& n)
             }
             else
             {
-                numberType remainder = EFT::RemainderSqrt(n.number, result);
+                auto remainder = EFT::RemainderSqrt(n.number, result);
                 newError = (remainder + n.error) / (result + result);
 
                 newErrorComp = Serror(n.errorComposants);
@@ -835,7 +897,7 @@ templated const Snum sqrt(const Snum& n)
         }
         else
         {
-            numberType remainder = EFT::RemainderSqrt(n.number, result);
+            auto remainder = EFT::RemainderSqrt(n.number, result);
             newError = (remainder + n.error) / (result + result);
         }
         return Snum(result, newError);
@@ -845,6 +907,7 @@ templated const Snum sqrt(const Snum& n)
 // hypot
 templated const Snum hypot(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::hypot(n1.number, n2.number);
     preciseType preciseCorrectedResult = std::hypot(n1.corrected_number(), n2.corrected_number());
     preciseType totalError = preciseCorrectedResult - result;
@@ -900,6 +963,7 @@ set_Sfunction2_casts(hypot);
 // hypot
 templated const Snum hypot(const Snum& n1, const Snum& n2, const Snum& n3)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::hypot(n1.number, n2.number, n3.number);
     preciseType preciseCorrectedResult = std::hypot(n1.corrected_number(), n2.corrected_number(), n3.corrected_number());
     preciseType totalError = preciseCorrectedResult - result;
@@ -1007,6 +1071,7 @@ SHAMAN_FUNCTION(nearbyint);
 // fmod
 templated const Snum fmod(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::fmod(n1.number, n2.number);
     preciseType preciseCorrectedResult = std::fmod(n1.corrected_number(), n2.corrected_number());
     preciseType totalError = preciseCorrectedResult - result;
@@ -1086,6 +1151,7 @@ templated inline const long long int llrint(const Snum& n)
 // remainder
 templated const Snum remainder(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::remainder(n1.number, n2.number);
     preciseType preciseCorrectedResult = std::remainder(n1.corrected_number(), n2.corrected_number());
     preciseType totalError = preciseCorrectedResult - result;
@@ -1141,6 +1207,7 @@ set_Sfunction2_casts(remainder);
 // remquo
 templated const Snum remquo(const Snum& n1, const Snum& n2, int* quot)
 {
+    SHAMAN_COUNT_OPERATION(function);
     int dummyquot;
     numberType result = std::remquo(n1.number, n2.number, quot);
     preciseType preciseCorrectedResult = std::remquo(n1.corrected_number(), n2.corrected_number(), &dummyquot);
@@ -1195,14 +1262,14 @@ templated const Snum remquo(const Snum& n1, const Snum& n2, int* quot)
 
 // remquo casts
 template<typename N, typename E, typename P, typename arithmeticTYPE(T)>
-inline auto remquo(const S<N,E,P>& n1, const T& n2, int* quot) -> SreturnType(n1.number,n2)
+inline auto remquo(const S<N,E,P>& n1, const T& n2, int* quot) -> SreturnTypeOf(n1,n2)
 {
-    return remquo(SreturnType(n1.number,n2)(n1), SreturnType(n1.number,n2)(n2), quot);
+    return remquo(SreturnTypeOf(n1,n2)(n1), SreturnTypeOf(n1,n2)(n2), quot);
 };
 template<typename N, typename E, typename P, typename arithmeticTYPE(T)>
-inline auto remquo(const T& n1, const S<N,E,P>& n2, int* quot) -> SreturnType(n1, n2.number)
+inline auto remquo(const T& n1, const S<N,E,P>& n2, int* quot) -> SreturnTypeOf(n2,n1)
 {
-    return remquo(SreturnType(n1,n2.number)(n1), SreturnType(n1,n2.number)(n2), quot);
+    return remquo(SreturnTypeOf(n2,n1)(n1), SreturnTypeOf(n2,n1)(n2), quot);
 };
 template<typename N1, typename E1, typename P1, typename N2, typename E2, typename P2>
 inline auto remquo(const S<N1,E1,P1>& n1, const S<N2,E2,P2>& n2, int* quot) -> SreturnType(n1.number, n2.number)
@@ -1215,7 +1282,7 @@ inline auto remquo(const S<N1,E1,P1>& n1, const S<N2,E2,P2>& n2, int* quot) -> S
 // copysign
 templated inline const Snum copysign(const Snum& n1, const Snum& n2)
 {
-    Snum::checkUnstableBranch(n2, Snum(typename Snum::NumberType(0.)));
+    Snum::checkUnstableBranch(n2.number, n2.error, numberType(0), errorType(0));
 
     numberType newNumber = std::copysign(n1.number, n2.number);
     if (std::signbit(newNumber) == std::signbit(n1.number))
@@ -1342,6 +1409,7 @@ set_Sfunction2_casts(nexttoward);
 // fdim
 templated inline const Snum fdim(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(function);
     Snum::checkUnstableBranch(n1, n2);
 
     numberType result = std::fdim(n1.number, n2.number);
@@ -1399,16 +1467,18 @@ set_Sfunction2_casts(fdim);
 // min
 templated inline const Snum min(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(comparison);
     Snum::checkUnstableBranch(n1, n2);
-    return std::min(n1,n2);
+    return (n2.number < n1.number) ? n2 : n1; // std::min without checking the comparison a second time
 };
 set_Sfunction2_casts(min);
 
 // max
 templated inline const Snum max(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(comparison);
     Snum::checkUnstableBranch(n1, n2);
-    return std::max(n1,n2);
+    return (n1.number < n2.number) ? n2 : n1; // std::max without checking the comparison a second time
 };
 set_Sfunction2_casts(max);
 
@@ -1431,7 +1501,7 @@ set_Sfunction2_casts(fmax);
 // abs
 templated inline const Snum abs(const Snum& n)
 {
-    Snum::checkUnstableBranch(n, Snum(typename Snum::NumberType(0.)));
+    Snum::checkUnstableBranch(n.number, n.error, numberType(0), errorType(0));
 
     if (std::signbit(n.number)) // <=> n.number < 0 (but safe for nan)
     {
@@ -1452,11 +1522,12 @@ templated inline const Snum fabs(const Snum& n)
 // fma
 templated const Snum fma(const Snum& n1, const Snum& n2, const Snum& n3)
 {
+    SHAMAN_COUNT_OPERATION(function);
     numberType result = std::fma(n1.number, n2.number, n3.number);
 
-    numberType remainder = EFT::ErrorFma(n1.number, n2.number, n3.number, result);
+    auto remainder = EFT::ErrorFma(n1.number, n2.number, n3.number, result);
     //errorType newError = remainder + (n1.number*n2.error + n2.number*n1.error) + n3.error;
-    errorType newError = std::fma(n2.number, n1.error, std::fma(n1.number, n2.error, remainder + n3.error));
+    auto newError = std::fma(n2.number, n1.error, std::fma(n1.number, n2.error, remainder + n3.error));
 
     #ifdef SHAMAN_TAGGED_ERROR
         numberType number1 = n1.number;
@@ -1507,7 +1578,7 @@ templated inline bool isnormal(const Snum &n)
 // signbit
 templated inline bool signbit(const Snum &n)
 {
-    Snum::checkUnstableBranch(n, Snum(typename Snum::NumberType(0.)));
+    Snum::checkUnstableBranch(n.number, n.error, numberType(0), errorType(0));
     return std::signbit(n.number);
 };
 
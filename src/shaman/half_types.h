@@ -0,0 +1,320 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+#include "eft.h"
+
+/*
+ * HALF PRECISION TYPES
+ *
+ * Shaman::half (IEEE binary16) and Shaman::bfloat16 are 16 bits storage types
+ * usable as the number type of a S (see Shalf and Sbfloat16).
+ *
+ * their arithmetic is done in float and rounded back to 16 bits,
+ * which is correctly rounded for +, -, *, / and sqrt since float has more than 2p+2 bits of mantissa
+ * (double rounding is innocuous, see Figueroa "When is double rounding innocuous?")
+ * the conversions use the native _Float16 type when the compiler provides it
+ * and a software implementation otherwise (or if SHAMAN_SOFTWARE_HALF is defined), so they work on CPUs without native half arithmetic
+ *
+ * mixed operations follow the usual promotion rules : half+half is a half, half+float is a float
+ */
+namespace Shaman
+{
+    namespace detail
+    {
+        inline std::uint32_t bitsOfFloat(float x)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &x, sizeof(float));
+            return bits;
+        }
+
+        inline float floatOfBits(std::uint32_t bits)
+        {
+            float x;
+            std::memcpy(&x, &bits, sizeof(float));
+            return x;
+        }
+
+        /*
+         * rounds x to a float using round-to-odd
+         * rounding the result again to a format with at most 22 bits of mantissa is then equivalent to a single rounding to nearest
+         * (this avoids the double rounding problems when converting a double into a half)
+         */
+        template<typename T>
+        inline float roundToOdd(T x)
+        {
+            float result = static_cast<float>(x);
+            if((static_cast<T>(result) != x) and std::isfinite(result))
+            {
+                // we want the truncation of x with a sticky bit
+                if(std::abs(static_cast<T>(result)) > std::abs(x))
+                {
+                    result = std::nextafter(result, 0.f);
+                }
+                result = floatOfBits(bitsOfFloat(result) | 1u);
+            }
+            return result;
+        }
+
+        /*
+         * IEEE binary16 : 1 sign bit, 5 exponent bits, 10 mantissa bits
+         * software conversions from "float_to_half_fast3_rtne" and "half_to_float" by Fabian Giesen
+         */
+        struct half_format
+        {
+            // numeric limits
+            static const int digits = 11;
+            static const int digits10 = 3;
+            static const int max_digits10 = 5;
+            static const int min_exponent = -13;
+            static const int min_exponent10 = -4;
+            static const int max_exponent = 16;
+            static const int max_exponent10 = 4;
+            static const std::uint16_t minBits = 0x0400u;
+            static const std::uint16_t maxBits = 0x7bffu;
+            static const std::uint16_t epsilonBits = 0x1400u;
+            static const std::uint16_t roundErrorBits = 0x3800u;
+            static const std::uint16_t infinityBits = 0x7c00u;
+            static const std::uint16_t quietNanBits = 0x7e00u;
+            static const std::uint16_t signalingNanBits = 0x7d00u;
+            static const std::uint16_t denormMinBits = 0x0001u;
+
+            static std::uint16_t fromFloat(float x)
+            {
+                #if defined(__FLT16_MANT_DIG__) && !defined(SHAMAN_SOFTWARE_HALF)
+                _Float16 result = static_cast<_Float16>(x);
+                std::uint16_t bits;
+                std::memcpy(&bits, &result, sizeof(bits));
+                return bits;
+                #else
+                const std::uint32_t f32infty = 255u << 23;
+                const std::uint32_t f16max = (127u + 16u) << 23;
+                const std::uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+                std::uint32_t bits = bitsOfFloat(x);
+                const std::uint32_t sign = bits & 0x80000000u;
+                bits ^= sign;
+
+                std::uint32_t result;
+                if(bits >= f16max) // inf or nan
+                {
+                    result = (bits > f32infty) ? 0x7e00u : 0x7c00u;
+                }
+                else if(bits < (113u << 23)) // subnormal or zero, the float addition does the rounding
+                {
+                    result = bitsOfFloat(floatOfBits(bits) + floatOfBits(denormMagic)) - denormMagic;
+                }
+                else // normal number, rounds to nearest even
+                {
+                    const std::uint32_t mantissaIsOdd = (bits >> 13) & 1u;
+                    bits += ((15u - 127u) << 23) + 0xfffu;
+                    bits += mantissaIsOdd;
+                    result = bits >> 13;
+                }
+                return static_cast<std::uint16_t>(result | (sign >> 16));
+                #endif
+            }
+
+            static float toFloat(std::uint16_t bits)
+            {
+                #if defined(__FLT16_MANT_DIG__) && !defined(SHAMAN_SOFTWARE_HALF)
+                _Float16 result;
+                std::memcpy(&result, &bits, sizeof(bits));
+                return static_cast<float>(result);
+                #else
+                const std::uint32_t shiftedExponent = 0x7c00u << 13;
+                std::uint32_t result = (bits & 0x7fffu) << 13;
+                const std::uint32_t exponent = shiftedExponent & result;
+                result += (127u - 15u) << 23;
+                if(exponent == shiftedExponent) // inf or nan
+                {
+                    result += (128u - 16u) << 23;
+                }
+                else if(exponent == 0) // zero or subnormal, renormalizes
+                {
+                    result += 1u << 23;
+                    result = bitsOfFloat(floatOfBits(result) - floatOfBits(113u << 23));
+                }
+                return floatOfBits(result | ((bits & 0x8000u) << 16));
+                #endif
+            }
+        };
+
+        /*
+         * bfloat16 : 1 sign bit, 8 exponent bits, 7 mantissa bits (the upper half of a float)
+         */
+        struct bfloat16_format
+        {
+            // numeric limits
+            static const int digits = 8;
+            static const int digits10 = 2;
+            static const int max_digits10 = 4;
+            static const int min_exponent = -125;
+            static const int min_exponent10 = -37;
+            static const int max_exponent = 128;
+            static const int max_exponent10 = 38;
+            static const std::uint16_t minBits = 0x0080u;
+            static const std::uint16_t maxBits = 0x7f7fu;
+            static const std::uint16_t epsilonBits = 0x3c00u;
+            static const std::uint16_t roundErrorBits = 0x3f00u;
+            static const std::uint16_t infinityBits = 0x7f80u;
+            static const std::uint16_t quietNanBits = 0x7fc0u;
+            static const std::uint16_t signalingNanBits = 0x7fa0u;
+            static const std::uint16_t denormMinBits = 0x0001u;
+
+            static std::uint16_t fromFloat(float x)
+            {
+                const std::uint32_t bits = bitsOfFloat(x);
+                if((bits & 0x7fffffffu) > 0x7f800000u) // nan, we keep it quiet
+                {
+                    return static_cast<std::uint16_t>((bits >> 16) | 0x40u);
+                }
+                // rounds to nearest even (overflows gracefully into infinity)
+                const std::uint32_t roundingBias = 0x7fffu + ((bits >> 16) & 1u);
+                return static_cast<std::uint16_t>((bits + roundingBias) >> 16);
+            }
+
+            static float toFloat(std::uint16_t bits)
+            {
+                return floatOfBits(static_cast<std::uint32_t>(bits) << 16);
+            }
+        };
+    }
+
+    /*
+     * a 16 bits floating point number whose encoding is described by Format
+     */
+    template<typename Format>
+    class small_float
+    {
+    public:
+        std::uint16_t bits; // encoding of the number
+
+        // constructors
+        inline constexpr small_float(): bits(0) {};
+        inline small_float(float x): bits(Format::fromFloat(x)) {};
+        inline small_float(double x): bits(Format::fromFloat(detail::roundToOdd(x))) {};
+        inline small_float(long double x): bits(Format::fromFloat(detail::roundToOdd(x))) {};
+        template<typename T, typename = typename std::enable_if<std::is_integral<T>::value, T>::type>
+        inline small_float(T x): small_float(static_cast<long double>(x)) {};
+        #ifdef __FLT16_MANT_DIG__
+        inline small_float(_Float16 x): small_float(static_cast<float>(x)) {};
+        inline explicit operator _Float16() const { return static_cast<_Float16>(static_cast<float>(*this)); };
+        #endif
+
+        // builds a number from its encoding
+        static inline constexpr small_float fromBits(std::uint16_t bits) { return small_float(bits, 0); };
+
+        // casting
+        inline operator float() const { return Format::toFloat(bits); };
+
+        // compound operators, computed in the type C++ would use for 'x op y'
+        template<typename T> inline small_float& operator+=(const T& x) { return *this = small_float(static_cast<float>(*this) + x); };
+        template<typename T> inline small_float& operator-=(const T& x) { return *this = small_float(static_cast<float>(*this) - x); };
+        template<typename T> inline small_float& operator*=(const T& x) { return *this = small_float(static_cast<float>(*this) * x); };
+        template<typename T> inline small_float& operator/=(const T& x) { return *this = small_float(static_cast<float>(*this) / x); };
+        inline small_float& operator++() { return *this += 1.f; };
+        inline small_float& operator--() { return *this -= 1.f; };
+        inline small_float operator++(int) { small_float old = *this; *this += 1.f; return old; };
+        inline small_float operator--(int) { small_float old = *this; *this -= 1.f; return old; };
+
+        // arithmetic operators
+        // NOTE they are templates so that they only apply to two small_float (mixed operations are done by the built-in operators)
+        template<typename T, typename = typename std::enable_if<std::is_same<T,small_float>::value, T>::type>
+        friend inline small_float operator+(const T& x, const T& y) { return small_float(static_cast<float>(x) + static_cast<float>(y)); };
+        template<typename T, typename = typename std::enable_if<std::is_same<T,small_float>::value, T>::type>
+        friend inline small_float operator-(const T& x, const T& y) { return small_float(static_cast<float>(x) - static_cast<float>(y)); };
+        template<typename T, typename = typename std::enable_if<std::is_same<T,small_float>::value, T>::type>
+        friend inline small_float operator*(const T& x, const T& y) { return small_float(static_cast<float>(x) * static_cast<float>(y)); };
+        template<typename T, typename = typename std::enable_if<std::is_same<T,small_float>::value, T>::type>
+        friend inline small_float operator/(const T& x, const T& y) { return small_float(static_cast<float>(x) / static_cast<float>(y)); };
+        template<typename T, typename = typename std::enable_if<std::is_same<T,small_float>::value, T>::type>
+        friend inline small_float operator-(const T& x) { return fromBits(x.bits ^ 0x8000u); };
+        template<typename T, typename = typename std::enable_if<std::is_same<T,small_float>::value, T>::type>
+        friend inline small_float operator+(const T& x) { return x; };
+
+    private:
+        inline constexpr small_float(std::uint16_t bitsArg, int): bits(bitsArg) {};
+    };
+
+    using half = small_float<detail::half_format>;
+    using bfloat16 = small_float<detail::bfloat16_format>;
+}
+
+//-----------------------------------------------------------------------------
+// ERROR FREE TRANSFORM
+
+/*
+ * the error of an operation between two small_float is computed in float, where it is exact (or nearly so for the sum)
+ * it is returned as a float as it might not be representable in the small format (underflow of the error)
+ */
+namespace EFT
+{
+    template<typename F>
+    inline float TwoSum(const Shaman::small_float<F> n1, const Shaman::small_float<F> n2, const Shaman::small_float<F> result)
+    {
+        // the float sum might be inexact, we add its own error
+        const float f1 = n1;
+        const float f2 = n2;
+        const float sum = f1 + f2;
+        return (sum - static_cast<float>(result)) + TwoSum(f1, f2, sum);
+    }
+
+    // the product of two small_float is exact in float
+    template<typename F>
+    inline float FastTwoProd(const Shaman::small_float<F> n1, const Shaman::small_float<F> n2, const Shaman::small_float<F> result)
+    {
+        return static_cast<float>(n1) * static_cast<float>(n2) - static_cast<float>(result);
+    }
+
+    template<typename F>
+    inline float RemainderDiv(const Shaman::small_float<F> n1, const Shaman::small_float<F> n2, const Shaman::small_float<F> result)
+    {
+        return -std::fma(static_cast<float>(n2), static_cast<float>(result), -static_cast<float>(n1));
+    }
+
+    template<typename F>
+    inline float RemainderSqrt(const Shaman::small_float<F> n, const Shaman::small_float<F> result)
+    {
+        return -std::fma(static_cast<float>(result), static_cast<float>(result), -static_cast<float>(n));
+    }
+
+    // the fma is computed in double, which is accurate enough to deduce a float error
+    template<typename F>
+    inline float ErrorFma(const Shaman::small_float<F> n1, const Shaman::small_float<F> n2, const Shaman::small_float<F> n3, const Shaman::small_float<F> result)
+    {
+        const double preciseResult = static_cast<double>(n1) * static_cast<double>(n2) + static_cast<double>(n3);
+        return static_cast<float>(preciseResult - static_cast<double>(result));
+    }
+}
+
+//-----------------------------------------------------------------------------
+// MATHEMATICAL FUNCTIONS
+
+/*
+ * most mathematical functions apply to the small_float through their implicit conversion to float
+ * the ones below cannot (they take a pointer or have no float overload in C++11)
+ */
+namespace std
+{
+    template<typename F>
+    inline Shaman::small_float<F> modf(const Shaman::small_float<F> x, Shaman::small_float<F>* intpart)
+    {
+        float floatIntpart;
+        const Shaman::small_float<F> result = std::modf(static_cast<float>(x), &floatIntpart);
+        *intpart = floatIntpart;
+        return result;
+    }
+
+    template<typename F>
+    inline Shaman::small_float<F> hypot(const Shaman::small_float<F> x, const Shaman::small_float<F> y, const Shaman::small_float<F> z)
+    {
+        const double dx = x;
+        const double dy = y;
+        const double dz = z;
+        return std::sqrt(dx*dx + dy*dy + dz*dz);
+    }
+}
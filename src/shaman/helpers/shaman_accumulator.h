@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+ * to use :
+ * - include shaman_accumulator.h
+ * - accumulate your numbers into a 'Shaman::simd_accumulator<Sdouble>' then get their sum with 'result'
+ *
+ * Shaman::simd_accumulator<Sdouble> sum;
+ * sum.add(values, size); // adds an array
+ * sum.add_terms(size, [&](std::size_t i){return x[i] * y[i];}); // adds the terms given by a function of the index
+ * Sdouble total = sum.result();
+ *
+ * The accumulator keeps laneNumber independent partial sums (the lanes), their numbers and errors being stored in separate arrays,
+ * the inner loops of add and add_terms update all the lanes at once and can be vectorized by the compiler as a sum of doubles would be
+ * (a '#pragma omp simd reduction' over a Sdouble is not : the compilers keep the private copies of a struct in arrays of structs).
+ * The gain is largest when the terms are computed (add_terms), an array of S interleaving its numbers and errors in memory.
+ * The lanes are folded into a single number once, by result.
+ *
+ * With OpenMP, the accumulators of the Shaman types can be reduced between threads :
+ *
+ * Shaman::simd_accumulator<Sdouble> sum;
+ * #pragma omp parallel for reduction(+:sum)
+ * for(std::size_t block = 0; block < blockNumber; block++) sum.add(values + block*blockSize, blockSize);
+ *
+ * NOTE: the order of the additions is not the sequential one, the number might thus differ slightly from the one of a sequential sum
+ * NOTE: with tagged error, the error composants are added one value at a time (the loops are not vectorized)
+ * and the rounding errors of the sum are attributed to the block that calls result
+ * NOTE: with SHAMAN_CANCELLATION, every addition into a lane and every fold of two lanes is recorded as a cancellation counter would record an operator+
+ * With NO_SHAMAN, the accumulator sums the numbers in the same lane-wise fashion.
+ */
+namespace Shaman
+{
+    /*
+     * sum of numbers split into laneNumber partial sums
+     */
+    template<typename T, std::size_t laneNumber = 8>
+    class simd_accumulator
+    {
+    public:
+        T partials[laneNumber];
+
+        simd_accumulator(): partials() {}
+
+        simd_accumulator& operator+=(const T& x)
+        {
+            partials[0] += x;
+            return *this;
+        }
+
+        simd_accumulator& operator+=(const simd_accumulator& other)
+        {
+            for(std::size_t lane = 0; lane < laneNumber; lane++) partials[lane] += other.partials[lane];
+            return *this;
+        }
+
+        void add(const T* values, std::size_t size)
+        {
+            add_terms(size, [values](std::size_t i){return values[i];});
+        }
+
+        template<typename Function>
+        void add_terms(std::size_t size, Function term)
+        {
+            std::size_t i = 0;
+            for(; i + laneNumber <= size; i += laneNumber)
+            {
+                for(std::size_t lane = 0; lane < laneNumber; lane++) partials[lane] += term(i + lane);
+            }
+            for(std::size_t lane = 0; (lane < laneNumber) and (i + lane < size); lane++) partials[lane] += term(i + lane);
+        }
+
+        T result() const
+        {
+            T sum = partials[0];
+            for(std::size_t lane = 1; lane < laneNumber; lane++) sum += partials[lane];
+            return sum;
+        }
+    };
+
+#ifndef NO_SHAMAN
+    /*
+     * sum of S numbers split into laneNumber partial sums
+     * each lane stores the sum of its numbers, the sum of the rounding errors of those additions and the sum of the errors of the numbers
+     */
+    template<typename numberType, typename errorType, typename preciseType, std::size_t laneNumber>
+    class simd_accumulator<S<numberType,errorType,preciseType>, laneNumber>
+    {
+    public:
+        numberType numbers[laneNumber];
+        numberType remainders[laneNumber];
+        errorType errors[laneNumber];
+        #ifdef SHAMAN_TAGGED_ERROR
+        error_composants<errorType> errorComposants; // composants of the errors of the numbers
+        #endif
+
+        simd_accumulator(): numbers(), remainders(), errors() {}
+
+        simd_accumulator& operator+=(const S<numberType,errorType,preciseType>& x)
+        {
+            addToLane(0, x);
+            countAdditions(1);
+            return *this;
+        }
+
+        simd_accumulator& operator+=(const simd_accumulator& other)
+        {
+            for(std::size_t lane = 0; lane < laneNumber; lane++)
+            {
+                const numberType sum = numbers[lane] + other.numbers[lane];
+                remainders[lane] += EFT::TwoSum(numbers[lane], other.numbers[lane], sum) + other.remainders[lane];
+                recordCancellation(numbers[lane], other.numbers[lane], sum);
+                errors[lane] += other.errors[lane];
+                numbers[lane] = sum;
+            }
+            #ifdef SHAMAN_TAGGED_ERROR
+            errorComposants.addErrors(other.errorComposants);
+            #endif
+            return *this;
+        }
+
+        void add(const S<numberType,errorType,preciseType>* values, std::size_t size)
+        {
+            add_terms(size, [values](std::size_t i) -> const S<numberType,errorType,preciseType>& {return values[i];});
+        }
+
+        template<typename Function>
+        void add_terms(std::size_t size, Function term)
+        {
+            std::size_t i = 0;
+            for(; i + laneNumber <= size; i += laneNumber)
+            {
+                for(std::size_t lane = 0; lane < laneNumber; lane++) addToLane(lane, term(i + lane));
+            }
+            for(std::size_t lane = 0; (lane < laneNumber) and (i + lane < size); lane++) addToLane(lane, term(i + lane));
+            countAdditions(size);
+        }
+
+        /*
+         * folds the lanes into a single number
+         */
+        S<numberType,errorType,preciseType> result() const
+        {
+            numberType number = numbers[0];
+            numberType remainder = remainders[0];
+            errorType error = errors[0];
+            for(std::size_t lane = 1; lane < laneNumber; lane++)
+            {
+                const numberType sum = number + numbers[lane];
+                remainder += EFT::TwoSum(number, numbers[lane], sum) + remainders[lane];
+                recordCancellation(number, numbers[lane], sum);
+                error += errors[lane];
+                number = sum;
+            }
+
+            #ifdef SHAMAN_TAGGED_ERROR
+            error_composants<errorType> newErrorComp = errorComposants;
+            newErrorComp.addError(remainder);
+            return S<numberType,errorType,preciseType>(number, remainder + error, newErrorComp);
+            #else
+            return S<numberType,errorType,preciseType>(number, remainder + error);
+            #endif
+        }
+
+    private:
+        inline void addToLane(std::size_t lane, const S<numberType,errorType,preciseType>& x)
+        {
+            const numberType sum = numbers[lane] + x.number;
+            remainders[lane] += EFT::TwoSum(numbers[lane], x.number, sum);
+            recordCancellation(numbers[lane], x.number, sum);
+            errors[lane] += x.error;
+            numbers[lane] = sum;
+            #ifdef SHAMAN_TAGGED_ERROR
+            errorComposants.addErrors(x.errorComposants);
+            #endif
+        }
+
+        // the cancellations are recorded as by operator+ (SHAMAN_CANCELLATION requires tagged error, whose loops are not vectorized anyway)
+        static inline void recordCancellation(numberType n1, numberType n2, numberType sum)
+        {
+            #ifdef SHAMAN_CANCELLATION
+            Shaman::recordCancellation(n1, n2, sum);
+            #else
+            (void)n1;
+            (void)n2;
+            (void)sum;
+            #endif
+        }
+
+        // the additions are counted outside of the loops to keep them vectorizable
+        static void countAdditions(std::size_t size)
+        {
+            #ifdef SHAMAN_OPERATION_COUNTERS
+            countOperation<S<numberType,errorType,preciseType>>(Operation::addition, size);
+            #else
+            (void)size;
+            #endif
+        }
+    };
+#endif //NO_SHAMAN
+}
+
+// Requires openMP 4.0+ to get reductions on user defined types
+#if defined(_OPENMP)
+#pragma omp declare reduction(+:Shaman::simd_accumulator<Sfloat> : omp_out += omp_in)             initializer(omp_priv=Shaman::simd_accumulator<Sfloat>())
+#pragma omp declare reduction(+:Shaman::simd_accumulator<Sdouble> : omp_out += omp_in)            initializer(omp_priv=Shaman::simd_accumulator<Sdouble>())
+#pragma omp declare reduction(+:Shaman::simd_accumulator<Slong_double> : omp_out += omp_in)       initializer(omp_priv=Shaman::simd_accumulator<Slong_double>())
+#ifndef NO_SHAMAN // Sdouble_compact is a double
+#pragma omp declare reduction(+:Shaman::simd_accumulator<Sdouble_compact> : omp_out += omp_in)    initializer(omp_priv=Shaman::simd_accumulator<Sdouble_compact>())
+#endif
+#endif //_OPENMP
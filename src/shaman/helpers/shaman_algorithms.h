@@ -0,0 +1,340 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <iterator>
+#include <exception>
+#include <functional>
+#include <type_traits>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__has_include)
+#if __has_include(<execution>)
+#include <execution>
+#ifdef __cpp_lib_execution // the header might exist but be empty before C++17
+#define SHAMAN_STD_EXECUTION
+#endif
+#endif
+#endif
+
+/*
+ * to use :
+ * - include shaman_algorithms.h
+ * - call 'Shaman::reduce', 'Shaman::transform_reduce', 'Shaman::inclusive_scan' or 'Shaman::dot'
+ *   with an execution policy ('Shaman::execution::par' or, when the standard library provides them, 'std::execution::par')
+ *
+ * The range is cut into one contiguous chunk per thread (OpenMP threads if OpenMP is enabled, std::thread otherwise).
+ * Each thread accumulates its chunk with the S operators, its partial thus carries the error of its own operations,
+ * and the partials are combined in chunk order at the end.
+ * The result does not depend on the scheduling of the threads but it does depend on their number
+ * (see shaman_reproducible.h for sums that are independent of the number of threads).
+ */
+namespace Shaman
+{
+    //-------------------------------------------------------------------------------------------------
+    // EXECUTION POLICIES
+
+    namespace execution
+    {
+        struct sequenced_policy {};
+        struct parallel_policy {};
+        struct parallel_unsequenced_policy {};
+
+        constexpr sequenced_policy seq{};
+        constexpr parallel_policy par{};
+        constexpr parallel_unsequenced_policy par_unseq{};
+
+        /*
+         * true if the policy allows us to run on several threads
+         */
+        template<typename Policy> struct is_parallel : std::false_type {};
+        template<> struct is_parallel<parallel_policy> : std::true_type {};
+        template<> struct is_parallel<parallel_unsequenced_policy> : std::true_type {};
+#ifdef SHAMAN_STD_EXECUTION
+        template<> struct is_parallel<std::execution::parallel_policy> : std::true_type {};
+        template<> struct is_parallel<std::execution::parallel_unsequenced_policy> : std::true_type {};
+#endif
+    }
+
+    namespace detail
+    {
+        template<typename Policy>
+        using policyIsParallel = execution::is_parallel<typename std::decay<Policy>::type>;
+
+        /*
+         * number of threads used by the parallel algorithms
+         */
+        inline std::size_t threadNumber()
+        {
+            #ifdef _OPENMP
+            return static_cast<std::size_t>(omp_get_max_threads());
+            #else
+            const std::size_t hardwareThreads = std::thread::hardware_concurrency();
+            return (hardwareThreads == 0) ? 1 : hardwareThreads;
+            #endif
+        }
+
+        /*
+         * runs function(chunk, begin, end) on each of the chunkNumber contiguous chunks of [0;size[
+         * the chunks are processed in parallel
+         * the current block (when using tagged error) is forwarded to the worker threads
+         * the first exception thrown by a chunk is rethrown in the calling thread
+         */
+        template<typename FUN>
+        void forEachChunk(std::size_t size, std::size_t chunkNumber, FUN function)
+        {
+            #ifdef SHAMAN_TAGGED_ERROR
+            const Tag tag = CodeBlock::currentBlock();
+            #endif
+            std::vector<std::exception_ptr> exceptions(chunkNumber);
+
+            auto runChunk = [&](std::size_t chunk)
+            {
+                try
+                {
+                    #ifdef SHAMAN_TAGGED_ERROR
+                    CodeBlock block(tag);
+                    #endif
+                    function(chunk, (size*chunk)/chunkNumber, (size*(chunk+1))/chunkNumber);
+                }
+                catch(...)
+                {
+                    exceptions[chunk] = std::current_exception();
+                }
+            };
+
+            #ifdef _OPENMP
+            #pragma omp parallel for schedule(static,1) num_threads(chunkNumber)
+            for(long chunk = 0; chunk < static_cast<long>(chunkNumber); chunk++)
+            {
+                runChunk(static_cast<std::size_t>(chunk));
+            }
+            #else
+            std::vector<std::thread> workers;
+            workers.reserve(chunkNumber-1);
+            for(std::size_t chunk = 1; chunk < chunkNumber; chunk++)
+            {
+                workers.emplace_back(runChunk, chunk);
+            }
+            runChunk(0);
+            for(auto& worker : workers)
+            {
+                worker.join();
+            }
+            #endif
+
+            for(auto& exception : exceptions)
+            {
+                if(exception)
+                {
+                    std::rethrow_exception(exception);
+                }
+            }
+        }
+
+        /*
+         * number of chunks into which a range of the given size will be cut
+         */
+        template<typename Policy>
+        inline std::size_t chunkNumber(std::size_t size)
+        {
+            if(not policyIsParallel<Policy>::value) return std::min<std::size_t>(size, 1);
+            return std::min(size, threadNumber());
+        }
+
+        /*
+         * computes partials[chunk] = reduceChunk(begin, end) for each chunk
+         */
+        template<typename Policy, typename T, typename FUN>
+        std::vector<T> chunkPartials(std::size_t size, FUN reduceChunk)
+        {
+            const std::size_t chunks = chunkNumber<Policy>(size);
+            std::vector<T> partials(chunks);
+
+            forEachChunk(size, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end)
+            {
+                partials[chunk] = reduceChunk(begin, end);
+            });
+
+            return partials;
+        }
+
+        /*
+         * init reduceOp partial0 reduceOp partial1 ...
+         */
+        template<typename T, typename ReduceOp>
+        T combinePartials(T init, const std::vector<T>& partials, ReduceOp reduceOp)
+        {
+            T result = init;
+            for(const T& partial : partials)
+            {
+                result = reduceOp(result, partial);
+            }
+            return result;
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+    // REDUCTIONS
+
+    /*
+     * init reduceOp transformOp(x0) reduceOp transformOp(x1) ...
+     * reduceOp is supposed associative and commutative (as it is for std::transform_reduce)
+     */
+    template<typename Policy, typename InputIt, typename T, typename ReduceOp, typename TransformOp>
+    T transform_reduce(Policy&&, InputIt first, InputIt last, T init, ReduceOp reduceOp, TransformOp transformOp)
+    {
+        const std::size_t size = std::distance(first, last);
+        std::vector<T> partials = detail::chunkPartials<Policy, T>(size, [&](std::size_t begin, std::size_t end)
+        {
+            InputIt it = std::next(first, begin);
+            T partial = transformOp(*it);
+            for(std::size_t i = begin+1; i < end; i++)
+            {
+                ++it;
+                partial = reduceOp(partial, transformOp(*it));
+            }
+            return partial;
+        });
+        return detail::combinePartials(init, partials, reduceOp);
+    }
+
+    /*
+     * init reduceOp transformOp(x0,y0) reduceOp transformOp(x1,y1) ...
+     */
+    template<typename Policy, typename InputIt1, typename InputIt2, typename T, typename ReduceOp, typename TransformOp>
+    T transform_reduce(Policy&&, InputIt1 first1, InputIt1 last1, InputIt2 first2, T init, ReduceOp reduceOp, TransformOp transformOp)
+    {
+        const std::size_t size = std::distance(first1, last1);
+        std::vector<T> partials = detail::chunkPartials<Policy, T>(size, [&](std::size_t begin, std::size_t end)
+        {
+            InputIt1 it1 = std::next(first1, begin);
+            InputIt2 it2 = std::next(first2, begin);
+            T partial = transformOp(*it1, *it2);
+            for(std::size_t i = begin+1; i < end; i++)
+            {
+                ++it1; ++it2;
+                partial = reduceOp(partial, transformOp(*it1, *it2));
+            }
+            return partial;
+        });
+        return detail::combinePartials(init, partials, reduceOp);
+    }
+
+    /*
+     * init + x0*y0 + x1*y1 + ...
+     */
+    template<typename Policy, typename InputIt1, typename InputIt2, typename T>
+    T transform_reduce(Policy&& policy, InputIt1 first1, InputIt1 last1, InputIt2 first2, T init)
+    {
+        using T1 = typename std::iterator_traits<InputIt1>::value_type;
+        using T2 = typename std::iterator_traits<InputIt2>::value_type;
+        return Shaman::transform_reduce(std::forward<Policy>(policy), first1, last1, first2, init,
+                                [](const T& x, const T& y){return x + y;},
+                                [](const T1& x, const T2& y){return x * y;});
+    }
+
+    /*
+     * init op x0 op x1 ...
+     */
+    template<typename Policy, typename InputIt, typename T, typename BinaryOp>
+    T reduce(Policy&& policy, InputIt first, InputIt last, T init, BinaryOp op)
+    {
+        using Tin = typename std::iterator_traits<InputIt>::value_type;
+        return Shaman::transform_reduce(std::forward<Policy>(policy), first, last, init, op, [](const Tin& x){return x;});
+    }
+
+    /*
+     * init + x0 + x1 + ...
+     */
+    template<typename Policy, typename InputIt, typename T>
+    T reduce(Policy&& policy, InputIt first, InputIt last, T init)
+    {
+        return Shaman::reduce(std::forward<Policy>(policy), first, last, init, [](const T& x, const T& y){return x + y;});
+    }
+
+    /*
+     * x0 + x1 + ...
+     */
+    template<typename Policy, typename InputIt>
+    typename std::iterator_traits<InputIt>::value_type reduce(Policy&& policy, InputIt first, InputIt last)
+    {
+        using T = typename std::iterator_traits<InputIt>::value_type;
+        return Shaman::reduce(std::forward<Policy>(policy), first, last, T());
+    }
+
+    /*
+     * x0*y0 + x1*y1 + ...
+     */
+    template<typename Policy, typename InputIt1, typename InputIt2>
+    auto dot(Policy&& policy, InputIt1 first1, InputIt1 last1, InputIt2 first2) -> decltype((*first1) * (*first2))
+    {
+        using T = decltype((*first1) * (*first2));
+        return Shaman::transform_reduce(std::forward<Policy>(policy), first1, last1, first2, T());
+    }
+
+    //-------------------------------------------------------------------------------------------------
+    // SCAN
+
+    /*
+     * d_first[i] = x0 op x1 op ... op xi
+     * runs in three passes : the chunks are reduced in parallel, their partials are scanned sequentially
+     * and each chunk is then scanned in parallel starting from the partial of the previous chunks
+     */
+    template<typename Policy, typename InputIt, typename OutputIt, typename BinaryOp>
+    OutputIt inclusive_scan(Policy&&, InputIt first, InputIt last, OutputIt d_first, BinaryOp op)
+    {
+        using T = typename std::iterator_traits<InputIt>::value_type;
+        const std::size_t size = std::distance(first, last);
+        if(size == 0) return d_first;
+
+        // reduces each chunk
+        std::vector<T> offsets = detail::chunkPartials<Policy, T>(size, [&](std::size_t begin, std::size_t end)
+        {
+            InputIt it = std::next(first, begin);
+            T partial = *it;
+            for(std::size_t i = begin+1; i < end; i++)
+            {
+                ++it;
+                partial = op(partial, *it);
+            }
+            return partial;
+        });
+        const std::size_t chunks = offsets.size();
+
+        // offsets[chunk] = sum of the previous chunks
+        for(std::size_t chunk = 1; chunk < chunks; chunk++)
+        {
+            offsets[chunk] = op(offsets[chunk-1], offsets[chunk]);
+        }
+
+        detail::forEachChunk(size, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end)
+        {
+            InputIt it = std::next(first, begin);
+            OutputIt out = std::next(d_first, begin);
+            T partial = (chunk == 0) ? *it : op(offsets[chunk-1], *it);
+            *out = partial;
+            for(std::size_t i = begin+1; i < end; i++)
+            {
+                ++it; ++out;
+                partial = op(partial, *it);
+                *out = partial;
+            }
+        });
+
+        return std::next(d_first, size);
+    }
+
+    /*
+     * d_first[i] = x0 + x1 + ... + xi
+     */
+    template<typename Policy, typename InputIt, typename OutputIt>
+    OutputIt inclusive_scan(Policy&& policy, InputIt first, InputIt last, OutputIt d_first)
+    {
+        using T = typename std::iterator_traits<InputIt>::value_type;
+        return Shaman::inclusive_scan(std::forward<Policy>(policy), first, last, d_first, [](const T& x, const T& y){return x + y;});
+    }
+}
@@ -0,0 +1,639 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+/*
+ * to use :
+ * - include shaman_batch.h
+ * - apply an elementary function to a whole array at once
+ *
+ * Sstd::exp(input, output); // ranges providing data() and size() (std::vector, std::array, ...)
+ * Sstd::log(input.data(), output.data(), size); // pointers
+ * Sstd::pow(x, y, output); // y is either a range or a single number
+ *
+ * The functions available are exp, log, sin, cos and pow.
+ * The output can be the input (the function is then applied in place) but the ranges must not overlap otherwise.
+ *
+ * For the types storing their number in a float or a double (Sfloat, Sdouble, Sdouble_compact),
+ * the numbers are computed by branch-free double-double kernels that the compiler vectorizes (compile with -O3 and -mfma)
+ * and that also give the rounding error of each result, the error of the input is then propagated to the first order
+ * with the derivative of the function (as tagged error does for the error composants of the scalar functions).
+ * The other types, and the inputs outside of the domain of the kernels (overflow, subnormal numbers, |x| > 2^20 for sin and cos...),
+ * go through the scalar functions of Sstd (as do all the inputs when compiling with -ffast-math, see has_batch_kernels).
+ * NOTE: the kernels are more accurate than the libm, a number might thus differ by one ulp from the one given by the scalar function
+ *
+ * With NO_SHAMAN, Sstd is std, use Shaman::batch::exp, ... (which work in both cases) in code that must also compile without Shaman.
+ */
+namespace Shaman
+{
+    namespace detail
+    {
+        //---------------------------------------------------------------------
+        // DOUBLE-DOUBLE ARITHMETIC
+
+        // unevaluated sum hi + lo, with |lo| <= ulp(hi)/2
+        struct DoubleDouble
+        {
+            double hi;
+            double lo;
+        };
+
+        inline DoubleDouble ddTwoSum(double n1, double n2)
+        {
+            const double sum = n1 + n2;
+            return {sum, EFT::TwoSum(n1, n2, sum)};
+        }
+
+        // requires |n1| >= |n2|
+        inline DoubleDouble ddFastTwoSum(double n1, double n2)
+        {
+            const double sum = n1 + n2;
+            return {sum, EFT::FastTwoSum(n1, n2, sum)};
+        }
+
+        inline DoubleDouble ddTwoProd(double n1, double n2)
+        {
+            const double product = n1 * n2;
+            return {product, EFT::FastTwoProd(n1, n2, product)};
+        }
+
+        // NOTE: loses accuracy if the numbers cancel each other
+        inline DoubleDouble ddAdd(const DoubleDouble& n1, const DoubleDouble& n2)
+        {
+            const DoubleDouble sum = ddTwoSum(n1.hi, n2.hi);
+            return ddFastTwoSum(sum.hi, sum.lo + (n1.lo + n2.lo));
+        }
+
+        inline DoubleDouble ddAdd(const DoubleDouble& n1, double n2)
+        {
+            const DoubleDouble sum = ddTwoSum(n1.hi, n2);
+            return ddFastTwoSum(sum.hi, sum.lo + n1.lo);
+        }
+
+        inline DoubleDouble ddMul(const DoubleDouble& n1, const DoubleDouble& n2)
+        {
+            const DoubleDouble product = ddTwoProd(n1.hi, n2.hi);
+            return ddFastTwoSum(product.hi, product.lo + (n1.hi * n2.lo + n1.lo * n2.hi));
+        }
+
+        inline DoubleDouble ddMul(const DoubleDouble& n1, double n2)
+        {
+            const DoubleDouble product = ddTwoProd(n1.hi, n2);
+            return ddFastTwoSum(product.hi, product.lo + n1.lo * n2);
+        }
+
+        inline DoubleDouble ddDiv(const DoubleDouble& n1, const DoubleDouble& n2)
+        {
+            const double quotient = n1.hi / n2.hi;
+            const DoubleDouble product = ddTwoProd(quotient, n2.hi);
+            const double remainder = ((n1.hi - product.hi) - product.lo) + (n1.lo - quotient * n2.lo);
+            return ddFastTwoSum(quotient, remainder / n2.hi);
+        }
+
+        /*
+         * divides by a small integer
+         * uses a multiplication by its inverse (a constant once the loops of the kernels are unrolled) rather than a division
+         * the remainder is exact as long as the quotient is within a few ulps of the true quotient
+         */
+        inline DoubleDouble ddDivInteger(const DoubleDouble& n, int divisor)
+        {
+            const double inverse = 1. / divisor;
+            const double quotient = n.hi * inverse;
+            const double remainder = EFT::detail::fma(-quotient, double(divisor), n.hi);
+            return ddFastTwoSum(quotient, (remainder + n.lo) * inverse);
+        }
+
+        //---------------------------------------------------------------------
+        // BIT MANIPULATIONS
+
+        inline std::uint64_t bitsOfDouble(double x)
+        {
+            std::uint64_t bits;
+            std::memcpy(&bits, &x, sizeof(double));
+            return bits;
+        }
+
+        inline double doubleOfBits(std::uint64_t bits)
+        {
+            double x;
+            std::memcpy(&x, &bits, sizeof(double));
+            return x;
+        }
+
+        // true if x is neither infinite nor nan (unlike std::isfinite, this is not optimized away by -ffast-math)
+        inline bool isFiniteBits(double x)
+        {
+            const std::uint64_t exponentMask = std::uint64_t(0x7ff) << 52;
+            return (bitsOfDouble(x) & exponentMask) != exponentMask;
+        }
+
+        // returns (x1 where mask is set, x2 elsewhere) with the sign bit flipped by sign
+        inline double selectBits(std::uint64_t mask, double x1, double x2, std::uint64_t sign)
+        {
+            return doubleOfBits(((bitsOfDouble(x1) & mask) | (bitsOfDouble(x2) & ~mask)) ^ sign);
+        }
+
+        /*
+         * the low bits of k + roundingShift are the integer k, in two's complement (for an integer |k| < 2^51)
+         */
+        const double roundingShift = 6755399441055744.; // 1.5*2^52
+        const std::uint64_t roundingShiftBits = std::uint64_t(0x4338) << 48;
+
+        //---------------------------------------------------------------------
+        // KERNELS
+
+// the kernels must be inlined, and their loops unrolled, before the vectorization of the loop calling them
+#if defined(__GNUC__) // also defined by clang
+#define SHAMAN_KERNEL inline __attribute__((always_inline))
+#else
+#define SHAMAN_KERNEL inline
+#endif
+#if defined(__clang__)
+#define SHAMAN_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#define SHAMAN_UNROLL _Pragma("GCC unroll 32")
+#else
+#define SHAMAN_UNROLL
+#endif
+
+        const double log2e = 1.4426950408889634;
+        const double ln2High = 0.6931471805599453;
+        const double ln2Low = 2.3190468138462996e-17;
+        const double twoOverPi = 0.6366197723675814;
+        const double pio2High = 1.5707963267948966;
+        const double pio2Middle = 6.123233995736766e-17;
+        const double pio2Low = -1.4973849048591698e-33;
+        const DoubleDouble inverseOf3 = {0.3333333333333333, 1.850371707708594e-17};
+        const DoubleDouble inverseOf5 = {0.2, -1.1102230246251566e-17};
+        const DoubleDouble inverseOf7 = {0.14285714285714285, 7.93016446160826e-18};
+
+        // the kernels below are accurate to about 2^-75 (the rounding error of a double is thus known to a few digits)
+        const double expMinimum = -650.; // the low part of the result stays a normal number
+        const double expMaximum = 709.; // the result does not overflow
+        const double sinCosMaximum = 1048576.; // 2^20, the three parts of pi/2 are enough for the range reduction
+
+        /*
+         * exp(x) for expMinimum <= x <= expMaximum
+         */
+        SHAMAN_KERNEL DoubleDouble ddExp(const DoubleDouble& x)
+        {
+            // x = k*ln(2) + r with |r| <= ln(2)/2
+            const double k = std::nearbyint(x.hi * log2e);
+            const DoubleDouble kLn2 = ddTwoProd(k, ln2High);
+            DoubleDouble r = ddTwoSum(x.hi, -kLn2.hi);
+            r = ddTwoSum(r.hi, r.lo + ((x.lo - kLn2.lo) - k * ln2Low));
+
+            // exp(r) = 1 + r(1 + r/2(1 + r/3(...))), the last terms are small enough to be evaluated in double precision
+            double tail = 1.;
+            SHAMAN_UNROLL
+            for(int n = 20; n > 8; n--) tail = 1. + r.hi * tail * (1. / n);
+            DoubleDouble result = {tail, 0.};
+            SHAMAN_UNROLL
+            for(int n = 8; n > 0; n--) result = ddAdd(ddDivInteger(ddMul(r, result), n), 1.);
+
+            // exp(x) = 2^k exp(r), the exponent of 2^k is built from the bits of k
+            const double scale = doubleOfBits((bitsOfDouble(k + roundingShift) + 1023) << 52);
+            return {result.hi * scale, result.lo * scale};
+        }
+
+        /*
+         * log(x) for a positive normal x
+         */
+        SHAMAN_KERNEL DoubleDouble ddLog(double x)
+        {
+            // x = 2^k z with sqrt(1/2) <= z < sqrt(2)
+            const std::uint64_t sqrtHalfBits = 0x3fe6a09e667f3bcdULL;
+            const std::uint64_t one = std::uint64_t(1023) << 52;
+            const std::uint64_t bits = bitsOfDouble(x);
+            const std::uint64_t exponent = (bits - sqrtHalfBits + one) >> 52; // k + 1023
+            const double z = doubleOfBits(bits - (exponent << 52) + one);
+            const double k = (doubleOfBits(roundingShiftBits + exponent) - roundingShift) - 1023.;
+
+            // log(z) = 2 atanh(s) = 2s(1 + s^2/3 + s^4/5 + ...) with s = (z-1)/(z+1) and |s| <= 0.172
+            const DoubleDouble s = ddDiv(DoubleDouble{z - 1., 0.}, ddTwoSum(z, 1.));
+            const DoubleDouble s2 = ddMul(s, s);
+            double tail = 1. / 33.;
+            SHAMAN_UNROLL
+            for(int n = 15; n > 3; n--) tail = 1. / (2*n + 1) + s2.hi * tail;
+            DoubleDouble series = ddAdd(ddMul(s2, tail), inverseOf7);
+            series = ddAdd(ddMul(s2, series), inverseOf5);
+            series = ddAdd(ddMul(s2, series), inverseOf3);
+            series = ddAdd(ddMul(s2, series), 1.);
+            const DoubleDouble logZ = ddMul(s, series);
+
+            // log(x) = k log(2) + log(z)
+            const DoubleDouble kLn2 = ddAdd(ddTwoProd(k, ln2High), k * ln2Low);
+            return ddAdd(kLn2, DoubleDouble{2. * logZ.hi, 2. * logZ.lo});
+        }
+
+        /*
+         * sin(x) and cos(x) for |x| <= sinCosMaximum
+         */
+        SHAMAN_KERNEL void ddSinCos(double x, DoubleDouble& sine, DoubleDouble& cosine)
+        {
+            // x = q pi/2 + r with |r| <= pi/4, pi/2 is split in three parts to keep r accurate when x is close to a multiple of pi/2
+            const double q = std::nearbyint(x * twoOverPi);
+            const DoubleDouble qPio2High = ddTwoProd(q, pio2High);
+            const DoubleDouble qPio2Middle = ddTwoProd(q, pio2Middle);
+            DoubleDouble r = ddTwoSum(x, -qPio2High.hi);
+            r = ddAdd(r, -qPio2High.lo);
+            r = ddAdd(r, DoubleDouble{-qPio2Middle.hi, -qPio2Middle.lo});
+            r = ddAdd(r, -q * pio2Low);
+
+            // sin(r) = r(1 - r^2/(2*3)(1 - r^2/(4*5)(...))) and cos(r) = 1 - r^2/(1*2)(1 - r^2/(3*4)(...))
+            const DoubleDouble r2 = ddMul(r, r);
+            double sineTail = 1.;
+            double cosineTail = 1.;
+            SHAMAN_UNROLL
+            for(int n = 12; n > 5; n--)
+            {
+                sineTail = 1. - r2.hi * sineTail * (1. / ((2*n) * (2*n + 1)));
+                cosineTail = 1. - r2.hi * cosineTail * (1. / ((2*n - 1) * (2*n)));
+            }
+            DoubleDouble sineR = {sineTail, 0.};
+            DoubleDouble cosineR = {cosineTail, 0.};
+            SHAMAN_UNROLL
+            for(int n = 5; n > 0; n--)
+            {
+                sineR = ddAdd(ddDivInteger(ddMul(r2, sineR), -(2*n) * (2*n + 1)), 1.);
+                cosineR = ddAdd(ddDivInteger(ddMul(r2, cosineR), -(2*n - 1) * (2*n)), 1.);
+            }
+            sineR = ddMul(r, sineR);
+
+            // the quadrant is q modulo 4
+            // the results are selected with masks since the compiler would otherwise move the unused series behind a branch
+            const std::uint64_t quadrant = bitsOfDouble(q + roundingShift) & 3;
+            const std::uint64_t swapMask = std::uint64_t(0) - (quadrant & 1);
+            const std::uint64_t sineSign = (quadrant & 2) << 62;
+            const std::uint64_t cosineSign = ((quadrant + 1) & 2) << 62;
+            sine = {selectBits(swapMask, cosineR.hi, sineR.hi, sineSign), selectBits(swapMask, cosineR.lo, sineR.lo, sineSign)};
+            cosine = {selectBits(swapMask, sineR.hi, cosineR.hi, cosineSign), selectBits(swapMask, sineR.lo, cosineR.lo, cosineSign)};
+        }
+
+#undef SHAMAN_UNROLL
+
+        /*
+         * result of a kernel : f(x) and its partial derivatives
+         * valid is false when the input is outside of the domain of the kernel (the scalar function is then used)
+         * NOTE: the conditions are combined with & rather than 'and' which would introduce a branch and prevent the vectorization
+         */
+        struct BatchResult
+        {
+            DoubleDouble value;
+            double derivative1;
+            double derivative2;
+            bool valid;
+        };
+
+        struct BatchExp
+        {
+            SHAMAN_KERNEL BatchResult operator()(double x) const
+            {
+                const DoubleDouble value = ddExp(DoubleDouble{x, 0.});
+                const bool valid = (x >= expMinimum) & (x <= expMaximum);
+                return {value, value.hi, 0., valid};
+            }
+        };
+
+        struct BatchLog
+        {
+            SHAMAN_KERNEL BatchResult operator()(double x) const
+            {
+                const DoubleDouble value = ddLog(x);
+                const bool valid = (x >= std::numeric_limits<double>::min()) & (x <= std::numeric_limits<double>::max());
+                return {value, 1. / x, 0., valid};
+            }
+        };
+
+        struct BatchSin
+        {
+            SHAMAN_KERNEL BatchResult operator()(double x) const
+            {
+                DoubleDouble sine, cosine;
+                ddSinCos(x, sine, cosine);
+                return {sine, cosine.hi, 0., std::abs(x) <= sinCosMaximum};
+            }
+        };
+
+        struct BatchCos
+        {
+            SHAMAN_KERNEL BatchResult operator()(double x) const
+            {
+                DoubleDouble sine, cosine;
+                ddSinCos(x, sine, cosine);
+                return {cosine, -sine.hi, 0., std::abs(x) <= sinCosMaximum};
+            }
+        };
+
+        // pow(x,y) = exp(y log(x)) for a positive x
+        struct BatchPow
+        {
+            SHAMAN_KERNEL BatchResult operator()(double x, double y) const
+            {
+                const DoubleDouble logX = ddLog(x);
+                const DoubleDouble exponent = ddMul(logX, y);
+                const DoubleDouble value = ddExp(exponent);
+                const bool valid = (x >= std::numeric_limits<double>::min()) & (x <= std::numeric_limits<double>::max())
+                                   & (exponent.hi >= expMinimum) & (exponent.hi <= expMaximum);
+                return {value, y * value.hi / x, value.hi * logX.hi, valid};
+            }
+        };
+
+#undef SHAMAN_KERNEL
+
+        //---------------------------------------------------------------------
+        // DRIVERS
+
+        // number of elements processed by each pass of a driver (the buffers stay in the L1 cache)
+        const std::size_t batchChunkSize = 128;
+
+        /*
+         * true if the kernels can compute the numbers of the type
+         * NOTE: when reassociation is allowed (-ffast-math), gcc drops the barriers of the error-free transformations from vectorized loops
+         * the kernels would thus lose their rounding errors (or be slower than the scalar functions once kept scalar), they are disabled
+         */
+#if defined(__ASSOCIATIVE_MATH__) || defined(__FAST_MATH__)
+        template<typename numberType>
+        struct has_batch_kernels : std::false_type {};
+#else
+        template<typename numberType>
+        struct has_batch_kernels : std::integral_constant<bool, std::is_same<numberType,float>::value or std::is_same<numberType,double>::value> {};
+#endif
+
+        // makes a parameter non deducible (its type is deduced from the other parameters)
+        template<typename T>
+        struct batch_identity { using type = T; };
+
+        inline void checkBatchSizes(std::size_t inputSize, std::size_t outputSize, const char* functionName)
+        {
+            if(outputSize < inputSize)
+            {
+                throw std::invalid_argument(std::string("Sstd::") + functionName + ": the output is smaller than the input.");
+            }
+        }
+
+#ifndef NO_SHAMAN
+        /*
+         * builds the output of a kernel from its input, its result, the rounding error of the result and the derivative
+         */
+        template<typename numberType, typename errorType, typename preciseType>
+        inline S<numberType,errorType,preciseType> batchOutput(const S<numberType,errorType,preciseType>& n, numberType result, double functionError, double derivative)
+        {
+            #ifdef SHAMAN_OPERATION_COUNTERS
+            countOperation<S<numberType,errorType,preciseType>>(Operation::function);
+            #endif
+            const double totalError = functionError + derivative * double(n.error);
+            #ifdef SHAMAN_TAGGED_ERROR
+            error_composants<errorType> newErrorComp;
+            if(n.error == 0)
+            {
+                newErrorComp = error_composants<errorType>(errorType(totalError));
+            }
+            else
+            {
+                newErrorComp = error_composants<errorType>(n.errorComposants, [derivative](errorType e){return e*derivative;});
+                newErrorComp.addError(functionError);
+            }
+            return S<numberType,errorType,preciseType>(result, totalError, newErrorComp);
+            #else
+            return S<numberType,errorType,preciseType>(result, totalError);
+            #endif
+        }
+
+        template<typename numberType, typename errorType, typename preciseType>
+        inline S<numberType,errorType,preciseType> batchOutput(const S<numberType,errorType,preciseType>& n1, const S<numberType,errorType,preciseType>& n2,
+                                                               numberType result, double functionError, double derivative1, double derivative2)
+        {
+            #ifdef SHAMAN_OPERATION_COUNTERS
+            countOperation<S<numberType,errorType,preciseType>>(Operation::function);
+            #endif
+            const double totalError = functionError + derivative1 * double(n1.error) + derivative2 * double(n2.error);
+            #ifdef SHAMAN_TAGGED_ERROR
+            error_composants<errorType> newErrorComp;
+            if((n1.error == 0) and (n2.error == 0))
+            {
+                newErrorComp = error_composants<errorType>(errorType(totalError));
+            }
+            else if(n2.error == 0)
+            {
+                newErrorComp = error_composants<errorType>(n1.errorComposants, [derivative1](errorType e){return e*derivative1;});
+                newErrorComp.addError(functionError);
+            }
+            else if(n1.error == 0)
+            {
+                newErrorComp = error_composants<errorType>(n2.errorComposants, [derivative2](errorType e){return e*derivative2;});
+                newErrorComp.addError(functionError);
+            }
+            else
+            {
+                newErrorComp = error_composants<errorType>(n1.errorComposants, n2.errorComposants,
+                                                           [derivative1, derivative2](errorType e1, errorType e2){return e1*derivative1 + e2*derivative2;});
+                newErrorComp.addError(functionError);
+            }
+            return S<numberType,errorType,preciseType>(result, totalError, newErrorComp);
+            #else
+            return S<numberType,errorType,preciseType>(result, totalError);
+            #endif
+        }
+
+        /*
+         * applies a kernel to the inputs, chunk by chunk :
+         * - the numbers are copied into a contiguous buffer
+         * - the kernel is applied to the buffer (this loop is the one that gets vectorized)
+         * - the outputs are built from the results (with the scalar function when the kernel could not be used)
+         */
+        template<typename numberType, typename errorType, typename preciseType, typename Kernel, typename Scalar>
+        void batchUnary(const S<numberType,errorType,preciseType>* input, S<numberType,errorType,preciseType>* output, std::size_t size,
+                        Kernel kernel, Scalar scalar, std::true_type /*has kernels*/)
+        {
+            double numbers[batchChunkSize];
+            numberType results[batchChunkSize];
+            double functionErrors[batchChunkSize];
+            double derivatives[batchChunkSize];
+            bool valids[batchChunkSize];
+            for(std::size_t begin = 0; begin < size; begin += batchChunkSize)
+            {
+                const std::size_t length = std::min(batchChunkSize, size - begin);
+                for(std::size_t i = 0; i < length; i++) numbers[i] = double(input[begin + i].number);
+
+                for(std::size_t i = 0; i < length; i++)
+                {
+                    const BatchResult kernelResult = kernel(numbers[i]);
+                    const numberType result = numberType(kernelResult.value.hi);
+                    results[i] = result;
+                    functionErrors[i] = (kernelResult.value.hi - double(result)) + kernelResult.value.lo;
+                    derivatives[i] = kernelResult.derivative1;
+                    valids[i] = kernelResult.valid & isFiniteBits(double(result));
+                }
+
+                for(std::size_t i = 0; i < length; i++)
+                {
+                    const S<numberType,errorType,preciseType>& n = input[begin + i];
+                    output[begin + i] = valids[i] ? batchOutput(n, results[i], functionErrors[i], derivatives[i]) : scalar(n);
+                }
+            }
+        }
+
+        template<typename numberType, typename errorType, typename preciseType, typename Kernel, typename Scalar>
+        void batchUnary(const S<numberType,errorType,preciseType>* input, S<numberType,errorType,preciseType>* output, std::size_t size,
+                        Kernel /*kernel*/, Scalar scalar, std::false_type /*has kernels*/)
+        {
+            for(std::size_t i = 0; i < size; i++) output[i] = scalar(input[i]);
+        }
+
+        /*
+         * same as batchUnary for a function taking two inputs
+         * a stride2 of zero uses the same second input for all the elements
+         */
+        template<typename numberType, typename errorType, typename preciseType, typename Kernel, typename Scalar>
+        void batchBinary(const S<numberType,errorType,preciseType>* input1, const S<numberType,errorType,preciseType>* input2, std::size_t stride2,
+                         S<numberType,errorType,preciseType>* output, std::size_t size, Kernel kernel, Scalar scalar, std::true_type /*has kernels*/)
+        {
+            double numbers1[batchChunkSize];
+            double numbers2[batchChunkSize];
+            numberType results[batchChunkSize];
+            double functionErrors[batchChunkSize];
+            double derivatives1[batchChunkSize];
+            double derivatives2[batchChunkSize];
+            bool valids[batchChunkSize];
+            for(std::size_t begin = 0; begin < size; begin += batchChunkSize)
+            {
+                const std::size_t length = std::min(batchChunkSize, size - begin);
+                for(std::size_t i = 0; i < length; i++)
+                {
+                    numbers1[i] = double(input1[begin + i].number);
+                    numbers2[i] = double(input2[(begin + i) * stride2].number);
+                }
+
+                for(std::size_t i = 0; i < length; i++)
+                {
+                    const BatchResult kernelResult = kernel(numbers1[i], numbers2[i]);
+                    const numberType result = numberType(kernelResult.value.hi);
+                    results[i] = result;
+                    functionErrors[i] = (kernelResult.value.hi - double(result)) + kernelResult.value.lo;
+                    derivatives1[i] = kernelResult.derivative1;
+                    derivatives2[i] = kernelResult.derivative2;
+                    valids[i] = kernelResult.valid & isFiniteBits(double(result));
+                }
+
+                for(std::size_t i = 0; i < length; i++)
+                {
+                    const S<numberType,errorType,preciseType>& n1 = input1[begin + i];
+                    const S<numberType,errorType,preciseType>& n2 = input2[(begin + i) * stride2];
+                    output[begin + i] = valids[i] ? batchOutput(n1, n2, results[i], functionErrors[i], derivatives1[i], derivatives2[i]) : scalar(n1, n2);
+                }
+            }
+        }
+
+        template<typename numberType, typename errorType, typename preciseType, typename Kernel, typename Scalar>
+        void batchBinary(const S<numberType,errorType,preciseType>* input1, const S<numberType,errorType,preciseType>* input2, std::size_t stride2,
+                         S<numberType,errorType,preciseType>* output, std::size_t size, Kernel /*kernel*/, Scalar scalar, std::false_type /*has kernels*/)
+        {
+            for(std::size_t i = 0; i < size; i++) output[i] = scalar(input1[i], input2[i * stride2]);
+        }
+#endif //NO_SHAMAN
+    }
+
+    //-------------------------------------------------------------------------------------------------
+    // BATCH FUNCTIONS
+
+    namespace batch
+    {
+#ifdef NO_SHAMAN
+#define SHAMAN_BATCH_S_FUNCTION(functionName, Kernel)
+#else
+#define SHAMAN_BATCH_S_FUNCTION(functionName, Kernel) \
+        template<typename N, typename E, typename P> \
+        void functionName(const S<N,E,P>* input, S<N,E,P>* output, std::size_t size) \
+        { \
+            detail::batchUnary(input, output, size, detail::Kernel(), [](const S<N,E,P>& n){return Sstd::functionName(n);}, detail::has_batch_kernels<N>()); \
+        }
+#endif
+
+// defines the batch version of a function taking one argument for S types, plain numbers and ranges
+#define SHAMAN_BATCH_FUNCTION(functionName, Kernel) \
+        SHAMAN_BATCH_S_FUNCTION(functionName, Kernel) \
+        template<typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0> \
+        void functionName(const T* input, T* output, std::size_t size) \
+        { \
+            for(std::size_t i = 0; i < size; i++) output[i] = std::functionName(input[i]); \
+        } \
+        template<typename InputRange, typename OutputRange> \
+        auto functionName(const InputRange& input, OutputRange&& output) -> decltype(functionName(input.data(), output.data(), input.size())) \
+        { \
+            detail::checkBatchSizes(input.size(), output.size(), #functionName); \
+            return functionName(input.data(), output.data(), input.size()); \
+        }
+
+        SHAMAN_BATCH_FUNCTION(exp, BatchExp)
+        SHAMAN_BATCH_FUNCTION(log, BatchLog)
+        SHAMAN_BATCH_FUNCTION(sin, BatchSin)
+        SHAMAN_BATCH_FUNCTION(cos, BatchCos)
+
+#undef SHAMAN_BATCH_FUNCTION
+#undef SHAMAN_BATCH_S_FUNCTION
+
+#ifndef NO_SHAMAN
+        template<typename N, typename E, typename P>
+        void pow(const S<N,E,P>* x, const S<N,E,P>* y, S<N,E,P>* output, std::size_t size)
+        {
+            detail::batchBinary(x, y, 1, output, size, detail::BatchPow(),
+                                [](const S<N,E,P>& n1, const S<N,E,P>& n2){return Sstd::pow(n1, n2);}, detail::has_batch_kernels<N>());
+        }
+
+        // the exponent is taken by copy as it might be an element of the output
+        template<typename N, typename E, typename P>
+        void pow(const S<N,E,P>* x, typename detail::batch_identity<S<N,E,P>>::type y, S<N,E,P>* output, std::size_t size)
+        {
+            detail::batchBinary(x, &y, 0, output, size, detail::BatchPow(),
+                                [](const S<N,E,P>& n1, const S<N,E,P>& n2){return Sstd::pow(n1, n2);}, detail::has_batch_kernels<N>());
+        }
+#endif //NO_SHAMAN
+
+        template<typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+        void pow(const T* x, const T* y, T* output, std::size_t size)
+        {
+            for(std::size_t i = 0; i < size; i++) output[i] = std::pow(x[i], y[i]);
+        }
+
+        template<typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+        void pow(const T* x, typename detail::batch_identity<T>::type y, T* output, std::size_t size)
+        {
+            for(std::size_t i = 0; i < size; i++) output[i] = std::pow(x[i], y);
+        }
+
+        template<typename InputRange1, typename InputRange2, typename OutputRange>
+        auto pow(const InputRange1& x, const InputRange2& y, OutputRange&& output) -> decltype(pow(x.data(), y.data(), output.data(), x.size()))
+        {
+            detail::checkBatchSizes(x.size(), y.size(), "pow");
+            detail::checkBatchSizes(x.size(), output.size(), "pow");
+            return pow(x.data(), y.data(), output.data(), x.size());
+        }
+
+        template<typename InputRange, typename Exponent, typename OutputRange>
+        auto pow(const InputRange& x, const Exponent& y, OutputRange&& output) -> decltype(pow(x.data(), y, output.data(), x.size()))
+        {
+            detail::checkBatchSizes(x.size(), output.size(), "pow");
+            return pow(x.data(), y, output.data(), x.size());
+        }
+    }
+}
+
+#ifndef NO_SHAMAN
+namespace Sstd
+{
+    using Shaman::batch::exp;
+    using Shaman::batch::log;
+    using Shaman::batch::sin;
+    using Shaman::batch::cos;
+    using Shaman::batch::pow;
+}
+#endif //NO_SHAMAN
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+
+/*
+ * to use :
+ * - compile with the SHAMAN_TAGGED_ERROR and SHAMAN_CALL_PATH flags
+ * - include shaman_call_path.h
+ * - use FUNCTION_BLOCK/LOCAL_BLOCK as usual, the error is now attributed to the path of nested blocks in which it was generated
+ *
+ * Shaman::displayCallPaths(result); // the error of result per call path and per innermost block
+ * auto errors = Shaman::error_per_leaf(result); // errors["dot"] is the error generated in dot, whoever called it
+ *
+ * Without SHAMAN_CALL_PATH each block is its own path (both functions then give the same attribution).
+ * Without SHAMAN_TAGGED_ERROR both functions return no error.
+ */
+namespace Shaman
+{
+    namespace detail
+    {
+        #ifdef SHAMAN_TAGGED_ERROR
+        /*
+         * calls function(tag, error) for each tag to which part of the composants is attributed
+         */
+        template<typename errorType, typename FUN>
+        void forEachTag(const error_sum<errorType>& composants, FUN function)
+        {
+            const std::size_t tagNumber = std::min(CodeBlock::tagNumber(), std::size_t(composants.maxTagNumber));
+            for(std::size_t tag = 0; tag < tagNumber; tag++)
+            {
+                if(composants.errors[tag] != 0) function(Tag(tag), double(composants.errors[tag]));
+            }
+        }
+
+        #ifdef SHAMAN_TOPK_ERROR
+        // the top-K composants are read directly, their tags are not bounded by SHAMAN_TAGNUMBER
+        template<typename errorType, typename FUN>
+        void forEachTag(const error_topk<errorType>& composants, FUN function)
+        {
+            for(unsigned int i = 0; i < composants.size; i++)
+            {
+                if(composants.errors[i] != 0) function(composants.tags[i], double(composants.errors[i]));
+            }
+        }
+        #endif
+
+        // the other composants (tape, pool) are attributed to the tags by their conversion to error_sum
+        template<template<typename> class Composants, typename errorType, typename FUN>
+        void forEachTag(const Composants<errorType>& composants, FUN function)
+        {
+            forEachTag(error_sum<errorType>(composants), function);
+        }
+
+        /*
+         * returns the part of the error that is attributed to no tag (the residual of the top-K composants)
+         */
+        template<typename Composants>
+        double residualOf(const Composants&)
+        {
+            return 0.;
+        }
+
+        #ifdef SHAMAN_TOPK_ERROR
+        template<typename errorType>
+        double residualOf(const error_topk<errorType>& composants)
+        {
+            return double(composants.residual);
+        }
+        #endif
+
+        /*
+         * calls function(tag, error) for each tag to which part of the error of the number is attributed
+         */
+        template<typename Stype, typename FUN>
+        void forEachComposant(const Stype& x, FUN function)
+        {
+            forEachTag(x.errorComposants, function);
+        }
+        #endif
+
+        /*
+         * displays the errors from the largest to the smallest
+         */
+        inline void displayErrors(std::ostream& report, const std::map<std::string, double>& errors, double totalError)
+        {
+            std::vector<std::pair<std::string, double>> sortedErrors(errors.begin(), errors.end());
+            std::sort(sortedErrors.begin(), sortedErrors.end(), [](const std::pair<std::string, double>& e1, const std::pair<std::string, double>& e2)
+                      {return std::abs(e1.second) > std::abs(e2.second);});
+            for(const auto& error : sortedErrors)
+            {
+                report << " -> " << error.first << " : " << error.second << " (" << 100. * error.second / totalError << "%)" << std::endl;
+            }
+        }
+    }
+
+    /*
+     * returns the error of the number attributed to each call path (named 'outer/inner')
+     * with SHAMAN_TOPK_ERROR, the residual of the composants is attributed to 'other'
+     */
+    template<typename Stype>
+    std::map<std::string, double> error_per_path(const Stype& x)
+    {
+        std::map<std::string, double> errors;
+        #ifdef SHAMAN_TAGGED_ERROR
+        detail::forEachComposant(x, [&errors](Tag tag, double error)
+        {
+            errors[CodeBlock::nameOfTag(tag)] += error;
+        });
+        const double residual = detail::residualOf(x.errorComposants);
+        if(residual != 0) errors["other"] += residual;
+        #endif
+        return errors;
+    }
+
+    /*
+     * returns the error of the number attributed to each block, summed over all the paths leading to it
+     * with SHAMAN_TOPK_ERROR, the residual of the composants is attributed to 'other'
+     */
+    template<typename Stype>
+    std::map<std::string, double> error_per_leaf(const Stype& x)
+    {
+        std::map<std::string, double> errors;
+        #ifdef SHAMAN_TAGGED_ERROR
+        detail::forEachComposant(x, [&errors](Tag tag, double error)
+        {
+            errors[CodeBlock::nameOfTag(CodeBlock::leafOfTag(tag))] += error;
+        });
+        const double residual = detail::residualOf(x.errorComposants);
+        if(residual != 0) errors["other"] += residual;
+        #endif
+        return errors;
+    }
+
+    /*
+     * displays the error of the number per call path and per innermost block
+     */
+    template<typename Stype>
+    void displayCallPaths(const Stype& x)
+    {
+        Shaman::Session::ReportWriter report = ShamanGlobals::session().report();
+        #ifdef SHAMAN_TAGGED_ERROR
+        const double error = double(x.error);
+        report << "#SHAMAN: Error of " << error << " per call path :" << std::endl;
+        detail::displayErrors(report, error_per_path(x), error);
+        report << "#SHAMAN: Error of " << error << " per block :" << std::endl;
+        detail::displayErrors(report, error_per_leaf(x), error);
+        #else
+        report << "#SHAMAN: please set the 'SHAMAN_TAGGED_ERROR' and 'SHAMAN_CALL_PATH' flags in order to attribute errors to call paths." << std::endl;
+        #endif
+    }
+}
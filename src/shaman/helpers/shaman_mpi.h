@@ -20,8 +20,11 @@
  * type definitions
  */
 MPI_Datatype MPI_SBOOL;
+MPI_Datatype MPI_SHALF;
+MPI_Datatype MPI_SBFLOAT16;
 MPI_Datatype MPI_SFLOAT;
 MPI_Datatype MPI_SDOUBLE;
+MPI_Datatype MPI_SDOUBLE_COMPACT;
 MPI_Datatype MPI_SLONG_DOUBLE;
 
 /*
@@ -61,7 +64,13 @@ int MPI_Type_shaman(MPI_Datatype numberType, MPI_Datatype errorType, MPI_Datatyp
     // - create a pair of encrypt/decrypt functions to be used before sending data
     //   they would flatten then data into [number;error;error_term0;error_term1;...] (this format requires knowing the number of error terms to be decrypted)
 
-    return MPI_Type_create_struct(structlen, blocklengths, displacements, types, newType);
+    // the extent is set to the size of the type so that arrays keep their padding (if any)
+    MPI_Datatype structType;
+    int errorValue = MPI_Type_create_struct(blockNum, blocklengths, displacements, types, &structType);
+    if (errorValue != MPI_SUCCESS) return errorValue;
+    errorValue = MPI_Type_create_resized(structType, 0, sizeof(ShamanType), newType);
+    MPI_Type_free(&structType);
+    return errorValue;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -90,7 +99,15 @@ MPI_Op MPI_SPROD;
  * TODO could fallback to MPI operations on predefined types
  */
 #define shamanToMpiUserFunction(invec,inoutvec,len,datatype,operation)\
-    if (*datatype == MPI_SFLOAT)\
+    if (*datatype == MPI_SHALF)\
+    {\
+        generalShamanUserFunction(invec, inoutvec, len, operation, Shalf);\
+    }\
+    else if (*datatype == MPI_SBFLOAT16)\
+    {\
+        generalShamanUserFunction(invec, inoutvec, len, operation, Sbfloat16);\
+    }\
+    else if (*datatype == MPI_SFLOAT)\
     {\
         generalShamanUserFunction(invec, inoutvec, len, operation, Sfloat);\
     }\
@@ -98,6 +115,10 @@ MPI_Op MPI_SPROD;
     {\
         generalShamanUserFunction(invec, inoutvec, len, operation, Sdouble);\
     }\
+    else if (*datatype == MPI_SDOUBLE_COMPACT)\
+    {\
+        generalShamanUserFunction(invec, inoutvec, len, operation, Sdouble_compact);\
+    }\
     else if (*datatype == MPI_SLONG_DOUBLE)\
     {\
         generalShamanUserFunction(invec, inoutvec, len, operation, Slong_double);\
@@ -145,8 +166,11 @@ int MPI_Shaman_Init(int argc, char **argv )
     int errorValue = MPI_Init(&argc, &argv);
 
 #ifdef NO_SHAMAN
+    MPI_SHALF = MPI_UINT16_T; // NOTE: the MPI operations cannot be used on those types when Shaman is disabled
+    MPI_SBFLOAT16 = MPI_UINT16_T;
     MPI_SFLOAT = MPI_FLOAT;
     MPI_SDOUBLE = MPI_DOUBLE;
+    MPI_SDOUBLE_COMPACT = MPI_DOUBLE;
     MPI_SLONG_DOUBLE = MPI_LONG_DOUBLE;
     MPI_SMAX = MPI_MAX;
     MPI_SMIN = MPI_MIN;
@@ -155,12 +179,20 @@ int MPI_Shaman_Init(int argc, char **argv )
 #else
     if (errorValue == MPI_SUCCESS)
     {
+        // Shalf and Sbfloat16 (the numbers are sent as their 16 bits encoding)
+        MPI_Type_shaman<Shalf>(MPI_UINT16_T, MPI_FLOAT, &MPI_SHALF);
+        MPI_Type_commit(&MPI_SHALF);
+        MPI_Type_shaman<Sbfloat16>(MPI_UINT16_T, MPI_FLOAT, &MPI_SBFLOAT16);
+        MPI_Type_commit(&MPI_SBFLOAT16);
         // Sfloat
         MPI_Type_shaman<Sfloat>(MPI_FLOAT, MPI_FLOAT, &MPI_SFLOAT);
         MPI_Type_commit(&MPI_SFLOAT);
         // Sdouble
         MPI_Type_shaman<Sdouble>(MPI_DOUBLE, MPI_DOUBLE, &MPI_SDOUBLE);
         MPI_Type_commit(&MPI_SDOUBLE);
+        // Sdouble_compact
+        MPI_Type_shaman<Sdouble_compact>(MPI_DOUBLE, MPI_FLOAT, &MPI_SDOUBLE_COMPACT);
+        MPI_Type_commit(&MPI_SDOUBLE_COMPACT);
         // Slong_double
         MPI_Type_shaman<Slong_double>(MPI_LONG_DOUBLE, MPI_LONG_DOUBLE, &MPI_SLONG_DOUBLE);
         MPI_Type_commit(&MPI_SLONG_DOUBLE);
@@ -185,9 +217,11 @@ int MPI_Shaman_Finalize()
 {
 #ifndef NO_SHAMAN
     // free types
-    MPI_Type_free(&MPI_SBOOL);
+    MPI_Type_free(&MPI_SHALF);
+    MPI_Type_free(&MPI_SBFLOAT16);
     MPI_Type_free(&MPI_SFLOAT);
     MPI_Type_free(&MPI_SDOUBLE);
+    MPI_Type_free(&MPI_SDOUBLE_COMPACT);
     MPI_Type_free(&MPI_SLONG_DOUBLE);
 
     // free operators
@@ -1,31 +1,46 @@
 #pragma once
 
 // Requires openMP 4.0+ to get reductions on user defined types
-#ifdef _OPENMP
+#if defined(_OPENMP) && !defined(NO_SHAMAN)
 
 // +
+#pragma omp declare reduction(+:Shalf : omp_out=omp_in+omp_out)                initializer(omp_priv=Shalf(0.f))
+#pragma omp declare reduction(+:Sbfloat16 : omp_out=omp_in+omp_out)                initializer(omp_priv=Sbfloat16(0.f))
 #pragma omp declare reduction(+:Sfloat : omp_out=omp_in+omp_out)                initializer(omp_priv=Sfloat(0.f))
 #pragma omp declare reduction(+:Sdouble: omp_out=omp_in+omp_out)	            initializer(omp_priv=Sdouble(0.))
+#pragma omp declare reduction(+:Sdouble_compact: omp_out=omp_in+omp_out)	            initializer(omp_priv=Sdouble_compact(0.))
 #pragma omp declare reduction(+:Slong_double: omp_out=omp_in+omp_out)	        initializer(omp_priv=Slong_double(0.L))
 
 // -
+#pragma omp declare reduction(-:Shalf : omp_out=omp_in+omp_out)	            initializer(omp_priv=Shalf(0.f))
+#pragma omp declare reduction(-:Sbfloat16 : omp_out=omp_in+omp_out)	            initializer(omp_priv=Sbfloat16(0.f))
 #pragma omp declare reduction(-:Sfloat : omp_out=omp_in+omp_out)	            initializer(omp_priv=Sfloat(0.f))
 #pragma omp declare reduction(-:Sdouble: omp_out=omp_in+omp_out)	            initializer(omp_priv=Sdouble(0.))
+#pragma omp declare reduction(-:Sdouble_compact: omp_out=omp_in+omp_out)	            initializer(omp_priv=Sdouble_compact(0.))
 #pragma omp declare reduction(-:Slong_double: omp_out=omp_in+omp_out)	        initializer(omp_priv=Slong_double(0.L))
 
 // *
+#pragma omp declare reduction(*:Shalf : omp_out=omp_in*omp_out)	            initializer(omp_priv=Shalf(1.f))
+#pragma omp declare reduction(*:Sbfloat16 : omp_out=omp_in*omp_out)	            initializer(omp_priv=Sbfloat16(1.f))
 #pragma omp declare reduction(*:Sfloat : omp_out=omp_in*omp_out)	            initializer(omp_priv=Sfloat(1.f))
 #pragma omp declare reduction(*:Sdouble: omp_out=omp_in*omp_out)    	        initializer(omp_priv=Sdouble(1.))
+#pragma omp declare reduction(*:Sdouble_compact: omp_out=omp_in*omp_out)    	        initializer(omp_priv=Sdouble_compact(1.))
 #pragma omp declare reduction(*:Slong_double: omp_out=omp_in*omp_out)	        initializer(omp_priv=Slong_double(1.L))
 
 // max
+#pragma omp declare reduction(max:Shalf : omp_out=Sstd::max(omp_in,omp_out))	        initializer(omp_priv=Shalf(std::numeric_limits<Shaman::half>::lowest()))
+#pragma omp declare reduction(max:Sbfloat16 : omp_out=Sstd::max(omp_in,omp_out))	        initializer(omp_priv=Sbfloat16(std::numeric_limits<Shaman::bfloat16>::lowest()))
 #pragma omp declare reduction(max:Sfloat : omp_out=Sstd::max(omp_in,omp_out))	        initializer(omp_priv=Sfloat(std::numeric_limits<float>::lowest()))
 #pragma omp declare reduction(max:Sdouble : omp_out=Sstd::max(omp_in,omp_out))        initializer(omp_priv=Sdouble(std::numeric_limits<double>::lowest()))
+#pragma omp declare reduction(max:Sdouble_compact : omp_out=Sstd::max(omp_in,omp_out))        initializer(omp_priv=Sdouble_compact(std::numeric_limits<double>::lowest()))
 #pragma omp declare reduction(max:Slong_double : omp_out=Sstd::max(omp_in,omp_out))   initializer(omp_priv=Slong_double(std::numeric_limits<long double>::lowest()))
 
 // min
+#pragma omp declare reduction(min:Shalf : omp_out=Sstd::min(omp_in,omp_out))	        initializer(omp_priv=Shalf(std::numeric_limits<Shaman::half>::max()))
+#pragma omp declare reduction(min:Sbfloat16 : omp_out=Sstd::min(omp_in,omp_out))	        initializer(omp_priv=Sbfloat16(std::numeric_limits<Shaman::bfloat16>::max()))
 #pragma omp declare reduction(min:Sfloat : omp_out=Sstd::min(omp_in,omp_out))	        initializer(omp_priv=Sfloat(std::numeric_limits<float>::max()))
 #pragma omp declare reduction(min:Sdouble : omp_out=Sstd::min(omp_in,omp_out))        initializer(omp_priv=Sdouble(std::numeric_limits<double>::max()))
+#pragma omp declare reduction(min:Sdouble_compact : omp_out=Sstd::min(omp_in,omp_out))        initializer(omp_priv=Sdouble_compact(std::numeric_limits<double>::max()))
 #pragma omp declare reduction(min:Slong_double : omp_out=Sstd::min(omp_in,omp_out))   initializer(omp_priv=Slong_double(std::numeric_limits<long double>::max()))
 
 #endif //_OPENMP
\ No newline at end of file
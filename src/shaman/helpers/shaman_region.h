@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <type_traits>
+#include <shaman/tagged/global_vars.h>
+
+/*
+ * to use :
+ * - include shaman_region.h
+ * - keep your data as plain 'float'/'double'/'long double'
+ * - open a 'Shaman::Region' on the data used by the kernel you want to instrument
+ *
+ * {
+ *     Shaman::Region<double> x(data, size); // copies data into Sdouble, with the errors stored when they last exited a region
+ *     for(std::size_t i = 0; i < x.size(); i++) x[i] = Sstd::sqrt(x[i]) / 3.;
+ * } // the numbers are written back into data, their errors are stored in a side table
+ * std::cout << Shaman::region_value(data[0]) << std::endl; // data[0] with its stored error
+ *
+ * The rest of the program runs at native speed, only the regions use the Shaman types.
+ * Numbers that do not go through a region have no entry in the side table (and are thus considered exact).
+ * Entering a region again resumes from the stored errors, which are replaced when the region is exited.
+ * With tagged error only the total error is stored, its composants are lost when exiting the region.
+ * With NO_SHAMAN, a region is a plain view on the data and the side table stays empty.
+ */
+namespace Shaman
+{
+    /*
+     * Shaman type used to instrument values of type T inside a region
+     */
+    template<typename T>
+    using region_type = decltype(makeStype(T()));
+
+    //-------------------------------------------------------------------------------------------------
+    // SIDE TABLE
+
+    /*
+     * error stored for the number at the given address when it last exited a region (0 if none)
+     */
+    inline long double region_error(const void* address)
+    {
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexRegionErrors);
+        auto it = ShamanGlobals::regionErrors.find(address);
+        return (it == ShamanGlobals::regionErrors.end()) ? 0.L : it->second;
+    }
+
+    namespace detail
+    {
+        /*
+         * builds the Shaman number of a plain value with the given error
+         */
+        template<typename T>
+        inline region_type<T> make_region_value(const T& x, long double storedError)
+        {
+            #ifdef NO_SHAMAN
+            (void)storedError;
+            return x;
+            #else
+            using Stype = region_type<T>;
+            using errorType = decltype(Stype().error);
+            const errorType error = static_cast<errorType>(storedError);
+            if(error == errorType(0)) return Stype(x);
+            #ifdef SHAMAN_TAGGED_ERROR
+            error_composants<errorType> errorComposants;
+            errorComposants.addError(error);
+            return Stype(x, error, errorComposants);
+            #else
+            return Stype(x, error);
+            #endif
+            #endif
+        }
+    }
+
+    /*
+     * rebuilds the Shaman number of a plain value from the error stored in the side table
+     */
+    template<typename T>
+    inline region_type<T> region_value(const T& x)
+    {
+        return detail::make_region_value(x, region_error(&x));
+    }
+
+    /*
+     * forgets the errors stored for [first;first+size[ (all the errors if first is nullptr)
+     */
+    template<typename T>
+    inline void clear_region_errors(const T* first = nullptr, std::size_t size = 0)
+    {
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexRegionErrors);
+        if(first == nullptr)
+        {
+            ShamanGlobals::regionErrors.clear();
+        }
+        else
+        {
+            for(std::size_t i = 0; i < size; i++) ShamanGlobals::regionErrors.erase(first + i);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+    // REGION
+
+    /*
+     * promotes size plain values to their Shaman type for the lifetime of the region
+     * the numbers are written back and their errors stored in the side table when the region is destroyed
+     */
+    template<typename T>
+    class Region
+    {
+        static_assert(std::is_floating_point<T>::value, "Shaman::Region expects plain floating point data.");
+
+    public:
+        using value_type = region_type<T>;
+
+        Region(T* data, std::size_t size): data_(data), size_(size)
+        {
+            #ifndef NO_SHAMAN
+            // the numbers resume from the errors stored when they last exited a region
+            values_.reserve(size);
+            std::lock_guard<std::mutex> guard(ShamanGlobals::mutexRegionErrors);
+            const auto& errors = ShamanGlobals::regionErrors;
+            for(std::size_t i = 0; i < size; i++)
+            {
+                const auto it = errors.empty() ? errors.end() : errors.find(data + i);
+                values_.push_back(detail::make_region_value(data[i], (it == errors.end()) ? 0.L : it->second));
+            }
+            #endif
+        }
+
+        // a single scalar
+        explicit Region(T& x): Region(&x, 1) {}
+
+        Region(const Region&) = delete;
+        Region& operator=(const Region&) = delete;
+        Region(Region&& region): data_(region.data_), size_(region.size_), values_(std::move(region.values_))
+        {
+            region.data_ = nullptr;
+            region.size_ = 0;
+        }
+
+        ~Region()
+        {
+            #ifndef NO_SHAMAN
+            if(data_ == nullptr) return;
+            std::lock_guard<std::mutex> guard(ShamanGlobals::mutexRegionErrors);
+            for(std::size_t i = 0; i < size_; i++)
+            {
+                data_[i] = values_[i].number;
+                if(values_[i].error == 0)
+                {
+                    ShamanGlobals::regionErrors.erase(data_ + i);
+                }
+                else
+                {
+                    ShamanGlobals::regionErrors[data_ + i] = values_[i].error;
+                }
+            }
+            #endif
+        }
+
+        // access
+        std::size_t size() const { return size_; }
+        #ifdef NO_SHAMAN
+        value_type& operator[](std::size_t i) { return data_[i]; }
+        const value_type& operator[](std::size_t i) const { return data_[i]; }
+        value_type* data() { return data_; }
+        #else
+        value_type& operator[](std::size_t i) { return values_[i]; }
+        const value_type& operator[](std::size_t i) const { return values_[i]; }
+        value_type* data() { return values_.data(); }
+        #endif
+        value_type* begin() { return data(); }
+        value_type* end() { return data() + size_; }
+
+    private:
+        T* data_; // plain data
+        std::size_t size_;
+        std::vector<value_type> values_; // instrumented copy (empty with NO_SHAMAN)
+    };
+}
@@ -0,0 +1,444 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include "shaman_algorithms.h"
+
+/*
+ * to use :
+ * - include shaman_reproducible.h
+ * - accumulate your numbers into a 'Shaman::reproducible_sum<Sdouble>' (with +=) or call 'Shaman::reproducible_reduce'
+ * - with MPI, include it after shaman_mpi.h and use 'MPI_Shaman_Allreduce_reproducible_sum' instead of an 'MPI_Allreduce' with 'MPI_SSUM'
+ *
+ * Both the number and the error of the result are bitwise identical whatever the order of the additions,
+ * the number of threads or the decomposition between MPI ranks :
+ * the number is the correctly rounded sum of the numbers
+ * and the error is the correctly rounded difference between the exact sum of the corrected numbers and the number.
+ *
+ * NOTE: with tagged error, the error composants are still summed in the usual (non reproducible) way.
+ */
+namespace Shaman
+{
+    //-------------------------------------------------------------------------------------------------
+    // EXACT ACCUMULATOR
+
+    /*
+     * description of the binary format of a floating point type
+     */
+    template<typename T> struct float_format;
+    template<> struct float_format<float>
+    {
+        using UInt = std::uint32_t;
+        static const int mantissaBits = 23; // without the implicit bit
+        static const int exponentBits = 8;
+    };
+    template<> struct float_format<double>
+    {
+        using UInt = std::uint64_t;
+        static const int mantissaBits = 52; // without the implicit bit
+        static const int exponentBits = 11;
+    };
+
+    /*
+     * exact sum of floating point numbers
+     * uses a "small superaccumulator" (see Radford M. Neal, "Fast exact summation using small and large superaccumulators") :
+     * each bit of the format has a fixed position in an array of 32 bits chunks (stored in 64 bits integers to absorb carries)
+     * as integer additions are exact (and thus associative), the state does not depend on the order of the additions
+     *
+     * NOTE: adding a number costs two integer additions, carries are propagated once every carryPeriod additions
+     */
+    template<typename T>
+    class exact_sum
+    {
+        static_assert(std::is_same<T,float>::value or std::is_same<T,double>::value, "exact_sum only supports float and double.");
+
+        using Format = float_format<T>;
+        using UInt = typename Format::UInt;
+        static const int exponentMask = (1 << Format::exponentBits) - 1;
+        static const int precision = Format::mantissaBits + 1;
+        static const int unitExponent = (exponentMask >> 1) + Format::mantissaBits - 1; // bit k has weight 2^(k-unitExponent)
+        static const int carryPeriod = 1 << 10; // 2^10 additions of at most 2^52 cannot overflow 63 bits
+
+    public:
+        static const int chunkNumber = ((exponentMask - 1) >> 5) + 4; // two chunks per number plus room for the carries
+        static const int stateSize = chunkNumber + 3; // chunks plus the counters of special values
+
+        // state = [chunks; +inf number; -inf number; nan number]
+        std::int64_t state[stateSize];
+
+    private:
+        int additionsSinceCarry;
+
+    public:
+        exact_sum(): state(), additionsSinceCarry(0) {}
+
+        /*
+         * adds a number to the sum
+         */
+        inline void add(T x)
+        {
+            UInt bits;
+            std::memcpy(&bits, &x, sizeof(T));
+            const int exponent = static_cast<int>(bits >> Format::mantissaBits) & exponentMask;
+            const bool isNegative = (bits >> (8*sizeof(T) - 1)) != 0;
+            std::uint64_t mantissa = bits & ((UInt(1) << Format::mantissaBits) - 1);
+
+            if(exponent == exponentMask)
+            {
+                // inf or nan
+                const int counter = (mantissa != 0) ? 2 : (isNegative ? 1 : 0);
+                state[chunkNumber + counter]++;
+                return;
+            }
+
+            // x = mantissa * 2^(shift-unitExponent)
+            int shift = 0;
+            if(exponent != 0)
+            {
+                mantissa |= std::uint64_t(1) << Format::mantissaBits;
+                shift = exponent - 1;
+            }
+            const int chunk = shift >> 5;
+            const int lowShift = shift & 31;
+            const std::int64_t lowPart = static_cast<std::int64_t>((mantissa << lowShift) & 0xFFFFFFFFu);
+            const std::int64_t highPart = static_cast<std::int64_t>(mantissa >> (32 - lowShift));
+
+            if(isNegative)
+            {
+                state[chunk] -= lowPart;
+                state[chunk+1] -= highPart;
+            }
+            else
+            {
+                state[chunk] += lowPart;
+                state[chunk+1] += highPart;
+            }
+
+            if(++additionsSinceCarry == carryPeriod)
+            {
+                propagateCarries();
+            }
+        }
+
+        /*
+         * merges two sums
+         */
+        exact_sum& operator+=(const exact_sum& other)
+        {
+            propagateCarries();
+            exact_sum normalizedOther = other;
+            normalizedOther.propagateCarries();
+            for(int i = 0; i < stateSize; i++)
+            {
+                state[i] += normalizedOther.state[i];
+            }
+            propagateCarries();
+            return *this;
+        }
+
+        /*
+         * writes a normalized copy of the state into a buffer of stateSize integers
+         * (the buffers of several sums can be merged with an integer addition, which is how the MPI reduction works)
+         */
+        void toState(std::int64_t* buffer) const
+        {
+            exact_sum sum = *this;
+            sum.propagateCarries();
+            std::copy(sum.state, sum.state + stateSize, buffer);
+        }
+
+        /*
+         * reads the state from a buffer of stateSize integers
+         */
+        void fromState(const std::int64_t* buffer)
+        {
+            std::copy(buffer, buffer + stateSize, state);
+            propagateCarries();
+        }
+
+        /*
+         * moves the bits above the 32 first bits of each chunk into the next chunk
+         * all chunks but the last one end up in [0;2^32[
+         */
+        void propagateCarries()
+        {
+            for(int i = 0; i < chunkNumber-1; i++)
+            {
+                const std::int64_t carry = state[i] >> 32; // arithmetic shift : rounds toward -inf
+                state[i] -= carry * (std::int64_t(1) << 32);
+                state[i+1] += carry;
+            }
+            additionsSinceCarry = 0;
+        }
+
+        /*
+         * returns the sum rounded to nearest
+         */
+        T round() const
+        {
+            const std::int64_t positiveInfinities = state[chunkNumber];
+            const std::int64_t negativeInfinities = state[chunkNumber+1];
+            const std::int64_t nans = state[chunkNumber+2];
+            if((nans != 0) or ((positiveInfinities != 0) and (negativeInfinities != 0))) return std::numeric_limits<T>::quiet_NaN();
+            if(positiveInfinities != 0) return std::numeric_limits<T>::infinity();
+            if(negativeInfinities != 0) return -std::numeric_limits<T>::infinity();
+
+            // gets a sign-magnitude representation
+            exact_sum sum = *this;
+            sum.propagateCarries();
+            const bool isNegative = sum.state[chunkNumber-1] < 0;
+            if(isNegative)
+            {
+                for(int i = 0; i < chunkNumber; i++) sum.state[i] = -sum.state[i];
+                sum.propagateCarries();
+            }
+            if(sum.state[chunkNumber-1] >= (std::int64_t(1) << 32))
+            {
+                // far outside of the range of T
+                return isNegative ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+            }
+
+            // finds the most significant bit
+            int topChunk = chunkNumber-1;
+            while((topChunk >= 0) and (sum.state[topChunk] == 0)) topChunk--;
+            if(topChunk < 0) return T(0);
+            int topBit = 32*topChunk + 31;
+            while(not sum.bit(topBit)) topBit--;
+
+            // extracts (at most) 64 bits below the most significant bit
+            const int lowBit = std::max(0, topBit - 63);
+            std::uint64_t window = 0;
+            for(int k = topBit; k >= lowBit; k--)
+            {
+                window = (window << 1) | std::uint64_t(sum.bit(k));
+            }
+            bool sticky = false;
+            for(int k = 0; (k < lowBit) and (not sticky); k += 32)
+            {
+                const std::uint64_t chunk = static_cast<std::uint64_t>(sum.state[k >> 5]);
+                const int usedBits = std::min(32, lowBit - k);
+                const std::uint64_t mask = (usedBits == 32) ? 0xFFFFFFFFu : ((std::uint64_t(1) << usedBits) - 1);
+                sticky = (chunk & mask) != 0;
+            }
+
+            // rounds to nearest, ties to even (subnormal results have less than 'precision' bits and are exact)
+            const int droppedBits = std::max(0, (topBit - lowBit + 1) - precision);
+            std::uint64_t rounded = window >> droppedBits;
+            if(droppedBits > 0)
+            {
+                const std::uint64_t remainder = window & ((std::uint64_t(1) << droppedBits) - 1);
+                const std::uint64_t half = std::uint64_t(1) << (droppedBits - 1);
+                if((remainder > half) or ((remainder == half) and (sticky or (rounded & 1))))
+                {
+                    rounded++;
+                }
+            }
+
+            const T result = std::ldexp(static_cast<T>(rounded), lowBit + droppedBits - unitExponent);
+            return isNegative ? -result : result;
+        }
+
+    private:
+        /*
+         * returns the k-th bit of a normalized and positive sum
+         */
+        inline bool bit(int k) const
+        {
+            return ((state[k >> 5] >> (k & 31)) & 1) != 0;
+        }
+    };
+
+    //-------------------------------------------------------------------------------------------------
+    // REPRODUCIBLE SUM
+
+    /*
+     * reproducible sum of floating point numbers
+     */
+    template<typename T>
+    class reproducible_sum
+    {
+    public:
+        static const int stateSize = exact_sum<T>::stateSize;
+        exact_sum<T> numbers;
+
+        reproducible_sum& operator+=(T x)
+        {
+            numbers.add(x);
+            return *this;
+        }
+
+        reproducible_sum& operator+=(const reproducible_sum& other)
+        {
+            numbers += other.numbers;
+            return *this;
+        }
+
+        T result() const
+        {
+            return numbers.round();
+        }
+
+        void toState(std::int64_t* buffer) const { numbers.toState(buffer); }
+        void fromState(const std::int64_t* buffer) { numbers.fromState(buffer); }
+    };
+
+#ifndef NO_SHAMAN
+    /*
+     * reproducible sum of S numbers
+     * the errors are converted into numberType (which is exact as long as errorType is not more precise than numberType)
+     */
+    template<typename numberType, typename errorType, typename preciseType>
+    class reproducible_sum<S<numberType,errorType,preciseType>>
+    {
+    public:
+        static const int stateSize = 2 * exact_sum<numberType>::stateSize;
+        exact_sum<numberType> numbers;
+        exact_sum<numberType> errors;
+        #ifdef SHAMAN_TAGGED_ERROR
+        error_composants<errorType> errorComposants;
+        #endif
+
+        reproducible_sum& operator+=(const S<numberType,errorType,preciseType>& x)
+        {
+            numbers.add(x.number);
+            errors.add(static_cast<numberType>(x.error));
+            #ifdef SHAMAN_TAGGED_ERROR
+            errorComposants.addErrors(x.errorComposants);
+            #endif
+            return *this;
+        }
+
+        reproducible_sum& operator+=(const reproducible_sum& other)
+        {
+            numbers += other.numbers;
+            errors += other.errors;
+            #ifdef SHAMAN_TAGGED_ERROR
+            errorComposants.addErrors(other.errorComposants);
+            #endif
+            return *this;
+        }
+
+        S<numberType,errorType,preciseType> result() const
+        {
+            const numberType number = numbers.round();
+
+            // error = (exact sum of the numbers - number) + exact sum of the errors
+            exact_sum<numberType> remainder = numbers;
+            remainder.add(-number);
+            exact_sum<numberType> error = remainder;
+            error += errors;
+
+            #ifdef SHAMAN_TAGGED_ERROR
+            error_composants<errorType> newErrorComp = errorComposants;
+            newErrorComp.addError(remainder.round());
+            return S<numberType,errorType,preciseType>(number, error.round(), newErrorComp);
+            #else
+            return S<numberType,errorType,preciseType>(number, error.round());
+            #endif
+        }
+
+        void toState(std::int64_t* buffer) const
+        {
+            numbers.toState(buffer);
+            errors.toState(buffer + exact_sum<numberType>::stateSize);
+        }
+
+        void fromState(const std::int64_t* buffer)
+        {
+            numbers.fromState(buffer);
+            errors.fromState(buffer + exact_sum<numberType>::stateSize);
+        }
+    };
+#endif //NO_SHAMAN
+
+    /*
+     * reproducible sum of a range, computed in parallel if the policy allows it
+     */
+    template<typename Policy, typename InputIt>
+    typename std::iterator_traits<InputIt>::value_type reproducible_reduce(Policy&&, InputIt first, InputIt last)
+    {
+        using T = typename std::iterator_traits<InputIt>::value_type;
+        const std::size_t size = std::distance(first, last);
+
+        std::vector<reproducible_sum<T>> partials = detail::chunkPartials<Policy, reproducible_sum<T>>(size, [&](std::size_t begin, std::size_t end)
+        {
+            reproducible_sum<T> partial;
+            InputIt it = std::next(first, begin);
+            for(std::size_t i = begin; i < end; i++, ++it)
+            {
+                partial += *it;
+            }
+            return partial;
+        });
+
+        reproducible_sum<T> sum;
+        for(const reproducible_sum<T>& partial : partials)
+        {
+            sum += partial;
+        }
+        return sum.result();
+    }
+}
+
+//-------------------------------------------------------------------------------------------------
+// OPENMP
+
+#if defined(_OPENMP) && !defined(NO_SHAMAN)
+#pragma omp declare reduction(+:Shaman::reproducible_sum<Sfloat> : omp_out+=omp_in)
+#pragma omp declare reduction(+:Shaman::reproducible_sum<Sdouble> : omp_out+=omp_in)
+#endif //_OPENMP
+
+//-------------------------------------------------------------------------------------------------
+// MPI
+
+#ifdef MPI_VERSION
+/*
+ * reproducible equivalent of 'MPI_Allreduce(sendbuf, recvbuf, count, datatype, MPI_SSUM, comm)'
+ * the accumulators are reduced with an integer sum which is exact and thus independent of the reduction tree
+ * supports MPI_SFLOAT and MPI_SDOUBLE (and MPI_FLOAT and MPI_DOUBLE when Shaman is disabled)
+ */
+template<typename Stype>
+int MPI_Shaman_Allreduce_reproducible_sum_typed(const void* sendbuf, void* recvbuf, int count, MPI_Comm comm)
+{
+    using Sum = Shaman::reproducible_sum<Stype>;
+
+    // one normalized accumulator per element
+    std::vector<std::int64_t> states(count * Sum::stateSize);
+    for(int i = 0; i < count; i++)
+    {
+        Sum sum;
+        sum += static_cast<const Stype*>(sendbuf)[i];
+        sum.toState(&states[i * Sum::stateSize]);
+    }
+
+    int errorValue = MPI_Allreduce(MPI_IN_PLACE, states.data(), count * Sum::stateSize, MPI_INT64_T, MPI_SUM, comm);
+
+    for(int i = 0; i < count; i++)
+    {
+        Sum sum;
+        sum.fromState(&states[i * Sum::stateSize]);
+        static_cast<Stype*>(recvbuf)[i] = sum.result();
+    }
+    return errorValue;
+}
+
+int MPI_Shaman_Allreduce_reproducible_sum(const void* sendbuf, void* recvbuf, int count, MPI_Datatype datatype, MPI_Comm comm)
+{
+    if (datatype == MPI_SFLOAT)
+    {
+        return MPI_Shaman_Allreduce_reproducible_sum_typed<Sfloat>(sendbuf, recvbuf, count, comm);
+    }
+    else if (datatype == MPI_SDOUBLE)
+    {
+        return MPI_Shaman_Allreduce_reproducible_sum_typed<Sdouble>(sendbuf, recvbuf, count, comm);
+    }
+    else
+    {
+        throw std::invalid_argument("MPI_Shaman_Allreduce_reproducible_sum was called with a type that is neither MPI_SFLOAT nor MPI_SDOUBLE.");
+    }
+}
+#endif //MPI_VERSION
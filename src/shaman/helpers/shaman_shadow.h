@@ -0,0 +1,295 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <algorithm>
+#include <map>
+#include <new>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <shaman/tagged/global_vars.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define SHAMAN_SHADOW_MMAP
+#endif
+
+/*
+ * to use :
+ * - include shaman_shadow.h
+ * - keep your data structures as plain 'float'/'double'/'long double'
+ * - call 'Shaman::shadow_register(data, size)' on the buffers whose error you want to track
+ * - access them through a 'Shaman::ShadowArray' in the kernels you want to instrument
+ *
+ * Shaman::shadow_register(data, size);
+ * Shaman::ShadowArray<double> x(data);
+ * for(std::size_t i = 0; i < size; i++) x[i] = x[i] / 3.; // updates both data[i] and its shadow error
+ * std::cout << Shaman::shadow_value(data[0]) << std::endl; // data[0] with its shadow error
+ * Shaman::shadow_unregister(data);
+ *
+ * Each registered buffer gets a parallel, zero initialised and page-aligned error array (mmap-backed on POSIX systems)
+ * the data itself keeps its layout and cache behaviour.
+ * The elements of a ShadowArray are proxies, use '.value()' to pass them to the Sstd functions.
+ * With tagged error only the total error is kept in shadow memory,
+ * the error read back from a shadow array is attributed to the current block.
+ * With NO_SHAMAN, registration does nothing and a shadow array only accesses the data.
+ */
+namespace Shaman
+{
+    /*
+     * Shaman type used to instrument values of type T stored in shadowed buffers
+     */
+    template<typename T>
+    using shadow_type = decltype(makeStype(T()));
+
+    namespace detail
+    {
+        /*
+         * allocates a zero initialised, page-aligned, array of at least the given size
+         */
+        inline void* shadowAllocate(std::size_t bytes, std::size_t& mappedBytes)
+        {
+            #ifdef SHAMAN_SHADOW_MMAP
+            const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+            mappedBytes = std::max<std::size_t>(1, (bytes + pageSize - 1) / pageSize) * pageSize;
+            // anonymous mappings are filled with zeros
+            void* errors = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(errors == MAP_FAILED) throw std::bad_alloc();
+            return errors;
+            #else
+            mappedBytes = std::max<std::size_t>(1, bytes);
+            void* errors = std::calloc(mappedBytes, 1);
+            if(errors == nullptr) throw std::bad_alloc();
+            return errors;
+            #endif
+        }
+
+        inline void shadowDeallocate(void* errors, std::size_t mappedBytes)
+        {
+            #ifdef SHAMAN_SHADOW_MMAP
+            munmap(errors, mappedBytes);
+            #else
+            std::free(errors);
+            #endif
+        }
+
+        /*
+         * returns the registered buffer containing the address (shadowBuffers.end() if none)
+         * the caller is expected to hold mutexShadowBuffers
+         */
+        inline std::map<const char*, ShadowBuffer>::iterator findShadowBuffer(const void* address)
+        {
+            const char* byte = static_cast<const char*>(address);
+            auto it = ShamanGlobals::shadowBuffers.upper_bound(byte);
+            if(it == ShamanGlobals::shadowBuffers.begin()) return ShamanGlobals::shadowBuffers.end();
+            --it;
+            return (byte < it->first + it->second.bytes) ? it : ShamanGlobals::shadowBuffers.end();
+        }
+    }
+
+    //-------------------------------------------------------------------------------------------------
+    // REGISTRATION
+
+    /*
+     * allocates a shadow error array for [data;data+size[
+     * throws std::invalid_argument if the buffer overlaps an already registered buffer
+     */
+    template<typename T>
+    void shadow_register(T* data, std::size_t size)
+    {
+        static_assert(std::is_floating_point<T>::value, "Shaman::shadow_register expects plain floating point data.");
+        #ifndef NO_SHAMAN
+        const std::size_t bytes = size * sizeof(T);
+        if(bytes == 0) return;
+        const char* first = reinterpret_cast<const char*>(data);
+
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexShadowBuffers);
+        const auto next = ShamanGlobals::shadowBuffers.lower_bound(first);
+        const bool overlapsNext = (next != ShamanGlobals::shadowBuffers.end()) && (next->first < first + bytes);
+        if(overlapsNext or (detail::findShadowBuffer(first) != ShamanGlobals::shadowBuffers.end()))
+        {
+            throw std::invalid_argument("Shaman::shadow_register: the buffer overlaps an already registered buffer.");
+        }
+
+        ShadowBuffer buffer;
+        buffer.bytes = bytes;
+        buffer.errors = detail::shadowAllocate(bytes, buffer.mappedBytes);
+        ShamanGlobals::shadowBuffers[first] = buffer;
+        #endif
+    }
+
+    /*
+     * frees the shadow error array of a buffer (data should be the pointer used to register it)
+     */
+    template<typename T>
+    void shadow_unregister(T* data)
+    {
+        #ifndef NO_SHAMAN
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexShadowBuffers);
+        auto it = ShamanGlobals::shadowBuffers.find(reinterpret_cast<const char*>(data));
+        if(it == ShamanGlobals::shadowBuffers.end()) return;
+        detail::shadowDeallocate(it->second.errors, it->second.mappedBytes);
+        ShamanGlobals::shadowBuffers.erase(it);
+        #endif
+    }
+
+    /*
+     * returns a pointer to the shadow error of the element at the given address (nullptr if it is not in a registered buffer)
+     */
+    template<typename T>
+    T* shadow_errors(const T* address)
+    {
+        #ifdef NO_SHAMAN
+        return nullptr;
+        #else
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexShadowBuffers);
+        auto it = detail::findShadowBuffer(address);
+        if(it == ShamanGlobals::shadowBuffers.end()) return nullptr;
+        const std::size_t offset = reinterpret_cast<const char*>(address) - it->first;
+        return reinterpret_cast<T*>(static_cast<char*>(it->second.errors) + offset);
+        #endif
+    }
+
+    //-------------------------------------------------------------------------------------------------
+    // ACCESS
+
+    namespace detail
+    {
+        template<typename T>
+        inline shadow_type<T> makeShadowValue(T number, T error)
+        {
+            #ifdef NO_SHAMAN
+            return number;
+            #elif defined(SHAMAN_TAGGED_ERROR)
+            error_composants<T> errorComposants;
+            errorComposants.addError(error);
+            return shadow_type<T>(number, error, errorComposants);
+            #else
+            return shadow_type<T>(number, error);
+            #endif
+        }
+    }
+
+    /*
+     * rebuilds the Shaman number of a plain value from its shadow error (which is 0 if the value is not in a registered buffer)
+     */
+    template<typename T>
+    inline shadow_type<T> shadow_value(const T& x)
+    {
+        const T* error = shadow_errors(&x);
+        return detail::makeShadowValue(x, (error == nullptr) ? T() : *error);
+    }
+
+    /*
+     * reference to an element of a shadowed buffer and to its shadow error
+     */
+    template<typename T>
+    class ShadowReference
+    {
+    public:
+        using value_type = shadow_type<T>;
+
+        ShadowReference(T& number, T& error): number_(number), error_(error) {}
+
+        value_type value() const { return detail::makeShadowValue(number_, error_); }
+        operator value_type() const { return value(); }
+
+        ShadowReference& operator=(const value_type& x)
+        {
+            #ifdef NO_SHAMAN
+            number_ = x;
+            #else
+            number_ = x.number;
+            error_ = x.error;
+            #endif
+            return *this;
+        }
+        ShadowReference& operator=(const ShadowReference& x) { return *this = x.value(); }
+
+        ShadowReference& operator+=(const value_type& x) { return *this = value() + x; }
+        ShadowReference& operator-=(const value_type& x) { return *this = value() - x; }
+        ShadowReference& operator*=(const value_type& x) { return *this = value() * x; }
+        ShadowReference& operator/=(const value_type& x) { return *this = value() / x; }
+
+    private:
+        T& number_;
+        T& error_;
+    };
+
+    /*
+     * view on a registered buffer that updates both its values and their shadow errors
+     * throws std::invalid_argument if data is not in a registered buffer
+     */
+    template<typename T>
+    class ShadowArray
+    {
+    public:
+        using value_type = shadow_type<T>;
+
+        explicit ShadowArray(T* data): data_(data), errors_(shadow_errors(data))
+        {
+            #ifndef NO_SHAMAN
+            if(errors_ == nullptr)
+            {
+                throw std::invalid_argument("Shaman::ShadowArray: the data was not registered with Shaman::shadow_register.");
+            }
+            #endif
+        }
+
+        #ifdef NO_SHAMAN
+        // there is no error to track, the reference never touches its error
+        ShadowReference<T> operator[](std::size_t i) const { return ShadowReference<T>(data_[i], data_[i]); }
+        #else
+        ShadowReference<T> operator[](std::size_t i) const { return ShadowReference<T>(data_[i], errors_[i]); }
+        #endif
+
+        T* data() const { return data_; }
+        T* errors() const { return errors_; }
+
+    private:
+        T* data_;
+        T* errors_;
+    };
+
+    //-------------------------------------------------------------------------------------------------
+    // OPERATORS
+
+    /*
+     * lets the shadow references be used as operands without explicit conversion
+     */
+    #define set_shadow_operator(OPERATOR) \
+    template<typename T, typename U> \
+    inline auto operator OPERATOR (const ShadowReference<T>& x, const U& y) -> decltype(x.value() OPERATOR y) \
+    { \
+        return x.value() OPERATOR y; \
+    } \
+    template<typename T, typename U> \
+    inline auto operator OPERATOR (const U& x, const ShadowReference<T>& y) -> decltype(x OPERATOR y.value()) \
+    { \
+        return x OPERATOR y.value(); \
+    } \
+    template<typename T1, typename T2> \
+    inline auto operator OPERATOR (const ShadowReference<T1>& x, const ShadowReference<T2>& y) -> decltype(x.value() OPERATOR y.value()) \
+    { \
+        return x.value() OPERATOR y.value(); \
+    } \
+
+    set_shadow_operator(+)
+    set_shadow_operator(-)
+    set_shadow_operator(*)
+    set_shadow_operator(/)
+    set_shadow_operator(==)
+    set_shadow_operator(!=)
+    set_shadow_operator(<)
+    set_shadow_operator(<=)
+    set_shadow_operator(>)
+    set_shadow_operator(>=)
+
+    #undef set_shadow_operator
+
+    template<typename T>
+    inline shadow_type<T> operator-(const ShadowReference<T>& x) { return -x.value(); }
+}
+
+#undef SHAMAN_SHADOW_MMAP
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+#include <experimental/simd>
+
+#ifdef SHAMAN_PACKED
+#error "The lane types need their natural alignment, shaman_simd.h cannot be used with the SHAMAN_PACKED flag."
+#endif
+#ifdef SHAMAN_TAPE
+#error "The error tape stores one operation per number, shaman_simd.h cannot be used with the SHAMAN_TAPE flag."
+#endif
+#if defined(SHAMAN_POOLED_ERROR) || defined(SHAMAN_TOPK_ERROR)
+#error "The lanes access the error composants in place, shaman_simd.h cannot be used with the SHAMAN_POOLED_ERROR or SHAMAN_TOPK_ERROR flags."
+#endif
+
+/*
+ * to use :
+ * - include shaman_simd.h
+ * - write your explicitly vectorized kernels with 'Shaman::Ssimd<double>' (a S over 'std::experimental::native_simd<double>')
+ *
+ * Shaman::Ssimd<double> x = Shaman::simd_load<double>(values); // loads Sdouble values
+ * Shaman::Ssimd<double> y = Sstd::sqrt(x * x + 1.);
+ * auto mask = y > x; // lane-wise comparison, the unstable lanes are counted one by one
+ * y = Shaman::select(mask, y, x);
+ * Shaman::simd_store(y, values); // stores Sdouble values
+ *
+ * Each object carries the numbers and errors of all its lanes, the arithmetic operators work as for the scalar types.
+ * Comparisons return a 'simd_mask' and each lane goes through the unstable branch detection.
+ * Only sqrt, abs, fabs, fma, min and max are available in Sstd for lane types,
+ * use 'Shaman::lane' to get a scalar Shaman number when you need another function.
+ * The EFT used by the lane types are not protected against reassociation, do not compile them with -ffast-math.
+ * The lane types are ignored by the precision advisor and the SHAMAN_FLUSH_NANINF flag is not supported on them.
+ */
+namespace Shaman
+{
+    #ifdef NO_SHAMAN
+    template<typename T, typename Abi = std::experimental::simd_abi::native<T>>
+    using Ssimd = std::experimental::simd<T,Abi>;
+
+    template<typename T, typename Abi>
+    inline T lane(const Ssimd<T,Abi>& x, std::size_t i) { return x[i]; }
+
+    template<typename T, typename Abi>
+    inline void set_lane(Ssimd<T,Abi>& x, std::size_t i, T value) { x[i] = value; }
+
+    template<typename T, typename Abi = std::experimental::simd_abi::native<T>>
+    inline Ssimd<T,Abi> simd_load(const T* values) { return Ssimd<T,Abi>(values, std::experimental::element_aligned); }
+
+    template<typename T, typename Abi>
+    inline void simd_store(const Ssimd<T,Abi>& x, T* values) { x.copy_to(values, std::experimental::element_aligned); }
+
+    template<typename T, typename Abi>
+    inline Ssimd<T,Abi> select(const typename Ssimd<T,Abi>::mask_type& mask, const Ssimd<T,Abi>& x1, const Ssimd<T,Abi>& x2)
+    {
+        Ssimd<T,Abi> result = x2;
+        std::experimental::where(mask, result) = x1;
+        return result;
+    }
+    #else
+    /*
+     * S over a lane type, all lanes use the same type for their number, error and precise number
+     */
+    template<typename T, typename Abi = std::experimental::simd_abi::native<T>>
+    using Ssimd = S<std::experimental::simd<T,Abi>, std::experimental::simd<T,Abi>, std::experimental::simd<T,Abi>>;
+
+    /*
+     * returns the Shaman number stored in the given lane
+     */
+    template<typename T, typename Abi>
+    inline decltype(makeStype(T())) lane(const Ssimd<T,Abi>& x, std::size_t i)
+    {
+        using Stype = decltype(makeStype(T()));
+        #ifdef SHAMAN_TAGGED_ERROR
+        using errorType = decltype(Stype().error);
+        error_sum<errorType> errorComposants;
+        for(std::size_t tag = 0; tag < errorComposants.errors.size(); tag++)
+        {
+            errorComposants.errors[tag] = x.errorComposants.errors[tag][i];
+        }
+        return Stype(x.number[i], x.error[i], errorComposants);
+        #else
+        return Stype(x.number[i], x.error[i]);
+        #endif
+    }
+
+    /*
+     * stores a Shaman number in the given lane
+     */
+    template<typename T, typename Abi, typename Stype>
+    inline void set_lane(Ssimd<T,Abi>& x, std::size_t i, const Stype& value)
+    {
+        x.number[i] = value.number;
+        x.error[i] = value.error;
+        #ifdef SHAMAN_TAGGED_ERROR
+        for(std::size_t tag = 0; tag < x.errorComposants.errors.size(); tag++)
+        {
+            x.errorComposants.errors[tag][i] = value.errorComposants.errors[tag];
+        }
+        #endif
+    }
+
+    /*
+     * returns a lane type filled with the Shaman numbers found at values[0], ..., values[size-1]
+     */
+    template<typename T, typename Abi = std::experimental::simd_abi::native<T>, typename Stype>
+    inline Ssimd<T,Abi> simd_load(const Stype* values)
+    {
+        Ssimd<T,Abi> x;
+        for(std::size_t i = 0; i < x.number.size(); i++) set_lane(x, i, values[i]);
+        return x;
+    }
+
+    /*
+     * stores all the lanes of x into values[0], ..., values[size-1]
+     */
+    template<typename T, typename Abi, typename Stype>
+    inline void simd_store(const Ssimd<T,Abi>& x, Stype* values)
+    {
+        for(std::size_t i = 0; i < x.number.size(); i++) values[i] = lane(x, i);
+    }
+
+    /*
+     * lane-wise x[i] = mask[i] ? x1[i] : x2[i]
+     */
+    template<typename T, typename Abi>
+    inline Ssimd<T,Abi> select(const typename std::experimental::simd<T,Abi>::mask_type& mask, const Ssimd<T,Abi>& x1, const Ssimd<T,Abi>& x2)
+    {
+        Ssimd<T,Abi> result = x2;
+        std::experimental::where(mask, result.number) = x1.number;
+        std::experimental::where(mask, result.error) = x1.error;
+        #ifdef SHAMAN_TAGGED_ERROR
+        for(std::size_t tag = 0; tag < result.errorComposants.errors.size(); tag++)
+        {
+            std::experimental::where(mask, result.errorComposants.errors[tag]) = x1.errorComposants.errors[tag];
+        }
+        #endif
+        return result;
+    }
+
+    /*
+     * lane-wise equivalent of S::checkUnstableBranch
+     * each unstable lane counts as an unstable branch
+     */
+    template<typename T, typename Abi>
+    inline void checkUnstableLanes(const Ssimd<T,Abi>& n1, const Ssimd<T,Abi>& n2)
+    {
+        #ifdef SHAMAN_UNSTABLE_BRANCH
+        const std::experimental::simd<T,Abi> difference = n1.number - n2.number;
+        const std::experimental::simd<T,Abi> differenceError = n1.error - n2.error;
+        const T base = T(ShamanGlobals::session().significanceBase);
+        const auto isUnstable = (differenceError != 0) && (std::experimental::abs(difference) < base * std::experimental::abs(differenceError));
+        for(int i = std::experimental::popcount(isUnstable); i > 0; i--)
+        {
+            Shaman::unstability();
+        }
+        #else
+        (void)n1;
+        (void)n2;
+        #endif
+    }
+    #endif //NO_SHAMAN
+}
+
+#ifdef NO_SHAMAN
+
+// Sstd is std, we expose the lane type functions there
+namespace std
+{
+    using std::experimental::sqrt;
+    using std::experimental::abs;
+    using std::experimental::fabs;
+    using std::experimental::fma;
+    using std::experimental::min;
+    using std::experimental::max;
+}
+
+#else
+
+//-------------------------------------------------------------------------------------------------
+// COMPARISONS
+
+/*
+ * the comparisons of lane types return masks
+ * (they are more specialized than the scalar operators and thus take precedence)
+ */
+#define set_simd_comparison(OPERATOR) \
+template<typename T, typename Abi> \
+inline typename std::experimental::simd<T,Abi>::mask_type operator OPERATOR (const Shaman::Ssimd<T,Abi>& n1, const Shaman::Ssimd<T,Abi>& n2) \
+{ \
+    Shaman::checkUnstableLanes(n1, n2); \
+    return n1.number OPERATOR n2.number; \
+} \
+template<typename T, typename Abi, typename U, typename = typename std::enable_if<std::is_arithmetic<U>::value, U>::type> \
+inline typename std::experimental::simd<T,Abi>::mask_type operator OPERATOR (const Shaman::Ssimd<T,Abi>& n1, const U& n2) \
+{ \
+    return n1 OPERATOR Shaman::Ssimd<T,Abi>(std::experimental::simd<T,Abi>(T(n2))); \
+} \
+template<typename T, typename Abi, typename U, typename = typename std::enable_if<std::is_arithmetic<U>::value, U>::type> \
+inline typename std::experimental::simd<T,Abi>::mask_type operator OPERATOR (const U& n1, const Shaman::Ssimd<T,Abi>& n2) \
+{ \
+    return Shaman::Ssimd<T,Abi>(std::experimental::simd<T,Abi>(T(n1))) OPERATOR n2; \
+} \
+
+set_simd_comparison(==)
+set_simd_comparison(!=)
+set_simd_comparison(<)
+set_simd_comparison(<=)
+set_simd_comparison(>)
+set_simd_comparison(>=)
+
+#undef set_simd_comparison
+
+/*
+ * displays the lanes one by one
+ */
+template<typename T, typename Abi>
+std::ostream& operator<<(std::ostream& os, const Shaman::Ssimd<T,Abi>& n)
+{
+    os << '[';
+    for(std::size_t i = 0; i < n.number.size(); i++)
+    {
+        if(i != 0) os << ", ";
+        os << Shaman::lane(n, i);
+    }
+    return os << ']';
+}
+
+//-------------------------------------------------------------------------------------------------
+// FUNCTIONS
+
+namespace Sstd
+{
+    template<typename T, typename Abi>
+    inline Shaman::Ssimd<T,Abi> sqrt(const Shaman::Ssimd<T,Abi>& n)
+    {
+        using lane_type = std::experimental::simd<T,Abi>;
+        const lane_type result = std::experimental::sqrt(n.number);
+        const lane_type remainder = EFT::RemainderSqrt(n.number, result);
+        // a null result has an error of sqrt(|error|) (see the scalar sqrt)
+        const auto isZero = (result == 0);
+        lane_type divisor = result + result;
+        std::experimental::where(isZero, divisor) = lane_type(1);
+        lane_type newError = (remainder + n.error) / divisor;
+        std::experimental::where(isZero, newError) = std::experimental::sqrt(std::experimental::abs(n.error));
+        #ifdef SHAMAN_TAGGED_ERROR
+        // the composants of the null lanes are scaled to sum to their new error
+        lane_type scaling = 1 / divisor;
+        std::experimental::where(isZero && (n.error != 0), scaling) = newError / n.error;
+        error_sum<lane_type> newErrorComp(n.errorComposants);
+        newErrorComp.addError(remainder);
+        newErrorComp.multByScalar(scaling);
+        return Shaman::Ssimd<T,Abi>(result, newError, newErrorComp);
+        #else
+        return Shaman::Ssimd<T,Abi>(result, newError);
+        #endif
+    }
+
+    template<typename T, typename Abi>
+    inline Shaman::Ssimd<T,Abi> abs(const Shaman::Ssimd<T,Abi>& n)
+    {
+        return Shaman::select(n.number < 0, -n, n);
+    }
+
+    template<typename T, typename Abi>
+    inline Shaman::Ssimd<T,Abi> fabs(const Shaman::Ssimd<T,Abi>& n)
+    {
+        return abs(n);
+    }
+
+    template<typename T, typename Abi>
+    inline Shaman::Ssimd<T,Abi> fma(const Shaman::Ssimd<T,Abi>& n1, const Shaman::Ssimd<T,Abi>& n2, const Shaman::Ssimd<T,Abi>& n3)
+    {
+        using lane_type = std::experimental::simd<T,Abi>;
+        const lane_type result = std::experimental::fma(n1.number, n2.number, n3.number);
+        const lane_type remainder = EFT::ErrorFma(n1.number, n2.number, n3.number, result);
+        const lane_type newError = std::experimental::fma(n2.number, n1.error, std::experimental::fma(n1.number, n2.error, remainder + n3.error));
+        #ifdef SHAMAN_TAGGED_ERROR
+        const lane_type number1 = n1.number;
+        const lane_type number2 = n2.number;
+        error_sum<lane_type> newErrorComp(n1.errorComposants, n2.errorComposants, [number1, number2](lane_type e1, lane_type e2){return number1*e2 + number2*e1;});
+        newErrorComp.addErrors(n3.errorComposants);
+        newErrorComp.addError(remainder);
+        return Shaman::Ssimd<T,Abi>(result, newError, newErrorComp);
+        #else
+        return Shaman::Ssimd<T,Abi>(result, newError);
+        #endif
+    }
+
+    template<typename T, typename Abi>
+    inline Shaman::Ssimd<T,Abi> min(const Shaman::Ssimd<T,Abi>& n1, const Shaman::Ssimd<T,Abi>& n2)
+    {
+        return Shaman::select(n1 < n2, n1, n2);
+    }
+
+    template<typename T, typename Abi>
+    inline Shaman::Ssimd<T,Abi> max(const Shaman::Ssimd<T,Abi>& n1, const Shaman::Ssimd<T,Abi>& n2)
+    {
+        return Shaman::select(n1 > n2, n1, n2);
+    }
+}
+
+#endif //NO_SHAMAN
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <iterator>
+#include <iostream>
+#include <algorithm>
+#include <shaman/tagged/global_vars.h>
+
+/*
+ * to use :
+ * - compile with the SHAMAN_TAGGED_ERROR and SHAMAN_TAPE flags
+ * - include shaman_tape.h
+ * - run your code as usual, the operations are recorded on a per thread tape
+ *
+ * std::cout << result << std::endl; // the error of result attributed to the tags (reverse sweep of the tape)
+ * Shaman::displayTapeContributions(result); // the individual operations that contributed the most to the error of result
+ * Shaman::tape_checkpoint(state.begin(), state.end()); // shrinks the tapes, keeping only the attribution of the state
+ *
+ * Without SHAMAN_TAPE these functions do nothing (tape_contributions returns no operation).
+ */
+namespace Shaman
+{
+    /*
+     * part of the error of a number due to a single operation
+     */
+    struct TapeContribution
+    {
+        Tag tag; // block in which the operation was performed
+        std::size_t thread; // index of the tape (one per thread, in order of first use) on which the operation was recorded
+        std::size_t operation; // index of the operation on its tape
+        double error; // part of the error of the number due to the operation
+    };
+
+    /*
+     * number of operations currently recorded on the tapes of all the threads
+     */
+    inline std::size_t tape_size()
+    {
+        std::size_t size = 0;
+        #ifdef SHAMAN_TAPE
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexTapes);
+        for(const auto& tape : ShamanGlobals::tapes)
+        {
+            size += tape->size;
+        }
+        #endif
+        return size;
+    }
+
+    /*
+     * returns the (at most) 'number' operations that contributed the most to the error of the output, largest first
+     */
+    template<typename Stype>
+    std::vector<TapeContribution> tape_contributions(const Stype& output, std::size_t number)
+    {
+        std::vector<TapeContribution> contributions;
+        #ifdef SHAMAN_TAPE
+        std::vector<std::pair<const TapeNode*, double>> operations;
+        detail::sweepTape(output.errorComposants.node, [&operations](const TapeNode& operation, double error)
+        {
+            operations.emplace_back(&operation, error);
+        });
+
+        number = std::min(number, operations.size());
+        std::partial_sort(operations.begin(), operations.begin() + number, operations.end(),
+                          [](const std::pair<const TapeNode*, double>& op1, const std::pair<const TapeNode*, double>& op2)
+                          {return std::abs(op1.second) > std::abs(op2.second);});
+
+        // finds the tape holding each operation
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexTapes);
+        for(std::size_t i = 0; i < number; i++)
+        {
+            const TapeNode* node = operations[i].first;
+            TapeContribution contribution = {node->tag, 0, 0, operations[i].second};
+            for(std::size_t thread = 0; thread < ShamanGlobals::tapes.size(); thread++)
+            {
+                const std::size_t index = ShamanGlobals::tapes[thread]->indexOf(node);
+                if(index < ShamanGlobals::tapes[thread]->size)
+                {
+                    contribution.thread = thread;
+                    contribution.operation = index;
+                    break;
+                }
+            }
+            contributions.push_back(contribution);
+        }
+        #endif
+        return contributions;
+    }
+
+    /*
+     * displays the (at most) 'number' operations that contributed the most to the error of the output
+     */
+    template<typename Stype>
+    void displayTapeContributions(const Stype& output, std::size_t number = 10)
+    {
+        Shaman::Session::ReportWriter report = ShamanGlobals::session().report();
+        #ifdef SHAMAN_TAPE
+        const double error = double(output.error);
+        report << "#SHAMAN: Largest contributions to an error of " << error << " :" << std::endl;
+        for(const TapeContribution& contribution : tape_contributions(output, number))
+        {
+            report << " -> operation " << contribution.operation << " of thread " << contribution.thread
+                      << " in section '" << CodeBlock::nameOfTag(contribution.tag) << "' : " << contribution.error
+                      << " (" << 100. * contribution.error / error << "%)" << std::endl;
+        }
+        #else
+        report << "#SHAMAN: please set the 'SHAMAN_TAPE' flag in order to attribute errors to individual operations." << std::endl;
+        #endif
+    }
+
+    /*
+     * shrinks the tapes of all the threads while keeping the attribution (to the tags) of the numbers in [first;last[
+     * each of these numbers is left with one operation per tag that contributed to its error
+     *
+     * WARNING the attribution of the numbers that are not in [first;last[ is lost (they must not be displayed nor used afterward)
+     * WARNING no other thread should be computing on Shaman numbers during the checkpoint
+     */
+    template<typename Iterator>
+    void tape_checkpoint(Iterator first, Iterator last)
+    {
+        #ifdef SHAMAN_TAPE
+        // attributes the errors of the numbers to the tags
+        std::vector<std::map<Tag, double>> composants;
+        for(Iterator it = first; it != last; ++it)
+        {
+            std::map<Tag, double> valueComposants;
+            detail::sweepTape(it->errorComposants.node, [&valueComposants](const TapeNode& operation, double error)
+            {
+                valueComposants[operation.tag] += error;
+            });
+            composants.push_back(std::move(valueComposants));
+        }
+
+        // clears the tapes (their memory is kept for later operations)
+        {
+            std::lock_guard<std::mutex> guard(ShamanGlobals::mutexTapes);
+            for(const auto& tape : ShamanGlobals::tapes)
+            {
+                tape->size = 0;
+            }
+        }
+
+        // records the attribution of the numbers on the fresh tape
+        std::size_t index = 0;
+        for(Iterator it = first; it != last; ++it, ++index)
+        {
+            const TapeNode* node = nullptr;
+            for(const auto& composant : composants[index])
+            {
+                node = detail::recordOperation(node, 1, nullptr, 0, composant.second, composant.first);
+            }
+            it->errorComposants.node = node;
+            it->errorComposants.ownsNode = false;
+        }
+        #endif
+    }
+}
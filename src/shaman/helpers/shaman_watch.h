@@ -0,0 +1,362 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <limits>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <shaman/tagged/global_vars.h>
+
+/*
+ * to use :
+ * - include shaman_watch.h
+ * - open a watch file, each sample is then recorded in a per thread ring buffer that a background thread streams to the file
+ *
+ * Shaman::watch_open("run.shw"); // starts recording
+ * for(std::size_t step = 0; step < stepNumber; step++)
+ * {
+ *     Shaman::watch_step(step); // the step stored with the following samples
+ *     ...
+ *     Shaman::watch("residual", residual); // a few stores
+ * }
+ * Shaman::watch_close(); // flushes the buffers and closes the file (done automatically at exit)
+ *
+ * Use 'tools/shaman_watch/shaman_watch.py run.shw' to display or plot the samples.
+ * In hot loops, a 'Shaman::WatchedVariable' avoids looking up the name of the variable at each sample.
+ * When the flusher cannot keep up, the samples that do not fit in a buffer are dropped (their number is displayed on closing).
+ * With NO_SHAMAN, the numbers are recorded with a zero error.
+ *
+ * File format (native endianness) : the 8 bytes "SHAMANW1" followed by a sequence of records starting with a uint32
+ * (the name of a variable might be written after its first samples) :
+ * - name of a variable : 0x80000000 | variable, uint32 length, the 'length' characters of the name
+ * - sample : variable, uint32 thread, uint64 step, double number, double error, float digits
+ */
+namespace Shaman
+{
+    namespace detail
+    {
+        // a value recorded by Shaman::watch
+        struct WatchSample
+        {
+            std::uint32_t variable;
+            std::uint64_t step;
+            double number;
+            double error;
+        };
+
+        /*
+         * number of significant digits of a sample (see Snum::digits)
+         */
+        inline float watchDigits(double number, double error)
+        {
+            if(error == 0) return INFINITY;
+            if(std::isnan(error)) return 0;
+            if(number == 0) return float(std::max(0., -std::log10(std::abs(error)) - 1));
+            const double relativeError = std::abs(error / number);
+            return (relativeError >= 1) ? 0.f : float(-std::log10(relativeError));
+        }
+    }
+
+    /*
+     * single producer (the thread) single consumer (the flusher) ring buffer of samples
+     */
+    class WatchBuffer
+    {
+    public:
+        std::vector<detail::WatchSample> samples; // the size is a power of two
+        std::atomic<std::uint64_t> head; // number of samples written by the thread
+        std::atomic<std::uint64_t> tail; // number of samples read by the flusher
+        std::atomic<std::uint64_t> dropped; // number of samples that did not fit in the buffer
+        std::uint32_t thread; // index of the thread (in order of first sample)
+
+        WatchBuffer(std::size_t capacity, std::uint32_t threadIndex): samples(capacity), head(0), tail(0), dropped(0), thread(threadIndex) {}
+
+        inline void push(std::uint32_t variable, std::uint64_t step, double number, double error)
+        {
+            const std::uint64_t position = head.load(std::memory_order_relaxed);
+            if(position - tail.load(std::memory_order_acquire) >= samples.size())
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            detail::WatchSample& sample = samples[position & (samples.size() - 1)];
+            sample.variable = variable;
+            sample.step = step;
+            sample.number = number;
+            sample.error = error;
+            head.store(position + 1, std::memory_order_release);
+        }
+    };
+
+    /*
+     * state of an open watch file : the names of the variables, the buffers of the threads and the flusher
+     */
+    class WatchRecorder
+    {
+    public:
+        const std::size_t capacity; // number of samples per buffer
+        const std::uint64_t session; // identifies the recorder in the buffers cached by the threads
+        std::atomic<std::uint64_t> step;
+        std::vector<std::shared_ptr<WatchBuffer>> buffers;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, std::uint32_t> nameEncryptor;
+        std::mutex mutex; // guards buffers, names and nameEncryptor
+
+        WatchRecorder(std::FILE* outputFile, std::size_t bufferCapacity, std::uint64_t sessionIndex):
+            capacity(bufferCapacity), session(sessionIndex), step(0), file(outputFile), writtenNames(0), running(true)
+        {
+            std::fwrite("SHAMANW1", 1, 8, file);
+            flusher = std::thread([this](){flushLoop();});
+        }
+
+        ~WatchRecorder()
+        {
+            {
+                std::lock_guard<std::mutex> guard(flusherMutex);
+                running = false;
+            }
+            wakeUp.notify_one();
+            flusher.join();
+            flush();
+
+            std::uint64_t dropped = 0;
+            for(const auto& buffer : buffers) dropped += buffer->dropped.load();
+            if(dropped > 0)
+            {
+                std::cerr << "#SHAMAN: " << dropped << " watched samples were dropped, please increase the capacity given to Shaman::watch_open." << std::endl;
+            }
+            std::fclose(file);
+        }
+
+        /*
+         * returns the index of a variable
+         */
+        std::uint32_t variableOfName(const std::string& name)
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            auto potentialVariable = nameEncryptor.find(name);
+            if(potentialVariable != nameEncryptor.end()) return potentialVariable->second;
+            const std::uint32_t variable = std::uint32_t(names.size());
+            names.push_back(name);
+            nameEncryptor[name] = variable;
+            return variable;
+        }
+
+        /*
+         * returns a new buffer for the current thread
+         */
+        std::shared_ptr<WatchBuffer> newBuffer()
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            buffers.push_back(std::make_shared<WatchBuffer>(capacity, std::uint32_t(buffers.size())));
+            return buffers.back();
+        }
+
+    private:
+        std::FILE* file;
+        std::size_t writtenNames; // number of names already written to the file
+        bool running;
+        std::mutex flusherMutex; // guards running
+        std::condition_variable wakeUp;
+        std::thread flusher;
+
+        void flushLoop()
+        {
+            std::unique_lock<std::mutex> lock(flusherMutex);
+            while(running)
+            {
+                wakeUp.wait_for(lock, std::chrono::milliseconds(10));
+                lock.unlock();
+                flush();
+                lock.lock();
+            }
+        }
+
+        /*
+         * writes the new names and the samples available in the buffers
+         * (only called by the flusher, or once it is stopped)
+         */
+        void flush()
+        {
+            std::vector<std::shared_ptr<WatchBuffer>> currentBuffers;
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                for(; writtenNames < names.size(); writtenNames++)
+                {
+                    const std::uint32_t header[2] = {std::uint32_t(0x80000000u | writtenNames), std::uint32_t(names[writtenNames].size())};
+                    std::fwrite(header, sizeof(std::uint32_t), 2, file);
+                    std::fwrite(names[writtenNames].data(), 1, names[writtenNames].size(), file);
+                }
+                currentBuffers = buffers;
+            }
+
+            for(const auto& buffer : currentBuffers)
+            {
+                const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+                std::uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+                for(; tail < head; tail++)
+                {
+                    const detail::WatchSample& sample = buffer->samples[tail & (buffer->samples.size() - 1)];
+                    const float digits = detail::watchDigits(sample.number, sample.error);
+                    const std::uint32_t ids[2] = {sample.variable, buffer->thread};
+                    std::fwrite(ids, sizeof(std::uint32_t), 2, file);
+                    std::fwrite(&sample.step, sizeof(std::uint64_t), 1, file);
+                    std::fwrite(&sample.number, sizeof(double), 1, file);
+                    std::fwrite(&sample.error, sizeof(double), 1, file);
+                    std::fwrite(&digits, sizeof(float), 1, file);
+                }
+                buffer->tail.store(tail, std::memory_order_release);
+            }
+            std::fflush(file);
+        }
+    };
+
+    namespace detail
+    {
+        // buffer of the current thread and the names it already looked up
+        struct LocalWatch
+        {
+            std::uint64_t session = 0;
+            std::shared_ptr<WatchBuffer> buffer;
+            std::unordered_map<const char*, std::uint32_t> variables; // keyed on the address of the name
+        };
+
+        inline LocalWatch& localWatch()
+        {
+            thread_local LocalWatch local;
+            return local;
+        }
+
+        /*
+         * returns the buffer of the current thread (nullptr if no watch file is open)
+         */
+        inline WatchBuffer* localWatchBuffer()
+        {
+            const std::shared_ptr<WatchRecorder>& recorder = ShamanGlobals::watchRecorder;
+            if(not recorder) return nullptr;
+            LocalWatch& local = localWatch();
+            if(local.session != recorder->session)
+            {
+                local.session = recorder->session;
+                local.buffer = recorder->newBuffer();
+                local.variables.clear();
+            }
+            return local.buffer.get();
+        }
+
+        template<typename Stype>
+        inline void watchSample(WatchBuffer* buffer, std::uint32_t variable, const Stype& x)
+        {
+            const std::uint64_t step = ShamanGlobals::watchRecorder->step.load(std::memory_order_relaxed);
+            #ifdef NO_SHAMAN
+            buffer->push(variable, step, double(x), 0.);
+            #else
+            buffer->push(variable, step, double(x.number), double(x.error));
+            #endif
+        }
+    }
+
+    /*
+     * opens a watch file, capacity is the number of samples each thread can buffer (rounded up to a power of two)
+     * a zero capacity uses the capacity of the session (SHAMAN_WATCH_CAPACITY, 2^16 by default)
+     * returns false if the file could not be opened
+     * NOTE: no thread should be watching a variable while a file is opened or closed
+     */
+    inline bool watch_open(const std::string& path, std::size_t capacity = 0)
+    {
+        std::FILE* file = std::fopen(path.c_str(), "wb");
+        if(file == nullptr) return false;
+        if(capacity == 0) capacity = ShamanGlobals::session().watchCapacity;
+        std::size_t bufferCapacity = 1;
+        while(bufferCapacity < capacity) bufferCapacity *= 2;
+        static std::uint64_t sessionNumber = 0; // sessions are never reused, a thread might still cache the buffer of a closed one
+        const std::uint64_t session = ++sessionNumber;
+        ShamanGlobals::watchRecorder.reset();
+        ShamanGlobals::watchRecorder = std::make_shared<WatchRecorder>(file, bufferCapacity, session);
+        return true;
+    }
+
+    /*
+     * writes the remaining samples and closes the watch file
+     */
+    inline void watch_close()
+    {
+        ShamanGlobals::watchRecorder.reset();
+    }
+
+    /*
+     * sets the step stored with the following samples (of all the threads)
+     */
+    inline void watch_step(std::uint64_t step)
+    {
+        if(ShamanGlobals::watchRecorder) ShamanGlobals::watchRecorder->step.store(step, std::memory_order_relaxed);
+    }
+
+    /*
+     * handle on a watched variable, its name is looked up once
+     */
+    class WatchedVariable
+    {
+    public:
+        explicit WatchedVariable(const std::string& name): name_(name), session_(0), variable_(0) {}
+
+        template<typename Stype>
+        void operator()(const Stype& x)
+        {
+            WatchBuffer* buffer = detail::localWatchBuffer();
+            if(buffer == nullptr) return;
+            if(session_ != ShamanGlobals::watchRecorder->session)
+            {
+                session_ = ShamanGlobals::watchRecorder->session;
+                variable_ = ShamanGlobals::watchRecorder->variableOfName(name_);
+            }
+            detail::watchSample(buffer, variable_, x);
+        }
+
+    private:
+        std::string name_;
+        std::uint64_t session_;
+        std::uint32_t variable_;
+    };
+
+    /*
+     * records a sample of the variable (its number, error and digits at the current step)
+     * NOTE: the name is cached by address, it should be a string literal (or outlive the watch file with the same content)
+     */
+    template<typename Stype>
+    void watch(const char* name, const Stype& x)
+    {
+        WatchBuffer* buffer = detail::localWatchBuffer();
+        if(buffer == nullptr) return;
+        auto& variables = detail::localWatch().variables;
+        auto cached = variables.find(name);
+        if(cached == variables.end())
+        {
+            const std::uint32_t variable = ShamanGlobals::watchRecorder->variableOfName(name);
+            cached = variables.emplace(name, variable).first;
+        }
+        detail::watchSample(buffer, cached->second, x);
+    }
+
+    /*
+     * records a sample of a variable whose name is built at runtime
+     * NOTE: the name is looked up at each sample, prefer a 'Shaman::WatchedVariable' in hot loops
+     */
+    template<typename Stype>
+    void watch(const std::string& name, const Stype& x)
+    {
+        WatchBuffer* buffer = detail::localWatchBuffer();
+        if(buffer == nullptr) return;
+        detail::watchSample(buffer, ShamanGlobals::watchRecorder->variableOfName(name), x);
+    }
+}
@@ -0,0 +1,5 @@
+// compiles the explicit instantiations declared 'extern' in instantiations.h
+#define SHAMAN_INSTANTIATING
+#include <shaman.h>
+
+SHAMAN_INSTANTIATIONS()
@@ -0,0 +1,80 @@
+#pragma once
+
+/*
+ * explicit instantiations of the functions of Shaman that are not inline (see functions.h and methods.h)
+ * for Sfloat, Sdouble and Slong_double
+ *
+ * with the SHAMAN_EXTERN_TEMPLATES flag (SHAMAN_ENABLE_EXTERN_TEMPLATES with cmake), they are declared 'extern'
+ * and compiled once in the shaman library (instantiations.cpp) rather than in every translation unit using them
+ * the inline arithmetic (operators.h) stays header-only
+ *
+ * NOTE: the library must be compiled with the same Shaman flags as the code using it (cmake propagates them)
+ */
+
+// functions taking a single S
+#define SHAMAN_UNARY_INSTANTIATIONS(EXTERN, Stype) \
+    EXTERN template const Stype Sstd::cos(const Stype&); \
+    EXTERN template const Stype Sstd::sin(const Stype&); \
+    EXTERN template const Stype Sstd::tan(const Stype&); \
+    EXTERN template const Stype Sstd::atan(const Stype&); \
+    EXTERN template const Stype Sstd::acos(const Stype&); \
+    EXTERN template const Stype Sstd::asin(const Stype&); \
+    EXTERN template const Stype Sstd::cosh(const Stype&); \
+    EXTERN template const Stype Sstd::sinh(const Stype&); \
+    EXTERN template const Stype Sstd::tanh(const Stype&); \
+    EXTERN template const Stype Sstd::asinh(const Stype&); \
+    EXTERN template const Stype Sstd::acosh(const Stype&); \
+    EXTERN template const Stype Sstd::atanh(const Stype&); \
+    EXTERN template const Stype Sstd::exp(const Stype&); \
+    EXTERN template const Stype Sstd::exp2(const Stype&); \
+    EXTERN template const Stype Sstd::expm1(const Stype&); \
+    EXTERN template const Stype Sstd::ilogb(const Stype&); \
+    EXTERN template const Stype Sstd::log(const Stype&); \
+    EXTERN template const Stype Sstd::log10(const Stype&); \
+    EXTERN template const Stype Sstd::log1p(const Stype&); \
+    EXTERN template const Stype Sstd::log2(const Stype&); \
+    EXTERN template const Stype Sstd::logb(const Stype&); \
+    EXTERN template const Stype Sstd::cbrt(const Stype&); \
+    EXTERN template const Stype Sstd::sqrt(const Stype&); \
+    EXTERN template const Stype Sstd::erf(const Stype&); \
+    EXTERN template const Stype Sstd::erfc(const Stype&); \
+    EXTERN template const Stype Sstd::tgamma(const Stype&); \
+    EXTERN template const Stype Sstd::lgamma(const Stype&); \
+    EXTERN template const Stype Sstd::ceil(const Stype&); \
+    EXTERN template const Stype Sstd::floor(const Stype&); \
+    EXTERN template const Stype Sstd::trunc(const Stype&); \
+    EXTERN template const Stype Sstd::round(const Stype&); \
+    EXTERN template const Stype Sstd::rint(const Stype&); \
+    EXTERN template const Stype Sstd::nearbyint(const Stype&);
+
+// functions taking several S or additional arguments
+#define SHAMAN_OTHER_INSTANTIATIONS(EXTERN, Stype) \
+    EXTERN template const Stype Sstd::atan2(const Stype&, const Stype&); \
+    EXTERN template const Stype Sstd::pow(const Stype&, const Stype&); \
+    EXTERN template const Stype Sstd::hypot(const Stype&, const Stype&); \
+    EXTERN template const Stype Sstd::hypot(const Stype&, const Stype&, const Stype&); \
+    EXTERN template const Stype Sstd::fmod(const Stype&, const Stype&); \
+    EXTERN template const Stype Sstd::remainder(const Stype&, const Stype&); \
+    EXTERN template const Stype Sstd::remquo(const Stype&, const Stype&, int*); \
+    EXTERN template const Stype Sstd::fma(const Stype&, const Stype&, const Stype&); \
+    EXTERN template const Stype Sstd::frexp(const Stype&, int*); \
+    EXTERN template const Stype Sstd::ldexp(const Stype&, int); \
+    EXTERN template const Stype Sstd::modf(const Stype&, Stype*); \
+    EXTERN template const Stype Sstd::scalbn(const Stype&, int); \
+    EXTERN template const Stype Sstd::scalbln(const Stype&, long int); \
+    EXTERN template std::istream& operator>>(std::istream&, Stype&); \
+    EXTERN template std::string Stype::to_string() const;
+
+// all the instantiations, EXTERN is either 'extern' (declaration) or empty (definition)
+#define SHAMAN_INSTANTIATIONS(EXTERN) \
+    SHAMAN_UNARY_INSTANTIATIONS(EXTERN, Sfloat) \
+    SHAMAN_UNARY_INSTANTIATIONS(EXTERN, Sdouble) \
+    SHAMAN_UNARY_INSTANTIATIONS(EXTERN, Slong_double) \
+    SHAMAN_OTHER_INSTANTIATIONS(EXTERN, Sfloat) \
+    SHAMAN_OTHER_INSTANTIATIONS(EXTERN, Sdouble) \
+    SHAMAN_OTHER_INSTANTIATIONS(EXTERN, Slong_double)
+
+// instantiations.cpp defines SHAMAN_INSTANTIATING to define the instantiations rather than declare them
+#ifndef SHAMAN_INSTANTIATING
+SHAMAN_INSTANTIATIONS(extern)
+#endif
@@ -8,6 +8,12 @@
 #include <iomanip>
 #include <sstream>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include <typeinfo>
 #include <shaman/tagged/global_vars.h>
 
 //-----------------------------------------------------------------------------
@@ -82,8 +88,10 @@ templated inline numberType Snum::digits() const
  */
 templated inline bool Snum::non_significant(numberType number, errorType error)
 {
-    int base = 10;
-    return (error != 0) && (std::abs(number) < base * std::abs(error));
+    // computed in the type of the number/error operations so that a large narrow error does not overflow
+    using gapType = decltype(number + error);
+    const gapType base = gapType(ShamanGlobals::session().significanceBase);
+    return (error != 0) && (std::abs(number) < base * std::abs(gapType(error)));
 }
 
 /*
@@ -94,35 +102,86 @@ templated inline bool Snum::non_significant() const
     return non_significant(number, error);
 }
 
+/*
+ * returns the runtime configuration of Shaman (read from the SHAMAN_* environment variables when the program starts)
+ */
+inline Shaman::Session& Shaman::session()
+{
+    return ShamanGlobals::session();
+}
+
 /*
  * function called at each unstability
  * put a breakpoint here to break at each unstable tests
+ * (or set SHAMAN_UNSTABLE_BREAK to the number of an unstable test to stop on it without a debugger)
  */
 void Shaman::unstability()
 {
+    // unstable tests are numbered in the order in which they are detected (globally or per thread)
+    const long long globalNumber = ++ShamanGlobals::unstableBranchCounter;
+    const long long number = ShamanGlobals::session().unstableCounterPerThread ? ++ShamanGlobals::localUnstableBranchCounter : globalNumber;
     #ifdef SHAMAN_TAGGED_ERROR
+    {
         std::lock_guard<std::mutex> guard(ShamanGlobals::mutexAddUnstableBranch);
-        ShamanGlobals::unstableBranchSummary[CodeBlock::currentBlock()]++;
-    #else
-        ShamanGlobals::unstableBranchCounter++;
+        const Tag tag = CodeBlock::currentBlock();
+        ShamanGlobals::unstableBranchSummary[tag]++;
+        ShamanGlobals::unstableBranchFirst.emplace(tag, number);
+    }
     #endif
+    if(number == ShamanGlobals::session().unstableBreak)
+    {
+        ShamanGlobals::session().breakOnUnstableBranch(number);
+    }
+}
+
+namespace Shaman
+{
+    namespace detail
+    {
+        /*
+         * returns true for one call out of session.unstableSampling (per thread)
+         */
+        inline bool sampleComparison()
+        {
+            thread_local std::size_t countdown = 1;
+            if(--countdown != 0) return false;
+            countdown = ShamanGlobals::session().unstableSampling;
+            return true;
+        }
+    }
 }
 
 /*
- * check wether a branch is unstable
+ * check wether a branch comparing (number1,error1) with (number2,error2) is unstable
  * in wich case it triggers the unstability function
+ * only the numbers and errors are read, the error composants are never touched
  */
-templated inline void Snum::checkUnstableBranch(Snum n1, Snum n2)
+templated inline void Snum::checkUnstableBranch(numberType number1, errorType error1, numberType number2, errorType error2)
 {
     #ifdef SHAMAN_UNSTABLE_BRANCH
-    bool isUnstable = non_significant(n1.number - n2.number, n1.error - n2.error);
-    if(isUnstable)
+    if((ShamanGlobals::session().unstableSampling > 1) and not Shaman::detail::sampleComparison()) return;
+    // likely stable path : non_significant without its test on a zero error (a zero error never passes the comparison)
+    // the errors are compared in the type of the number/error operations so that large narrow errors do not overflow
+    using gapType = decltype(number1 + error1);
+    const gapType base = gapType(ShamanGlobals::session().significanceBase);
+    const bool isUnstable = std::abs(number1 - number2) < base * std::abs(gapType(error1) - gapType(error2));
+    if(SHAMAN_UNLIKELY(isUnstable))
     {
         Shaman::unstability();
     }
+    #else
+    (void)number1; (void)error1; (void)number2; (void)error2;
     #endif
 }
 
+/*
+ * check wether a branch comparing n1 with n2 is unstable
+ */
+templated inline void Snum::checkUnstableBranch(const Snum& n1, const Snum& n2)
+{
+    checkUnstableBranch(n1.number, n1.error, n2.number, n2.error);
+}
+
 /*
  * displays the number of unstable branches
  */
@@ -131,27 +190,584 @@ templated inline void Snum::checkUnstableBranch(Snum n1, Snum n2)
 #endif
 inline void Shaman::displayUnstableBranches()
 {
+    Shaman::Session::ReportWriter report = ShamanGlobals::session().report();
     #ifdef SHAMAN_UNSTABLE_BRANCH
         #ifdef SHAMAN_TAGGED_ERROR
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexAddUnstableBranch);
         if (ShamanGlobals::unstableBranchSummary.empty())
         {
-            std::cout << "#SHAMAN: No unstable test was detected. " << std::endl;
+            report << "#SHAMAN: No unstable test was detected. " << std::endl;
         }
         else
         {
-            std::cout << "#SHAMAN: Unstable tests detected :" << std::endl;
-            for(auto& kv : ShamanGlobals::unstableBranchSummary)
+            report << "#SHAMAN: Unstable tests detected :" << std::endl;
+            // sections are displayed in the order of their first unstable test
+            std::vector<std::pair<long long, Tag>> sections;
+            for(auto& kv : ShamanGlobals::unstableBranchFirst)
+            {
+                sections.emplace_back(kv.second, kv.first);
+            }
+            std::sort(sections.begin(), sections.end());
+            for(auto& section : sections)
             {
-                std::string blockName = CodeBlock::nameOfTag(kv.first);
-                unsigned int unstableBranchNumber = kv.second;
-                std::cout << " -> " << unstableBranchNumber << " unstable tests found in section '" << blockName << '\'' << std::endl;
+                std::string blockName = CodeBlock::nameOfTag(section.second);
+                unsigned int unstableBranchNumber = ShamanGlobals::unstableBranchSummary[section.second];
+                report << " -> " << unstableBranchNumber << " unstable tests found in section '" << blockName << '\''
+                       << " (the first one is unstable test number " << section.first << ')' << std::endl;
             }
+            report << "#SHAMAN: set SHAMAN_UNSTABLE_BREAK to the number of an unstable test to stop on it." << std::endl;
         }
         #else
-        std::cout << "#SHAMAN: " << ShamanGlobals::unstableBranchCounter << " unstable tests detected." << std::endl;
+        report << "#SHAMAN: " << ShamanGlobals::unstableBranchCounter << " unstable tests detected." << std::endl;
+        if(ShamanGlobals::unstableBranchCounter > 0)
+        {
+            report << "#SHAMAN: set SHAMAN_UNSTABLE_BREAK to the number of an unstable test to stop on it (1 for the first one)." << std::endl;
+        }
         #endif
     #else
-    std::cout << "#SHAMAN: please set the 'SHAMAN_UNSTABLE_BRANCH' flag in order to detect and count unstable branches in the application." << std::endl;
+    report << "#SHAMAN: please set the 'SHAMAN_UNSTABLE_BRANCH' flag in order to detect and count unstable branches in the application." << std::endl;
+    #endif
+}
+
+//-----------------------------------------------------------------------------
+// PRECISION ADVISOR
+
+#ifdef SHAMAN_PRECISION_ADVISOR
+/*
+ * returns the record of the current thread for the given tag (nullptr if the tag is out of range)
+ */
+inline PrecisionRecord* localPrecisionRecord(Tag tag)
+{
+    std::vector<PrecisionRecord>& records = ShamanGlobals::precisionRecords.local(error_sum<float>::maxTagNumber);
+    return (tag < records.size()) ? &records[tag] : nullptr;
+}
+
+namespace Shaman
+{
+    namespace detail
+    {
+        template<typename numberType, typename errorType>
+        inline void recordPrecision(numberType number, errorType error, std::true_type /*isScalar*/)
+        {
+            if((number == 0) or (not std::isfinite(number)) or (not std::isfinite(error))) return;
+            PrecisionRecord* record = localPrecisionRecord(CodeBlock::currentBlock());
+            if(record == nullptr) return;
+
+            const double relativeError = std::abs(double(error) / double(number));
+            record->valueNumber += 1;
+            // exact values (x*2, sums of small integers, ...) say nothing about the precision the block needs
+            if(relativeError == 0) record->exactValueNumber += 1;
+            else record->minRelativeError = std::min(double(record->minRelativeError), relativeError);
+            record->maxRelativeError = std::max(double(record->maxRelativeError), relativeError);
+            record->unitRoundoff = std::max(double(record->unitRoundoff), double(std::numeric_limits<numberType>::epsilon()) / 2.);
+        }
+
+        // lane types (see shaman_simd.h) are not recorded
+        template<typename numberType, typename errorType>
+        inline void recordPrecision(numberType, errorType, std::false_type /*isScalar*/) {}
+    }
+}
+
+/*
+ * records the relative error of a value produced in the current block
+ */
+template<typename numberType, typename errorType>
+inline void Shaman::recordPrecision(numberType number, errorType error)
+{
+    detail::recordPrecision(number, error, std::is_arithmetic<numberType>());
+}
+
+namespace Shaman
+{
+    /*
+     * returns the records of all the threads merged (indexes are tags)
+     */
+    inline std::vector<PrecisionRecord> precisionRecords()
+    {
+        return ShamanGlobals::precisionRecords.merged(error_sum<float>::maxTagNumber, [](PrecisionRecord& record, const PrecisionRecord& threadRecord)
+        {
+            record.valueNumber += threadRecord.valueNumber;
+            record.exactValueNumber += threadRecord.exactValueNumber;
+            record.minRelativeError = std::min(double(record.minRelativeError), double(threadRecord.minRelativeError));
+            record.maxRelativeError = std::max(double(record.maxRelativeError), double(threadRecord.maxRelativeError));
+            record.unitRoundoff = std::max(double(record.unitRoundoff), double(threadRecord.unitRoundoff));
+            record.maxOutputShare = std::max(double(record.maxOutputShare), double(threadRecord.maxOutputShare));
+        });
+    }
+
+    /*
+     * returns the least precise type that could store the values of a block ("bfloat16" or "float")
+     * or an empty string if the block should keep its current precision (see displayPrecisionAdvice)
+     */
+    inline std::string advisedPrecision(const PrecisionRecord& record, double toleratedDigitLoss = 1.)
+    {
+        if(record.valueNumber == 0) return "";
+        // candidate types, from the least to the most precise
+        const std::vector<std::pair<std::string, double>> targets = {{"bfloat16", std::ldexp(1., -8)}, {"float", std::ldexp(1., -24)}};
+        const bool hasOutputs = ShamanGlobals::observedOutputCounter > 0;
+
+        for(auto& target : targets)
+        {
+            const double targetRoundoff = target.second;
+            if(targetRoundoff <= record.unitRoundoff) continue; // the block already uses this precision
+
+            // without outputs, the most precise inexact value of the block sets the precision the block needs
+            const bool hasInexactValues = record.exactValueNumber < record.valueNumber;
+            const bool isAcceptable = hasOutputs ?
+                (std::log10(1. + record.maxOutputShare * (targetRoundoff / record.unitRoundoff)) <= toleratedDigitLoss) :
+                (hasInexactValues and (record.minRelativeError >= targetRoundoff));
+            if(isAcceptable) return target.first;
+        }
+        return "";
+    }
+}
+#endif
+
+/*
+ * declares a value as an output of the program
+ * the precision advisor measures how much of its error was generated in each block
+ */
+templated inline void Shaman::observe(const Snum& output)
+{
+    #ifdef SHAMAN_PRECISION_ADVISOR
+    const double unitRoundoff = double(std::numeric_limits<numberType>::epsilon()) / 2.;
+    const double outputError = std::max(std::abs(double(output.error)), std::abs(double(output.number)) * unitRoundoff);
+    if((outputError == 0) or (not std::isfinite(outputError))) return;
+
+    ShamanGlobals::observedOutputCounter++;
+    const size_t tagNumber = std::min(CodeBlock::tagNumber(), size_t(Serror::maxTagNumber));
+    const error_sum<errorType> composants = output.errorComposants;
+    for(Tag tag = 0; tag < tagNumber; tag++)
+    {
+        const double share = std::abs(double(composants.errors[tag])) / outputError;
+        PrecisionRecord* record = localPrecisionRecord(tag);
+        if(std::isfinite(share) and (record != nullptr))
+        {
+            record->maxOutputShare = std::max(double(record->maxOutputShare), share);
+        }
+    }
+    #endif
+}
+
+/*
+ * displays, for each block, the significant digits of the values it produced and the types it could use to store them
+ *
+ * if outputs were given to Shaman::observe, a block is deemed able to use a type
+ * if the error it generates, scaled to the unit roundoff of that type, would cost at most toleratedDigitLoss digits to the outputs
+ * otherwise it is deemed able to use a type if its most precise inexact value has no more significant digits than the type can store
+ * (storing the values in that type would then lower the precision of none of them, exact values are not taken into account)
+ * NOTE: this is a first order estimation that should be confirmed by running the block in the advised type
+ */
+#ifndef SHAMAN_PRECISION_ADVISOR
+[[deprecated("Please set the 'SHAMAN_PRECISION_ADVISOR' flag in order to use the 'displayPrecisionAdvice' function.")]]
+#endif
+inline void Shaman::displayPrecisionAdvice(double toleratedDigitLoss)
+{
+    Shaman::Session::ReportWriter report = ShamanGlobals::session().report();
+    #ifdef SHAMAN_PRECISION_ADVISOR
+    const std::vector<PrecisionRecord> records = precisionRecords();
+    const bool hasOutputs = ShamanGlobals::observedOutputCounter > 0;
+    auto digitsOfError = [](double relativeError){return (relativeError == 0) ? INFINITY : std::max(0., -std::log10(relativeError));};
+
+    report << "#SHAMAN: Precision advice" << (hasOutputs ? " (based on the observed outputs) :" : " (based on the values produced) :") << std::endl;
+    bool hasRecords = false;
+    for(size_t tag = 0; tag < std::min(records.size(), CodeBlock::tagNumber()); tag++)
+    {
+        const PrecisionRecord& record = records[tag];
+        if(record.valueNumber == 0) continue;
+        hasRecords = true;
+
+        const std::string target = advisedPrecision(record, toleratedDigitLoss);
+        const std::string advice = target.empty() ? "should keep its current precision" : "could be stored in " + target;
+
+        std::ostringstream line;
+        line << std::setprecision(3) << " -> section '" << CodeBlock::nameOfTag(tag) << "' produced " << record.valueNumber << " values";
+        if(record.exactValueNumber == record.valueNumber)
+        {
+            line << ", all exact";
+        }
+        else
+        {
+            line << " with " << digitsOfError(record.maxRelativeError) << " to " << digitsOfError(record.minRelativeError) << " significant digits";
+            if(record.exactValueNumber > 0) line << " (and " << record.exactValueNumber << " exact values)";
+        }
+        if(hasOutputs)
+        {
+            line << ", generating up to " << record.maxOutputShare * 100. << "% of the error of an output";
+        }
+        report << line.str() << " : " << advice << std::endl;
+    }
+    if(not hasRecords)
+    {
+        report << " -> no value was recorded." << std::endl;
+    }
+    #else
+    (void)toleratedDigitLoss;
+    report << "#SHAMAN: please set the 'SHAMAN_PRECISION_ADVISOR' flag (and tagged error) in order to get precision advice." << std::endl;
+    #endif
+}
+
+//-----------------------------------------------------------------------------
+// CANCELLATION COUNTERS
+
+#ifdef SHAMAN_CANCELLATION
+/*
+ * returns the record of the current thread for the given tag (nullptr if the tag is out of range)
+ */
+inline CancellationRecord* localCancellationRecord(Tag tag)
+{
+    std::vector<CancellationRecord>& records = ShamanGlobals::cancellationRecords.local(error_sum<float>::maxTagNumber);
+    return (tag < records.size()) ? &records[tag] : nullptr;
+}
+
+namespace Shaman
+{
+    namespace detail
+    {
+        /*
+         * biased exponent of a number, read from its bits for float and double
+         * returns a value above maxExponent<T>() for inf and nan
+         */
+        inline int exponentOf(double x)
+        {
+            std::uint64_t bits;
+            std::memcpy(&bits, &x, sizeof(double));
+            return int((bits >> 52) & 0x7FF);
+        }
+        inline int exponentOf(float x)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &x, sizeof(float));
+            return int((bits >> 23) & 0xFF);
+        }
+        template<typename T>
+        inline int exponentOf(T x)
+        {
+            if(not std::isfinite(x)) return std::numeric_limits<int>::max();
+            return (x == T(0)) ? 0 : (std::ilogb(x) - std::numeric_limits<T>::min_exponent + 2);
+        }
+
+        template<typename T> inline int maxExponent() {return std::numeric_limits<T>::max_exponent - std::numeric_limits<T>::min_exponent + 1;}
+        template<> inline int maxExponent<double>() {return 0x7FE;}
+        template<> inline int maxExponent<float>() {return 0xFE;}
+
+        template<typename numberType>
+        inline void recordCancellation(numberType n1, numberType n2, numberType result, std::true_type /*isScalar*/)
+        {
+            // an exact zero generates no error, it is not counted as a cancellation
+            if(result == numberType(0)) return;
+            const int exponent1 = exponentOf(n1);
+            const int exponent2 = exponentOf(n2);
+            const int exponentResult = exponentOf(result);
+            if(std::max(exponent1, exponent2) > maxExponent<numberType>()) return;
+
+            CancellationRecord* record = localCancellationRecord(CodeBlock::currentBlock());
+            if(record == nullptr) return;
+            const int bitsLost = std::min(std::max(std::max(exponent1, exponent2) - exponentResult, 0), 63);
+            record->histogram[bitsLost] += 1;
+        }
+
+        // lane types (see shaman_simd.h) are not recorded
+        template<typename numberType>
+        inline void recordCancellation(numberType, numberType, numberType, std::false_type /*isScalar*/) {}
+    }
+
+    /*
+     * returns the records of all the threads merged (indexes are tags)
+     */
+    inline std::vector<CancellationRecord> cancellationRecords()
+    {
+        return ShamanGlobals::cancellationRecords.merged(error_sum<float>::maxTagNumber, [](CancellationRecord& record, const CancellationRecord& threadRecord)
+        {
+            for(size_t bits = 0; bits < record.histogram.size(); bits++) record.histogram[bits] += threadRecord.histogram[bits];
+        });
+    }
+}
+
+/*
+ * records the number of bits lost by an addition or subtraction performed in the current block
+ * the bits lost are the difference between the exponent of the largest operand and the exponent of the result
+ */
+template<typename numberType>
+inline void Shaman::recordCancellation(numberType n1, numberType n2, numberType result)
+{
+    detail::recordCancellation(n1, n2, result, std::is_arithmetic<numberType>());
+}
+#endif
+
+/*
+ * displays, for each block, the additions and subtractions that lost at least minBitsLost bits to cancellations
+ * the blocks with the worst cancellations come first
+ */
+#ifndef SHAMAN_CANCELLATION
+[[deprecated("Please set the 'SHAMAN_CANCELLATION' flag in order to use the 'displayCancellations' function.")]]
+#endif
+inline void Shaman::displayCancellations(int minBitsLost)
+{
+    Shaman::Session::ReportWriter report = ShamanGlobals::session().report();
+    #ifdef SHAMAN_CANCELLATION
+    const std::vector<CancellationRecord> records = cancellationRecords();
+    minBitsLost = std::min(std::max(minBitsLost, 1), 63);
+
+    // (worst loss, cancellations, tag) for the blocks with at least one cancellation
+    std::vector<std::tuple<int, unsigned long long, Tag>> blocks;
+    for(size_t tag = 0; tag < std::min(records.size(), CodeBlock::tagNumber()); tag++)
+    {
+        const auto& histogram = records[tag].histogram;
+        int worstLoss = 0;
+        unsigned long long cancellations = 0;
+        for(int bits = minBitsLost; bits < int(histogram.size()); bits++)
+        {
+            if(histogram[bits] == 0) continue;
+            worstLoss = bits;
+            cancellations += histogram[bits];
+        }
+        if(cancellations > 0) blocks.emplace_back(worstLoss, cancellations, Tag(tag));
+    }
+    std::sort(blocks.begin(), blocks.end(), [](const std::tuple<int, unsigned long long, Tag>& b1, const std::tuple<int, unsigned long long, Tag>& b2)
+              {return std::make_pair(std::get<0>(b1), std::get<1>(b1)) > std::make_pair(std::get<0>(b2), std::get<1>(b2));});
+
+    report << "#SHAMAN: Cancellations losing at least " << minBitsLost << " bits :" << std::endl;
+    for(const auto& block : blocks)
+    {
+        const auto& histogram = records[std::get<2>(block)].histogram;
+        unsigned long long operations = 0;
+        for(unsigned long long count : histogram) operations += count;
+
+        // groups the histogram by powers of two
+        std::ostringstream buckets;
+        for(int low = 1; low < int(histogram.size()); low *= 2)
+        {
+            unsigned long long count = 0;
+            for(int bits = low; bits < 2*low; bits++) count += histogram[bits];
+            if(count > 0) buckets << ' ' << low << '-' << 2*low-1 << " bits:" << count;
+        }
+
+        report << std::setprecision(3) << " -> section '" << CodeBlock::nameOfTag(std::get<2>(block)) << "' : " << std::get<1>(block)
+                  << " of " << operations << " additions (" << 100. * double(std::get<1>(block)) / double(operations)
+                  << "%), up to " << std::get<0>(block) << " bits lost [" << buckets.str() << " ]" << std::endl;
+    }
+    if(blocks.empty())
+    {
+        report << " -> no cancellation was recorded." << std::endl;
+    }
+    #else
+    (void)minBitsLost;
+    report << "#SHAMAN: please set the 'SHAMAN_CANCELLATION' flag (and tagged error) in order to count cancellations." << std::endl;
+    #endif
+}
+
+//-----------------------------------------------------------------------------
+// OPERATION COUNTERS
+
+#ifdef SHAMAN_OPERATION_COUNTERS
+namespace Shaman
+{
+    namespace detail
+    {
+        // the S types registered beyond this number are counted together in the last type
+        const std::size_t maxOperationTypes = 16;
+        const std::string otherOperationTypes = "other S types";
+
+        // number of tags whose operations are counted separately (operations of other tags are not counted)
+        inline std::size_t operationTagNumber()
+        {
+            #ifdef SHAMAN_TAGGED_ERROR
+            return error_sum<float>::maxTagNumber;
+            #else
+            return 1;
+            #endif
+        }
+
+        // names of the number types, as displayed by the operation counters
+        template<typename T> inline std::string operationTypeName() {return typeid(T).name();}
+        template<> inline std::string operationTypeName<Shaman::half>() {return "half";}
+        template<> inline std::string operationTypeName<Shaman::bfloat16>() {return "bfloat16";}
+        template<> inline std::string operationTypeName<float>() {return "float";}
+        template<> inline std::string operationTypeName<double>() {return "double";}
+        template<> inline std::string operationTypeName<long double>() {return "long double";}
+        #ifdef SHAMAN_QUAD_PRECISION
+        template<> inline std::string operationTypeName<__float128>() {return "__float128";}
+        #endif
+        templated inline std::string operationTypeName(const Snum*)
+        {
+            return "S<" + operationTypeName<numberType>() + "," + operationTypeName<errorType>() + "," + operationTypeName<preciseType>() + ">";
+        }
+
+        /*
+         * gives an index to a S type
+         * once maxOperationTypes types are registered, the last index is shared and its name lists the types counted in it
+         */
+        inline std::size_t registerOperationType(const std::string& name)
+        {
+            std::lock_guard<std::mutex> guard(ShamanGlobals::mutexOperationTypes);
+            auto& names = ShamanGlobals::operationTypeNames;
+            if(names.size() == maxOperationTypes)
+            {
+                if(names.back().compare(0, otherOperationTypes.size(), otherOperationTypes) != 0)
+                {
+                    names.back() = otherOperationTypes + " (" + names.back() + ")";
+                }
+                names.back().insert(names.back().size() - 1, ", " + name);
+                return maxOperationTypes - 1;
+            }
+            names.push_back(name);
+            return names.size() - 1;
+        }
+    }
+
+    /*
+     * returns the index of a S type in the operation records
+     * types are registered the first time they perform an operation
+     */
+    template<typename Stype>
+    inline std::size_t operationTypeOf()
+    {
+        static const std::size_t type = detail::registerOperationType(detail::operationTypeName(static_cast<const Stype*>(nullptr)));
+        return type;
+    }
+}
+
+/*
+ * returns the record of the current thread for the given type and tag (nullptr if the tag is out of range)
+ */
+inline OperationRecord* localOperationRecord(std::size_t type, Tag tag)
+{
+    const std::size_t tagNumber = Shaman::detail::operationTagNumber();
+    std::vector<OperationRecord>& records = ShamanGlobals::operationRecords.local(Shaman::detail::maxOperationTypes * tagNumber);
+    return (tag < tagNumber) ? &records[type * tagNumber + tag] : nullptr;
+}
+
+/*
+ * counts count operations performed on a Stype in the current block
+ */
+template<typename Stype>
+inline void Shaman::countOperation(Operation operation, unsigned long long count)
+{
+    #ifdef SHAMAN_TAGGED_ERROR
+    const Tag tag = CodeBlock::currentBlock();
+    #else
+    const Tag tag = ShamanGlobals::tagUntagged;
+    #endif
+    OperationRecord* record = localOperationRecord(operationTypeOf<Stype>(), tag);
+    if(record != nullptr) record->counts[std::size_t(operation)] += count;
+}
+
+namespace Shaman
+{
+    /*
+     * returns the records of all the threads merged (indexes are the types, see operationTypeOf, then the tags)
+     */
+    inline std::vector<std::vector<OperationRecord>> operationCounts()
+    {
+        const std::size_t tagNumber = detail::operationTagNumber();
+        std::size_t typeNumber;
+        {
+            std::lock_guard<std::mutex> guard(ShamanGlobals::mutexOperationTypes);
+            typeNumber = ShamanGlobals::operationTypeNames.size();
+        }
+        const std::vector<OperationRecord> mergedRecords = ShamanGlobals::operationRecords.merged(typeNumber * tagNumber, [](OperationRecord& record, const OperationRecord& threadRecord)
+        {
+            for(size_t kind = 0; kind < operationKindNumber; kind++) record.counts[kind] += threadRecord.counts[kind];
+        });
+        std::vector<std::vector<OperationRecord>> records(typeNumber);
+        for(size_t type = 0; type < typeNumber; type++)
+        {
+            records[type].assign(mergedRecords.begin() + type * tagNumber, mergedRecords.begin() + (type + 1) * tagNumber);
+        }
+        return records;
+    }
+
+    namespace detail
+    {
+        /*
+         * displays the number of operations of each kind and their estimated cost
+         */
+        inline void displayOperationRecord(std::ostream& report, const OperationRecord& record, const std::vector<double>& nanosecondsPerOperation)
+        {
+            static const char* kindNames[operationKindNumber] = {"additions", "multiplications", "divisions", "function calls", "comparisons"};
+            double nanoseconds = 0;
+            for(size_t kind = 0; kind < operationKindNumber; kind++)
+            {
+                report << ((kind == 0) ? "" : ", ") << record.counts[kind] << ' ' << kindNames[kind];
+                if(kind < nanosecondsPerOperation.size()) nanoseconds += nanosecondsPerOperation[kind] * double(record.counts[kind]);
+            }
+            if(not nanosecondsPerOperation.empty())
+            {
+                report << std::setprecision(3) << " (estimated cost " << nanoseconds * 1e-9 << "s)";
+            }
+            report << std::endl;
+        }
+    }
+}
+#endif
+
+/*
+ * displays, for each S type and each block, the number of additions (and subtractions), multiplications, divisions, function calls and comparisons performed
+ * nanosecondsPerOperation optionally gives the cost of an operation of each kind (in that order, as measured by a microbenchmark) to estimate the cost of the operations
+ * the blocks performing the most operations come first
+ */
+#ifndef SHAMAN_OPERATION_COUNTERS
+[[deprecated("Please set the 'SHAMAN_OPERATION_COUNTERS' flag in order to use the 'displayOperationCounts' function.")]]
+#endif
+inline void Shaman::displayOperationCounts(const std::vector<double>& nanosecondsPerOperation)
+{
+    Shaman::Session::ReportWriter report = ShamanGlobals::session().report();
+    #ifdef SHAMAN_OPERATION_COUNTERS
+    const std::vector<std::vector<OperationRecord>> records = operationCounts();
+    std::vector<std::string> typeNames;
+    {
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexOperationTypes);
+        typeNames = ShamanGlobals::operationTypeNames;
+    }
+    std::vector<std::string> blockNames;
+    {
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexAddName);
+        blockNames = ShamanGlobals::tagDecryptor;
+    }
+    auto operationNumber = [](const OperationRecord& record)
+    {
+        unsigned long long operations = 0;
+        for(unsigned long long count : record.counts) operations += count;
+        return operations;
+    };
+
+    report << "#SHAMAN: Operations performed :" << std::endl;
+    for(size_t type = 0; type < records.size(); type++)
+    {
+        OperationRecord total;
+        std::vector<std::pair<unsigned long long, Tag>> blocks;
+        for(size_t tag = 0; tag < std::min(records[type].size(), blockNames.size()); tag++)
+        {
+            const unsigned long long operations = operationNumber(records[type][tag]);
+            if(operations == 0) continue;
+            blocks.emplace_back(operations, Tag(tag));
+            for(size_t kind = 0; kind < operationKindNumber; kind++) total.counts[kind] += records[type][tag].counts[kind];
+        }
+        if(blocks.empty()) continue;
+        std::sort(blocks.begin(), blocks.end(), [](const std::pair<unsigned long long, Tag>& b1, const std::pair<unsigned long long, Tag>& b2){return b1.first > b2.first;});
+
+        report << " -> " << typeNames[type] << " : ";
+        detail::displayOperationRecord(report, total, nanosecondsPerOperation);
+        #ifdef SHAMAN_TAGGED_ERROR
+        for(const auto& block : blocks)
+        {
+            report << "     -> section '" << blockNames[block.second] << "' : ";
+            detail::displayOperationRecord(report, records[type][block.second], nanosecondsPerOperation);
+        }
+        #endif
+    }
+    if(records.empty())
+    {
+        report << " -> no operation was counted." << std::endl;
+    }
+    else if(typeNames.back().compare(0, detail::otherOperationTypes.size(), detail::otherOperationTypes) == 0)
+    {
+        report << " -> NOTE: more than " << detail::maxOperationTypes << " S types performed operations, the last ones are counted together as '" << detail::otherOperationTypes << "'." << std::endl;
+    }
+    #else
+    (void)nanosecondsPerOperation;
+    report << "#SHAMAN: please set the 'SHAMAN_OPERATION_COUNTERS' flag in order to count operations." << std::endl;
     #endif
 }
 
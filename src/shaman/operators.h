@@ -11,47 +11,85 @@
  */
 
 // takes a value and builds an Stype around its type
+inline Shalf makeStype(Shaman::half t) { return Shalf(t); };
+inline Sbfloat16 makeStype(Shaman::bfloat16 t) { return Sbfloat16(t); };
 inline Sfloat makeStype(float t) { return Sfloat(t); };
 inline Sdouble makeStype(double t) { return Sdouble(t); };
 inline Slong_double makeStype(long double t) { return Slong_double(t); };
 templated inline Snum makeStype(Snum s) { return s; };
 
+// takes a S value and a value and builds an Stype around the type of their sum
+// keeping the S type of the first value if its number type is preserved (a Sdouble_compact times a double stays a Sdouble_compact)
+templated inline Snum makeStype(const Snum& s, numberType t) { return Snum(t); };
+template<typename N, typename E, typename P, typename T>
+inline auto makeStype(const S<N,E,P>& s, T t) -> decltype(makeStype(t)) { return makeStype(t); };
+
 // takes two values and builds an Stype around the type C++ would use as a return type for their sum
 // TODO this might be replaceable with std::common_type
 #define SreturnType(t1,t2) decltype(makeStype(t1 + t2))
+#define SreturnTypeOf(s,t) decltype(makeStype(s, s.number + t))
 
 // makes sure that a template type is an arithmetic type
 #define arithmeticTYPE(T) T, typename = typename std::enable_if<std::is_arithmetic<T>::value, T>::type
 
 // defines overload for arithmetic operators
-#define set_Soperator_casts(OPERATOR) \
+// an arithmetic operand that is exactly representable in the number type of the result goes through the scalar functions
+// (see SCALAR OPERATIONS) which skip its conversion into a S and the terms involving its (zero) error
+#define set_Soperator_casts(OPERATOR, SCALAR_RIGHT, SCALAR_LEFT) \
 template<typename N, typename E, typename P, typename arithmeticTYPE(T)> \
-  inline auto operator OPERATOR (const S<N,E,P>& n1, const T& n2) -> SreturnType(n1.number,n2) \
+inline CONSTEXPR20 auto operator OPERATOR (const S<N,E,P>& n1, const T& n2) -> SreturnTypeOf(n1,n2) \
 { \
-    return SreturnType(n1.number,n2)(n1) OPERATOR SreturnType(n1.number,n2)(n2); \
+    using Stype = SreturnTypeOf(n1,n2); \
+    if (Shaman::detail::isExact<typename Stype::NumberType>(n2)) \
+    { \
+        return Shaman::detail::SCALAR_RIGHT(Shaman::detail::castStype<Stype>(n1), typename Stype::NumberType(n2)); \
+    } \
+    return Stype(n1) OPERATOR Stype(n2); \
 } \
 template<typename N, typename E, typename P, typename arithmeticTYPE(T)> \
-inline auto operator OPERATOR (const T& n1, const S<N,E,P>& n2) -> SreturnType(n1,n2.number) \
+inline CONSTEXPR20 auto operator OPERATOR (const T& n1, const S<N,E,P>& n2) -> SreturnTypeOf(n2,n1) \
 { \
-    return SreturnType(n1,n2.number)(n1) OPERATOR SreturnType(n1,n2.number)(n2); \
+    using Stype = SreturnTypeOf(n2,n1); \
+    if (Shaman::detail::isExact<typename Stype::NumberType>(n1)) \
+    { \
+        return Shaman::detail::SCALAR_LEFT(typename Stype::NumberType(n1), Shaman::detail::castStype<Stype>(n2)); \
+    } \
+    return Stype(n1) OPERATOR Stype(n2); \
 } \
 template<typename N1, typename E1, typename P1, typename N2, typename E2, typename P2> \
-inline auto operator OPERATOR (const S<N1,E1,P1>& n1, const S<N2,E2,P2>& n2) -> SreturnType(n1.number,n2.number) \
+inline CONSTEXPR20 auto operator OPERATOR (const S<N1,E1,P1>& n1, const S<N2,E2,P2>& n2) -> SreturnType(n1.number,n2.number) \
 { \
     return SreturnType(n1.number,n2.number)(n1) OPERATOR SreturnType(n1.number,n2.number)(n2); \
 } \
 
 // defines overload for boolean operators
+// an arithmetic operand that is exactly representable in the number type is compared directly (see compareScalar)
 #define set_Sbool_operator_casts(OPERATOR) \
 template<typename N, typename E, typename P, typename arithmeticTYPE(T)> \
 inline bool operator OPERATOR (const S<N,E,P>& n1, const T& n2) \
 { \
-    return SreturnType(n1.number,n2)(n1) OPERATOR SreturnType(n1.number,n2)(n2); \
+    using Stype = SreturnTypeOf(n1,n2); \
+    if (Shaman::detail::isExact<typename Stype::NumberType>(n2)) \
+    { \
+        const Stype& s1 = Shaman::detail::castStype<Stype>(n1); \
+        const typename Stype::NumberType number2(n2); \
+        Shaman::detail::compareScalar(s1, number2); \
+        return s1.number OPERATOR number2; \
+    } \
+    return Stype(n1) OPERATOR Stype(n2); \
 } \
 template<typename N, typename E, typename P, typename arithmeticTYPE(T)> \
 inline bool operator OPERATOR (const T& n1, const S<N,E,P>& n2) \
 { \
-    return SreturnType(n1,n2.number)(n1) OPERATOR SreturnType(n1,n2.number)(n2); \
+    using Stype = SreturnTypeOf(n2,n1); \
+    if (Shaman::detail::isExact<typename Stype::NumberType>(n1)) \
+    { \
+        const Stype& s2 = Shaman::detail::castStype<Stype>(n2); \
+        const typename Stype::NumberType number1(n1); \
+        Shaman::detail::compareScalar(s2, number1); \
+        return number1 OPERATOR s2.number; \
+    } \
+    return Stype(n1) OPERATOR Stype(n2); \
 } \
 template<typename N1, typename E1, typename P1, typename N2, typename E2, typename P2> \
 inline bool operator OPERATOR (const S<N1,E1,P1>& n1, const S<N2,E2,P2>& n2) \
@@ -59,11 +97,208 @@ inline bool operator OPERATOR (const S<N1,E1,P1>& n1, const S<N2,E2,P2>& n2) \
     return SreturnType(n1.number,n2.number)(n1) OPERATOR SreturnType(n1.number,n2.number)(n2); \
 } \
 
+//-----------------------------------------------------------------------------
+// SCALAR OPERATIONS
+
+/*
+ * operations between a S and a scalar that is exactly representable in its number type
+ * they produce the same results as the S-S operators with a zero error on the scalar
+ * without building a S around the scalar (and its error composants in tagged mode)
+ */
+namespace Shaman
+{
+    namespace detail
+    {
+        // true if the floating point x can be converted to numberType without rounding
+        template<typename numberType, typename T,
+                 typename std::enable_if<std::is_arithmetic<numberType>::value and std::is_floating_point<T>::value, int>::type = 0>
+        inline CONSTEXPR20 bool isExact(T x)
+        {
+            return static_cast<numberType>(x) == x;
+        }
+
+        // true if the integer x can be converted to numberType without rounding
+        // NOTE conservative : integers larger than 2^digits are never considered exact
+        template<typename numberType, typename T,
+                 typename std::enable_if<std::is_arithmetic<numberType>::value and std::is_integral<T>::value, int>::type = 0>
+        inline CONSTEXPR20 bool isExact(T x)
+        {
+            const int digits = std::numeric_limits<numberType>::digits;
+            if (std::numeric_limits<T>::digits <= digits) return true;
+            // the rounding is monotonic, an integer rounded below 2^digits was below 2^digits
+            // (the modulo keeps the shift within T for the types that returned above)
+            const numberType bound = static_cast<numberType>(T(1) << (digits % std::numeric_limits<T>::digits));
+            const numberType rounded = static_cast<numberType>(x);
+            return (rounded < bound) and (-bound < rounded);
+        }
+
+        // lane types (such as std::experimental::simd) always go through the S-S operators
+        template<typename numberType, typename T,
+                 typename std::enable_if<not std::is_arithmetic<numberType>::value, int>::type = 0>
+        inline CONSTEXPR20 bool isExact(T)
+        {
+            return false;
+        }
+
+        // converts a S into the given S type, without a copy if it already has that type
+        template<typename Stype>
+        inline CONSTEXPR20 const Stype& castStype(const Stype& s)
+        {
+            return s;
+        }
+        template<typename Stype, typename N, typename E, typename P,
+                 typename std::enable_if<not std::is_same<Stype, S<N,E,P>>::value, int>::type = 0>
+        inline CONSTEXPR20 Stype castStype(const S<N,E,P>& s)
+        {
+            return Stype(s);
+        }
+
+        // S + scalar
+        templated inline CONSTEXPR20 const Snum addScalar(const Snum& n1, numberType n2)
+        {
+            SHAMAN_COUNT_OPERATION(addition);
+            numberType result = n1.number + n2;
+
+            auto remainder = EFT::TwoSum(n1.number, n2, result);
+            #ifdef SHAMAN_CANCELLATION
+            Shaman::recordCancellation(n1.number, n2, result);
+            #endif
+            auto newError = remainder + n1.error;
+
+            #ifdef SHAMAN_TAGGED_ERROR
+                Serror newErrorComp(n1.errorComposants);
+                newErrorComp.addError(remainder);
+                return Snum(result, newError, newErrorComp);
+            #else
+                return Snum(result, newError);
+            #endif
+        }
+
+        // scalar + S
+        templated inline CONSTEXPR20 const Snum scalarAdd(numberType n1, const Snum& n2)
+        {
+            return addScalar(n2, n1);
+        }
+
+        // S - scalar
+        templated inline CONSTEXPR20 const Snum subScalar(const Snum& n1, numberType n2)
+        {
+            SHAMAN_COUNT_OPERATION(addition);
+            numberType result = n1.number - n2;
+
+            auto remainder = EFT::TwoSum(n1.number, -n2, result);
+            #ifdef SHAMAN_CANCELLATION
+            Shaman::recordCancellation(n1.number, -n2, result);
+            #endif
+            auto newError = remainder + n1.error;
+
+            #ifdef SHAMAN_TAGGED_ERROR
+                Serror newErrorComp(n1.errorComposants);
+                newErrorComp.addError(remainder);
+                return Snum(result, newError, newErrorComp);
+            #else
+                return Snum(result, newError);
+            #endif
+        }
+
+        // scalar - S
+        templated inline CONSTEXPR20 const Snum scalarSub(numberType n1, const Snum& n2)
+        {
+            SHAMAN_COUNT_OPERATION(addition);
+            numberType result = n1 - n2.number;
+
+            auto remainder = EFT::TwoSum(n1, -n2.number, result);
+            #ifdef SHAMAN_CANCELLATION
+            Shaman::recordCancellation(n1, -n2.number, result);
+            #endif
+            auto newError = remainder - n2.error;
+
+            #ifdef SHAMAN_TAGGED_ERROR
+                Serror newErrorComp(n2.errorComposants, [](errorType e){return -e;});
+                newErrorComp.addError(remainder);
+                return Snum(result, newError, newErrorComp);
+            #else
+                return Snum(result, newError);
+            #endif
+        }
+
+        // S * scalar
+        templated inline CONSTEXPR20 const Snum multScalar(const Snum& n1, numberType n2)
+        {
+            SHAMAN_COUNT_OPERATION(multiplication);
+            numberType result = n1.number * n2;
+
+            auto remainder = EFT::FastTwoProd(n1.number, n2, result);
+            auto newError = remainder + n2*n1.error;
+
+            #ifdef SHAMAN_TAGGED_ERROR
+                Serror newErrorComp(n1.errorComposants, [n2](errorType e){return n2*e;});
+                newErrorComp.addError(remainder);
+                return Snum(result, newError, newErrorComp);
+            #else
+                return Snum(result, newError);
+            #endif
+        }
+
+        // scalar * S
+        templated inline CONSTEXPR20 const Snum scalarMult(numberType n1, const Snum& n2)
+        {
+            return multScalar(n2, n1);
+        }
+
+        // S / scalar
+        templated inline CONSTEXPR20 const Snum divScalar(const Snum& n1, numberType n2)
+        {
+            SHAMAN_COUNT_OPERATION(division);
+            numberType result = n1.number / n2;
+
+            auto remainder = EFT::RemainderDiv(n1.number, n2, result);
+            auto newError = (remainder + n1.error) / n2;
+
+            #ifdef SHAMAN_TAGGED_ERROR
+                Serror newErrorComp(n1.errorComposants);
+                newErrorComp.addError(remainder);
+                newErrorComp.divByScalar(n2);
+                return Snum(result, newError, newErrorComp);
+            #else
+                return Snum(result, newError);
+            #endif
+        }
+
+        // S compared with a scalar, the result is computed by the caller on the numbers
+        templated inline void compareScalar(const Snum& n1, numberType n2)
+        {
+            SHAMAN_COUNT_OPERATION(comparison);
+            Snum::checkUnstableBranch(n1.number, n1.error, n2, errorType(0));
+        }
+
+        // scalar / S
+        templated inline CONSTEXPR20 const Snum scalarDiv(numberType n1, const Snum& n2)
+        {
+            SHAMAN_COUNT_OPERATION(division);
+            numberType result = n1 / n2.number;
+
+            auto remainder = EFT::RemainderDiv(n1, n2.number, result);
+            auto n2Precise = n2.number + n2.error;
+            auto newError = (remainder - result*n2.error) / n2Precise;
+
+            #ifdef SHAMAN_TAGGED_ERROR
+                Serror newErrorComp(n2.errorComposants, [result](errorType e){return -result*e;});
+                newErrorComp.addError(remainder);
+                newErrorComp.divByScalar(n2Precise);
+                return Snum(result, newError, newErrorComp);
+            #else
+                return Snum(result, newError);
+            #endif
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 // ARITHMETIC OPERATORS
 
 // unary +
-templated inline const Snum operator+(const Snum& n)
+templated inline CONSTEXPR20 const Snum operator+(const Snum& n)
 {
     #ifdef SHAMAN_TAGGED_ERROR
         Serror newErrorComp(n.errorComposants);
@@ -74,7 +309,7 @@ templated inline const Snum operator+(const Snum& n)
 };
 
 // unary -
-templated inline const Snum operator-(const Snum& n)
+templated inline CONSTEXPR20 const Snum operator-(const Snum& n)
 {
     numberType result = -n.number;
     errorType newError = -n.error;
@@ -88,12 +323,16 @@ templated inline const Snum operator-(const Snum& n)
 };
 
 // +
-templated inline const Snum operator+(const Snum& n1, const Snum& n2)
+templated inline CONSTEXPR20 const Snum operator+(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(addition);
     numberType result = n1.number + n2.number;
 
-    numberType remainder = EFT::TwoSum(n1.number, n2.number, result);
-    errorType newError = remainder + n1.error + n2.error;
+    auto remainder = EFT::TwoSum(n1.number, n2.number, result);
+    #ifdef SHAMAN_CANCELLATION
+    Shaman::recordCancellation(n1.number, n2.number, result);
+    #endif
+    auto newError = remainder + n1.error + n2.error;
 
     #ifdef SHAMAN_TAGGED_ERROR
         Serror newErrorComp(n1.errorComposants, n2.errorComposants, std::plus<errorType>());
@@ -103,15 +342,19 @@ templated inline const Snum operator+(const Snum& n1, const Snum& n2)
         return Snum(result, newError);
     #endif
 };
-set_Soperator_casts(+);
+set_Soperator_casts(+, addScalar, scalarAdd);
 
 // -
-templated inline const Snum operator-(const Snum& n1, const Snum& n2)
+templated inline CONSTEXPR20 const Snum operator-(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(addition);
     numberType result = n1.number - n2.number;
 
-    numberType remainder = EFT::TwoSum(n1.number, -n2.number, result);
-    errorType newError = remainder + n1.error - n2.error;
+    auto remainder = EFT::TwoSum(n1.number, -n2.number, result);
+    #ifdef SHAMAN_CANCELLATION
+    Shaman::recordCancellation(n1.number, -n2.number, result);
+    #endif
+    auto newError = remainder + n1.error - n2.error;
 
     #ifdef SHAMAN_TAGGED_ERROR
         Serror newErrorComp(n1.errorComposants, n2.errorComposants, std::minus<errorType>());
@@ -121,16 +364,17 @@ templated inline const Snum operator-(const Snum& n1, const Snum& n2)
         return Snum(result, newError);
     #endif
 };
-set_Soperator_casts(-);
+set_Soperator_casts(-, subScalar, scalarSub);
 
 // *
 // note : we ignore second order terms
-templated inline const Snum operator*(const Snum& n1, const Snum& n2)
+templated inline CONSTEXPR20 const Snum operator*(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(multiplication);
     numberType result = n1.number * n2.number;
 
-    numberType remainder = EFT::FastTwoProd(n1.number, n2.number, result);
-    errorType newError = remainder + (n1.number*n2.error + n2.number*n1.error);
+    auto remainder = EFT::FastTwoProd(n1.number, n2.number, result);
+    auto newError = remainder + (n1.number*n2.error + n2.number*n1.error);
 
     #ifdef SHAMAN_TAGGED_ERROR
         numberType number1 = n1.number;
@@ -142,16 +386,17 @@ templated inline const Snum operator*(const Snum& n1, const Snum& n2)
         return Snum(result, newError);
     #endif
 };
-set_Soperator_casts(*);
+set_Soperator_casts(*, multScalar, scalarMult);
 
 // /
-templated inline const Snum operator/(const Snum& n1, const Snum& n2)
+templated inline CONSTEXPR20 const Snum operator/(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(division);
     numberType result = n1.number / n2.number;
 
-    numberType remainder = EFT::RemainderDiv(n1.number, n2.number, result);
-    errorType n2Precise = n2.number + n2.error;
-    errorType newError = ((remainder + n1.error) - result*n2.error) / n2Precise;
+    auto remainder = EFT::RemainderDiv(n1.number, n2.number, result);
+    auto n2Precise = n2.number + n2.error;
+    auto newError = ((remainder + n1.error) - result*n2.error) / n2Precise;
 
     #ifdef SHAMAN_TAGGED_ERROR
         Serror newErrorComp(n1.errorComposants, n2.errorComposants, [result](errorType e1, errorType e2){return e1 - result*e2;});
@@ -162,16 +407,17 @@ templated inline const Snum operator/(const Snum& n1, const Snum& n2)
         return Snum(result, newError);
     #endif
 };
-set_Soperator_casts(/);
+set_Soperator_casts(/, divScalar, scalarDiv);
 
 //-----------------------------------------------------------------------------
 // CLASS OPERATORS
 
 // prefix ++
-templated inline Snum& Snum::operator++()
+templated inline CONSTEXPR20 Snum& Snum::operator++()
 {
+    SHAMAN_COUNT_OPERATION(addition);
     numberType result = number + numberType(1);
-    numberType remainder = EFT::TwoSum(number, numberType(1), result);
+    auto remainder = EFT::TwoSum(number, numberType(1), result);
 
     number = result;
     error += remainder;
@@ -184,10 +430,11 @@ templated inline Snum& Snum::operator++()
 }
 
 // prefix --
-templated inline Snum& Snum::operator--()
+templated inline CONSTEXPR20 Snum& Snum::operator--()
 {
+    SHAMAN_COUNT_OPERATION(addition);
     numberType result = number - numberType(1);
-    numberType remainder = EFT::TwoSum(number, numberType(-1), result);
+    auto remainder = EFT::TwoSum(number, numberType(-1), result);
 
     number = result;
     error += remainder;
@@ -200,10 +447,11 @@ templated inline Snum& Snum::operator--()
 }
 
 // postfix ++
-templated inline Snum& Snum::operator++(int)
+templated inline CONSTEXPR20 Snum& Snum::operator++(int)
 {
+    SHAMAN_COUNT_OPERATION(addition);
     numberType result = number + numberType(1);
-    numberType remainder = EFT::TwoSum(number, numberType(1), result);
+    auto remainder = EFT::TwoSum(number, numberType(1), result);
 
     number = result;
     error += remainder;
@@ -216,10 +464,11 @@ templated inline Snum& Snum::operator++(int)
 }
 
 // postfix --
-templated inline Snum& Snum::operator--(int)
+templated inline CONSTEXPR20 Snum& Snum::operator--(int)
 {
+    SHAMAN_COUNT_OPERATION(addition);
     numberType result = number - numberType(1);
-    numberType remainder = EFT::TwoSum(number, numberType(-1), result);
+    auto remainder = EFT::TwoSum(number, numberType(-1), result);
 
     number = result;
     error += remainder;
@@ -232,13 +481,17 @@ templated inline Snum& Snum::operator--(int)
 }
 
 // +=
-templated inline Snum& Snum::operator+=(const Snum& n)
+templated inline CONSTEXPR20 Snum& Snum::operator+=(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(addition);
     numberType result = number + n.number;
-    numberType remainder = EFT::TwoSum(number, n.number, result);
+    auto remainder = EFT::TwoSum(number, n.number, result);
+    #ifdef SHAMAN_CANCELLATION
+    Shaman::recordCancellation(number, n.number, result);
+    #endif
 
     number = result;
-    error += remainder + n.error;
+    error = Shaman::narrow_error<errorType>(error + (remainder + n.error));
 
     #ifdef SHAMAN_TAGGED_ERROR
         errorComposants.addError(remainder);
@@ -249,13 +502,17 @@ templated inline Snum& Snum::operator+=(const Snum& n)
 }
 
 // -=
-templated inline Snum& Snum::operator-=(const Snum& n)
+templated inline CONSTEXPR20 Snum& Snum::operator-=(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(addition);
     numberType result = number - n.number;
-    numberType remainder = EFT::TwoSum(number, -n.number, result);
+    auto remainder = EFT::TwoSum(number, -n.number, result);
+    #ifdef SHAMAN_CANCELLATION
+    Shaman::recordCancellation(number, -n.number, result);
+    #endif
 
     number = result;
-    error += remainder - n.error;
+    error = Shaman::narrow_error<errorType>(error + (remainder - n.error));
 
     #ifdef SHAMAN_TAGGED_ERROR
         errorComposants.addError(remainder);
@@ -267,12 +524,13 @@ templated inline Snum& Snum::operator-=(const Snum& n)
 
 // *=
 // note : we ignore second order terms
-templated inline Snum& Snum::operator*=(const Snum& n)
+templated inline CONSTEXPR20 Snum& Snum::operator*=(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(multiplication);
     numberType result = number * n.number;
-    numberType remainder = EFT::FastTwoProd(number, n.number, result);
+    auto remainder = EFT::FastTwoProd(number, n.number, result);
 
-    error = n.number*error + remainder + number*n.error;
+    error = Shaman::narrow_error<errorType>(n.number*error + remainder + number*n.error);
     #ifdef SHAMAN_TAGGED_ERROR
         errorComposants.multByScalar(n.number);
         errorComposants.addError(remainder);
@@ -284,14 +542,15 @@ templated inline Snum& Snum::operator*=(const Snum& n)
 }
 
 // /=
-templated inline Snum& Snum::operator/=(const Snum& n)
+templated inline CONSTEXPR20 Snum& Snum::operator/=(const Snum& n)
 {
+    SHAMAN_COUNT_OPERATION(division);
     numberType result = number / n.number;
-    numberType remainder = EFT::RemainderDiv(number, n.number, result);
-    errorType n2Precise = n.number + n.error;
+    auto remainder = EFT::RemainderDiv(number, n.number, result);
+    auto n2Precise = n.number + n.error;
 
     number = result;
-    error = (error + remainder - result*n.error) / n2Precise;
+    error = Shaman::narrow_error<errorType>((error + remainder - result*n.error) / n2Precise);
 
     #ifdef SHAMAN_TAGGED_ERROR
         errorComposants.addError(remainder);
@@ -308,6 +567,7 @@ templated inline Snum& Snum::operator/=(const Snum& n)
 // ==
 templated inline bool operator==(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(comparison);
     Snum::checkUnstableBranch(n1, n2);
     return n1.number == n2.number;
 };
@@ -316,6 +576,7 @@ set_Sbool_operator_casts(==);
 // !=
 templated inline bool operator!=(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(comparison);
     Snum::checkUnstableBranch(n1, n2);
     return n1.number != n2.number;
 };
@@ -324,6 +585,7 @@ set_Sbool_operator_casts(!=);
 // <
 templated inline bool operator<(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(comparison);
     Snum::checkUnstableBranch(n1, n2);
     return n1.number < n2.number;
 };
@@ -332,6 +594,7 @@ set_Sbool_operator_casts(<);
 // <=
 templated inline bool operator<=(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(comparison);
     Snum::checkUnstableBranch(n1, n2);
     return n1.number <= n2.number;
 };
@@ -340,6 +603,7 @@ set_Sbool_operator_casts(<=);
 // >
 templated inline bool operator>(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(comparison);
     Snum::checkUnstableBranch(n1, n2);
     return n1.number > n2.number;
 };
@@ -348,6 +612,7 @@ set_Sbool_operator_casts(>);
 // >=
 templated inline bool operator>=(const Snum& n1, const Snum& n2)
 {
+    SHAMAN_COUNT_OPERATION(comparison);
     Snum::checkUnstableBranch(n1, n2);
     return n1.number >= n2.number;
 };
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <quadmath.h>
+
+/*
+ * QUAD PRECISION
+ *
+ * with SHAMAN_QUAD_PRECISION, Slong_double uses __float128 (libquadmath, link with -lquadmath) as its precise type
+ * so that its function errors are measured rather than always zero.
+ *
+ * this file puts the libquadmath functions in the std namespace (std::cos(__float128) calls cosq)
+ * which lets the Shaman functions call them exactly as they call the long double functions.
+ * quad precision functions are implemented in software and are thus much slower than their long double counterpart.
+ */
+
+// the std functions used by Shaman on its precise type
+#define SHAMAN_QUAD_FUNCTION(functionName) \
+    inline __float128 functionName(__float128 x) { return functionName##q(x); }
+#define SHAMAN_QUAD_FUNCTION2(functionName) \
+    inline __float128 functionName(__float128 x, __float128 y) { return functionName##q(x, y); }
+#define SHAMAN_QUAD_PREDICATE(functionName, quadFunctionName) \
+    inline bool functionName(__float128 x) { return quadFunctionName(x); }
+
+namespace std
+{
+    // trigonometric and hyperbolic functions
+    SHAMAN_QUAD_FUNCTION(cos)
+    SHAMAN_QUAD_FUNCTION(sin)
+    SHAMAN_QUAD_FUNCTION(tan)
+    SHAMAN_QUAD_FUNCTION(acos)
+    SHAMAN_QUAD_FUNCTION(asin)
+    SHAMAN_QUAD_FUNCTION(atan)
+    SHAMAN_QUAD_FUNCTION2(atan2)
+    SHAMAN_QUAD_FUNCTION(cosh)
+    SHAMAN_QUAD_FUNCTION(sinh)
+    SHAMAN_QUAD_FUNCTION(tanh)
+    SHAMAN_QUAD_FUNCTION(acosh)
+    SHAMAN_QUAD_FUNCTION(asinh)
+    SHAMAN_QUAD_FUNCTION(atanh)
+
+    // exponential and logarithmic functions
+    SHAMAN_QUAD_FUNCTION(exp)
+    SHAMAN_QUAD_FUNCTION(exp2)
+    SHAMAN_QUAD_FUNCTION(expm1)
+    SHAMAN_QUAD_FUNCTION(log)
+    SHAMAN_QUAD_FUNCTION(log10)
+    SHAMAN_QUAD_FUNCTION(log2)
+    SHAMAN_QUAD_FUNCTION(log1p)
+    SHAMAN_QUAD_FUNCTION(logb)
+    inline int ilogb(__float128 x) { return ilogbq(x); }
+    inline __float128 frexp(__float128 x, int* exponent) { return frexpq(x, exponent); }
+    inline __float128 ldexp(__float128 x, int exponent) { return ldexpq(x, exponent); }
+    inline __float128 scalbn(__float128 x, int exponent) { return scalbnq(x, exponent); }
+    inline __float128 scalbln(__float128 x, long int exponent) { return scalblnq(x, exponent); }
+    inline __float128 modf(__float128 x, __float128* intpart) { return modfq(x, intpart); }
+
+    // power functions
+    SHAMAN_QUAD_FUNCTION2(pow)
+    SHAMAN_QUAD_FUNCTION(sqrt)
+    SHAMAN_QUAD_FUNCTION(cbrt)
+    SHAMAN_QUAD_FUNCTION2(hypot)
+    inline __float128 hypot(__float128 x, __float128 y, __float128 z) { return hypotq(hypotq(x, y), z); }
+
+    // error and gamma functions
+    SHAMAN_QUAD_FUNCTION(erf)
+    SHAMAN_QUAD_FUNCTION(erfc)
+    SHAMAN_QUAD_FUNCTION(tgamma)
+    SHAMAN_QUAD_FUNCTION(lgamma)
+
+    // rounding and remainder functions
+    SHAMAN_QUAD_FUNCTION(ceil)
+    SHAMAN_QUAD_FUNCTION(floor)
+    SHAMAN_QUAD_FUNCTION(trunc)
+    SHAMAN_QUAD_FUNCTION(round)
+    SHAMAN_QUAD_FUNCTION(rint)
+    SHAMAN_QUAD_FUNCTION(nearbyint)
+    inline long int lround(__float128 x) { return lroundq(x); }
+    inline long long int llround(__float128 x) { return llroundq(x); }
+    inline long int lrint(__float128 x) { return lrintq(x); }
+    inline long long int llrint(__float128 x) { return llrintq(x); }
+    SHAMAN_QUAD_FUNCTION2(fmod)
+    SHAMAN_QUAD_FUNCTION2(remainder)
+    inline __float128 remquo(__float128 x, __float128 y, int* quotient) { return remquoq(x, y, quotient); }
+
+    // floating point manipulation and other functions
+    SHAMAN_QUAD_FUNCTION(fabs)
+    #ifdef __STRICT_ANSI__
+    // otherwise libstdc++ already provides it
+    inline __float128 abs(__float128 x) { return fabsq(x); }
+    #endif
+    SHAMAN_QUAD_FUNCTION2(copysign)
+    SHAMAN_QUAD_FUNCTION2(nextafter)
+    SHAMAN_QUAD_FUNCTION2(fdim)
+    SHAMAN_QUAD_FUNCTION2(fmin)
+    SHAMAN_QUAD_FUNCTION2(fmax)
+    inline __float128 fma(__float128 x, __float128 y, __float128 z) { return fmaq(x, y, z); }
+
+    // classification
+    SHAMAN_QUAD_PREDICATE(isnan, isnanq)
+    SHAMAN_QUAD_PREDICATE(isinf, isinfq)
+    SHAMAN_QUAD_PREDICATE(isfinite, finiteq)
+    SHAMAN_QUAD_PREDICATE(signbit, signbitq)
+}
+
+#undef SHAMAN_QUAD_FUNCTION
+#undef SHAMAN_QUAD_FUNCTION2
+#undef SHAMAN_QUAD_PREDICATE
@@ -0,0 +1,416 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "error_sum.h"
+
+/*
+ * POOLED ERROR COMPOSANTS
+ *
+ * with SHAMAN_POOLED_ERROR, the error composants of a number are not stored in the number (as an error_sum)
+ * but in a reference counted block allocated from a pool, the number only stores a pointer to its block.
+ *
+ * - a number without error does not allocate any block
+ * - copying a number shares its block, which is copied only when one of its owners modifies it (copy on write)
+ * - a block goes back to the pool of the current thread as soon as its last owner is destroyed
+ *
+ * the memory used by tagged error thus scales with the number of live numbers that have an error
+ * rather than with sizeof(S) (a number is one pointer larger than without tagged error).
+ */
+
+/*
+ * reference counted error composants
+ */
+template<typename errorType> struct error_block
+{
+    std::atomic<unsigned int> references; // number of error_pool pointing to the block
+    error_block* next; // next free block when the block is in a pool
+    std::array<errorType, error_sum<errorType>::maxTagNumber> errors;
+};
+
+namespace Shaman
+{
+    namespace detail
+    {
+        /*
+         * pool of blocks shared by all threads
+         * the pool is never destroyed (and its chunks never freed) as the blocks they contain might be owned by any thread
+         * or by a static number destroyed at program exit
+         */
+        template<typename errorType>
+        struct shared_block_pool
+        {
+            std::vector<std::unique_ptr<error_block<errorType>[]>> chunks;
+            error_block<errorType>* freeBlocks = nullptr; // blocks given back by the threads that exited
+            std::mutex mutex;
+
+            static shared_block_pool& instance()
+            {
+                static shared_block_pool* pool = new shared_block_pool; // leaked on purpose, see above
+                return *pool;
+            }
+
+            /*
+             * returns a list of free blocks
+             */
+            error_block<errorType>* acquire()
+            {
+                std::lock_guard<std::mutex> guard(mutex);
+                if(freeBlocks != nullptr)
+                {
+                    error_block<errorType>* blocks = freeBlocks;
+                    freeBlocks = nullptr;
+                    return blocks;
+                }
+                const std::size_t chunkSize = std::max(ShamanGlobals::session().poolChunkSize, std::size_t(1)); // SHAMAN_POOL_CHUNK_SIZE
+                chunks.emplace_back(new error_block<errorType>[chunkSize]);
+                error_block<errorType>* chunk = chunks.back().get();
+                for(std::size_t i = 0; i + 1 < chunkSize; i++)
+                {
+                    chunk[i].next = &chunk[i+1];
+                }
+                chunk[chunkSize-1].next = nullptr;
+                return chunk;
+            }
+
+            /*
+             * takes back a list of free blocks
+             */
+            void release(error_block<errorType>* blocks)
+            {
+                if(blocks == nullptr) return;
+                error_block<errorType>* last = blocks;
+                while(last->next != nullptr) last = last->next;
+                std::lock_guard<std::mutex> guard(mutex);
+                last->next = freeBlocks;
+                freeBlocks = blocks;
+            }
+        };
+
+        /*
+         * free blocks of the current thread, given back to the shared pool when the thread exits
+         */
+        template<typename errorType>
+        struct local_block_pool
+        {
+            error_block<errorType>* freeBlocks = nullptr;
+
+            ~local_block_pool()
+            {
+                destroyed() = true;
+                shared_block_pool<errorType>::instance().release(freeBlocks);
+            }
+
+            static local_block_pool& instance()
+            {
+                thread_local local_block_pool pool;
+                return pool;
+            }
+
+            /*
+             * true once the pool of the current thread has been destroyed
+             * (static numbers are destroyed after the thread_local variables of the main thread)
+             * the flag has no destructor and thus stays readable until the thread exits
+             */
+            static bool& destroyed()
+            {
+                thread_local bool isDestroyed = false;
+                return isDestroyed;
+            }
+
+            /*
+             * returns a block, with a single reference, whose content is unspecified
+             */
+            error_block<errorType>* allocate()
+            {
+                if(freeBlocks == nullptr)
+                {
+                    freeBlocks = shared_block_pool<errorType>::instance().acquire();
+                }
+                error_block<errorType>* block = freeBlocks;
+                freeBlocks = block->next;
+                block->references.store(1, std::memory_order_relaxed);
+                return block;
+            }
+
+            void deallocate(error_block<errorType>* block)
+            {
+                block->next = freeBlocks;
+                freeBlocks = block;
+            }
+        };
+    }
+}
+
+/*
+ * handle on pooled error composants with the interface of error_sum
+ */
+template<typename errorType> class error_pool
+{
+public:
+    static const size_t maxTagNumber = error_sum<errorType>::maxTagNumber;
+    error_block<errorType>* block; // composants of the error (nullptr if they are all zero)
+
+    /*
+     * empty constructor : currently no error
+     */
+    constexpr explicit error_pool(): block(nullptr) {}
+
+    /*
+     * copy constructors, the block is shared until one of the handles modifies it
+     */
+    error_pool(const error_pool& errorPool2): block(errorPool2.block)
+    {
+        if(block != nullptr) block->references.fetch_add(1, std::memory_order_relaxed);
+    }
+    error_pool(error_pool&& errorPool2) noexcept: block(errorPool2.block)
+    {
+        errorPool2.block = nullptr;
+    }
+    error_pool& operator=(const error_pool& errorPool2)
+    {
+        error_pool copy(errorPool2);
+        std::swap(block, copy.block);
+        return *this;
+    }
+    error_pool& operator=(error_pool&& errorPool2) noexcept
+    {
+        std::swap(block, errorPool2.block);
+        return *this;
+    }
+    ~error_pool()
+    {
+        release();
+    }
+
+    /*
+     * copy constructor that allows construction from composants with another error type
+     */
+    template<typename errorType2>
+    error_pool(const error_pool<errorType2>& errorPool2): block(nullptr)
+    {
+        if(errorPool2.block == nullptr) return;
+        block = allocate();
+        std::copy(errorPool2.block->errors.begin(), errorPool2.block->errors.end(), block->errors.begin());
+    }
+
+    /*
+     * returns composants with a single element (singleton)
+     */
+    error_pool(Tag tag, errorType error): block(nullptr)
+    {
+        checkTag(tag);
+        if(error == errorType(0)) return;
+        block = allocate();
+        block->errors.fill(errorType(0));
+        block->errors[tag] = error;
+    }
+
+    /*
+     * returns composants with a single element (singleton)
+     * uses the current tag
+     */
+    explicit error_pool(errorType error): error_pool(CodeBlock::currentBlock(), error) {}
+
+    /*
+     * constructor that takes a function such that errors[i] = function(errorsum1[i])
+     * NOTE: the function is assumed to map zero to zero (which is the case of all error propagations)
+     */
+    template<typename FUN>
+    error_pool(const error_pool& errorPool, FUN function): block(nullptr)
+    {
+        if(errorPool.block == nullptr) return;
+        block = allocate();
+        std::transform(errorPool.block->errors.begin(), errorPool.block->errors.end(), block->errors.begin(), function);
+    }
+
+    /*
+     * constructor that takes a function such that errors[i] = function(errorsum1[i], errorsum2[i])
+     * NOTE: the function is assumed to map zeros to zero (which is the case of all error propagations)
+     */
+    template<typename FUN>
+    error_pool(const error_pool& errorPool1, const error_pool& errorPool2, FUN function): block(nullptr)
+    {
+        if((errorPool1.block == nullptr) and (errorPool2.block == nullptr)) return;
+        block = allocate();
+        if(errorPool2.block == nullptr)
+        {
+            std::transform(errorPool1.block->errors.begin(), errorPool1.block->errors.end(), block->errors.begin(),
+                           [&function](errorType e1){return function(e1, errorType(0));});
+        }
+        else if(errorPool1.block == nullptr)
+        {
+            std::transform(errorPool2.block->errors.begin(), errorPool2.block->errors.end(), block->errors.begin(),
+                           [&function](errorType e2){return function(errorType(0), e2);});
+        }
+        else
+        {
+            std::transform(errorPool1.block->errors.begin(), errorPool1.block->errors.end(), errorPool2.block->errors.begin(), block->errors.begin(), function);
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    // OPERATIONS
+
+    /*
+     * += error
+     */
+    void addError(errorType error)
+    {
+        Tag tag = CodeBlock::currentBlock();
+        checkTag(tag);
+        if(error == errorType(0)) return;
+        makeWritable();
+        block->errors[tag] += error;
+    }
+
+    /*
+     * *= scalar
+     * (the scalar is not converted to errorType, which might not be able to represent it)
+     */
+    template<typename T>
+    void multByScalar(T scalar)
+    {
+        if(block == nullptr) return;
+        makeWritable();
+        std::transform(block->errors.begin(), block->errors.end(), block->errors.begin(), [scalar](errorType x){return x*scalar;});
+    }
+
+    /*
+     * /= scalar
+     */
+    template<typename T>
+    void divByScalar(T scalar)
+    {
+        if(block == nullptr) return;
+        makeWritable();
+        std::transform(block->errors.begin(), block->errors.end(), block->errors.begin(), [scalar](errorType x){return x/scalar;});
+    }
+
+    /*
+     * += errorComposants
+     */
+    void addErrors(const error_pool& errorPool2)
+    {
+        if(errorPool2.block == nullptr) return;
+        if(block == nullptr)
+        {
+            *this = errorPool2; // shares the composants rather than copying them
+            return;
+        }
+        makeWritable();
+        std::transform(block->errors.begin(), block->errors.end(), errorPool2.block->errors.begin(), block->errors.begin(), std::plus<errorType>());
+    }
+
+    /*
+     * -= errorComposants
+     */
+    void subErrors(const error_pool& errorPool2)
+    {
+        if(errorPool2.block == nullptr) return;
+        makeWritable();
+        std::transform(block->errors.begin(), block->errors.end(), errorPool2.block->errors.begin(), block->errors.begin(), std::minus<errorType>());
+    }
+
+    /*
+     * += scalar * errorComposants
+     */
+    template<typename T>
+    void addErrorsTimeScalar(const error_pool& errorPool2, T scalar)
+    {
+        if(errorPool2.block == nullptr) return;
+        makeWritable();
+        std::transform(block->errors.begin(), block->errors.end(), errorPool2.block->errors.begin(), block->errors.begin(), [scalar](errorType e1, errorType e2){return e1 + e2*scalar;});
+    }
+
+    //-------------------------------------------------------------------------
+    // CONVERSION
+
+    /*
+     * copies the composants into an error_sum
+     */
+    operator error_sum<errorType>() const
+    {
+        error_sum<errorType> result;
+        if(block != nullptr) result.errors = block->errors;
+        return result;
+    }
+
+    /*
+     * produces a readable string representation of the error terms (see error_sum)
+     */
+    explicit operator std::string() const
+    {
+        return std::string(error_sum<errorType>(*this));
+    }
+
+private:
+    using local_pool = Shaman::detail::local_block_pool<errorType>;
+    using shared_pool = Shaman::detail::shared_block_pool<errorType>;
+
+    static error_block<errorType>* allocate()
+    {
+        if(local_pool::destroyed())
+        {
+            // keeps one block and gives the others back to the shared pool
+            error_block<errorType>* block = shared_pool::instance().acquire();
+            shared_pool::instance().release(block->next);
+            block->references.store(1, std::memory_order_relaxed);
+            return block;
+        }
+        return local_pool::instance().allocate();
+    }
+
+    /*
+     * drops the reference to the block, giving it back to the pool if it was the last one
+     */
+    void release()
+    {
+        if((block != nullptr) and (block->references.fetch_sub(1, std::memory_order_acq_rel) == 1))
+        {
+            if(local_pool::destroyed())
+            {
+                block->next = nullptr;
+                shared_pool::instance().release(block);
+            }
+            else
+            {
+                local_pool::instance().deallocate(block);
+            }
+        }
+        block = nullptr;
+    }
+
+    /*
+     * makes sure that the block exists and is not shared, so that it can be modified in place
+     */
+    void makeWritable()
+    {
+        if(block == nullptr)
+        {
+            block = allocate();
+            block->errors.fill(errorType(0));
+        }
+        else if(block->references.load(std::memory_order_acquire) != 1)
+        {
+            error_block<errorType>* copy = allocate();
+            copy->errors = block->errors;
+            release();
+            block = copy;
+        }
+    }
+
+    static void checkTag(Tag tag)
+    {
+        if(tag >= maxTagNumber)
+        {
+            std::string errorMessage = "SHAMAN: You have been using more than " + std::to_string(SHAMAN_TAGNUMBER) + " tags. Please set SHAMAN_TAGNUMBER to a larger number or reduce the number of FUNCTION_BLOCK/LOCAL_BLOCK in the code.";
+            throw std::runtime_error(errorMessage);
+        }
+    }
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <array>
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
@@ -127,8 +128,10 @@ public:
 
     /*
      * *= scalar
+     * (the scalar is not converted to errorType, which might not be able to represent it)
      */
-    void multByScalar(errorType scalar)
+    template<typename T>
+    void multByScalar(T scalar)
     {
         std::transform(errors.begin(), errors.end(), errors.begin(), [scalar](errorType x){return x*scalar;});
     }
@@ -136,7 +139,8 @@ public:
     /*
      * /= scalar
      */
-    void divByScalar(errorType scalar)
+    template<typename T>
+    void divByScalar(T scalar)
     {
         std::transform(errors.begin(), errors.end(), errors.begin(), [scalar](errorType x){return x/scalar;});
     }
@@ -160,7 +164,8 @@ public:
     /*
      * += scalar * errorComposants
      */
-    void addErrorsTimeScalar(const error_sum& errorSum2, errorType scalar)
+    template<typename T>
+    void addErrorsTimeScalar(const error_sum& errorSum2, T scalar)
     {
         std::transform(errors.begin(), errors.end(), errorSum2.errors.begin(), errors.begin(), [scalar](errorType e1, errorType e2){return e1 + e2*scalar;});
     }
@@ -235,7 +240,7 @@ public:
             auto kv = data[0];
             output << CodeBlock::nameOfTag(kv.first) << ':' << kv.second << '%';
 
-            for(int i = 1; i < data.size(); i++)
+            for(std::size_t i = 1; i < data.size(); i++)
             {
                 kv = data[i];
                 output << ", " << CodeBlock::nameOfTag(kv.first) << ':' << kv.second << '%';
@@ -0,0 +1,349 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <type_traits>
+#include "error_sum.h"
+
+/*
+ * ERROR TAPE
+ *
+ * with SHAMAN_TAPE, the error composants of a number are not propagated forward as an error_sum (one error per tag)
+ * instead, each operation is recorded on a thread local tape (its local error, its tag and the linear dependency of its error on the errors of its operands)
+ * and a number only stores the last operation that contributed to its error.
+ *
+ * the forward run thus costs about as much as an untagged run (a number is one pointer larger),
+ * the attribution of the error of a number to the tags (or to individual operations) is done on demand by a reverse sweep of the tape.
+ *
+ * NOTE: the tape grows with the number of operations performed, use Shaman::tape_checkpoint to shrink it
+ * NOTE: the tape stores errors and coefficients as double
+ */
+
+/*
+ * storage for the operations recorded by a thread
+ * the nodes are allocated in chunks and never move once allocated (numbers and other threads hold pointers to them)
+ */
+class TapeArena
+{
+public:
+    static const std::size_t chunkSize = 1 << 16;
+    std::vector<std::unique_ptr<TapeNode[]>> chunks; // chunks are kept when the tape is cleared, to be reused
+    std::size_t size = 0; // number of nodes in use
+
+    inline TapeNode* allocate()
+    {
+        const std::size_t chunk = size / chunkSize;
+        if(chunk == chunks.size())
+        {
+            chunks.emplace_back(new TapeNode[chunkSize]);
+        }
+        TapeNode* node = &chunks[chunk][size % chunkSize];
+        size++;
+        return node;
+    }
+
+    /*
+     * returns the index of the node in the arena or size if the node does not belong to the arena
+     */
+    std::size_t indexOf(const TapeNode* node) const
+    {
+        for(std::size_t chunk = 0; chunk < chunks.size(); chunk++)
+        {
+            const TapeNode* first = chunks[chunk].get();
+            if((node >= first) and (node < first + chunkSize))
+            {
+                const std::size_t index = chunk*chunkSize + std::size_t(node - first);
+                return (index < size) ? index : size;
+            }
+        }
+        return size;
+    }
+};
+
+namespace Shaman
+{
+    namespace detail
+    {
+        /*
+         * returns the tape of the current thread
+         */
+        inline TapeArena& localTape()
+        {
+            auto& tape = ShamanGlobals::localTape;
+            if(not tape)
+            {
+                tape = std::make_shared<TapeArena>();
+                std::lock_guard<std::mutex> guard(ShamanGlobals::mutexTapes);
+                ShamanGlobals::tapes.push_back(tape);
+            }
+            return *tape;
+        }
+
+        /*
+         * records an operation whose error is coefficient1*error(parent1) + coefficient2*error(parent2) + localError
+         * returns the node representing the error of the result (nullptr if it is zero, the parent if it is unchanged)
+         */
+        inline const TapeNode* recordOperation(const TapeNode* parent1, double coefficient1, const TapeNode* parent2, double coefficient2, double localError, Tag tag)
+        {
+            if(coefficient1 == 0) parent1 = nullptr;
+            if(coefficient2 == 0) parent2 = nullptr;
+            if(parent1 == nullptr)
+            {
+                parent1 = parent2;
+                coefficient1 = coefficient2;
+                parent2 = nullptr;
+            }
+            if((parent1 == nullptr) and (localError == 0)) return nullptr;
+            if((parent2 == nullptr) and (coefficient1 == 1) and (localError == 0)) return parent1;
+
+            TapeNode* node = localTape().allocate();
+            node->parents[0] = parent1;
+            node->parents[1] = parent2;
+            node->coefficients[0] = coefficient1;
+            node->coefficients[1] = coefficient2;
+            node->localError = localError;
+            node->tag = tag;
+            return node;
+        }
+
+        /*
+         * reverse sweep : calls function(node, contribution) for each operation that contributed to the error of the output
+         * where contribution is the part of the error of the output due to the local error of the operation
+         */
+        template<typename FUN>
+        void sweepTape(const TapeNode* output, FUN function)
+        {
+            if(output == nullptr) return;
+
+            struct Adjoint
+            {
+                double value = 0; // derivative of the error of the output with respect to the error of the node
+                std::size_t pendingChildren = 0; // number of edges, from nodes not yet processed, leading to the node
+            };
+            std::unordered_map<const TapeNode*, Adjoint> adjoints;
+
+            // finds the nodes reachable from the output and counts the edges leading to them
+            std::vector<const TapeNode*> stack = {output};
+            adjoints[output];
+            while(not stack.empty())
+            {
+                const TapeNode* node = stack.back();
+                stack.pop_back();
+                for(const TapeNode* parent : node->parents)
+                {
+                    if(parent == nullptr) continue;
+                    auto inserted = adjoints.emplace(parent, Adjoint());
+                    inserted.first->second.pendingChildren++;
+                    if(inserted.second) stack.push_back(parent);
+                }
+            }
+
+            // propagates the adjoints from the output to the inputs, processing a node once all its children have been processed
+            adjoints[output].value = 1;
+            stack.push_back(output);
+            while(not stack.empty())
+            {
+                const TapeNode* node = stack.back();
+                stack.pop_back();
+                const double adjoint = adjoints[node].value;
+                if(node->localError != 0)
+                {
+                    function(*node, adjoint * node->localError);
+                }
+                for(int i = 0; i < 2; i++)
+                {
+                    const TapeNode* parent = node->parents[i];
+                    if(parent == nullptr) continue;
+                    Adjoint& parentAdjoint = adjoints[parent];
+                    parentAdjoint.value += adjoint * node->coefficients[i];
+                    if(--parentAdjoint.pendingChildren == 0) stack.push_back(parent);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * handle on the tape with the interface of error_sum
+ * the operations taking a function assume that it is linear (which is the case of all error propagations)
+ */
+template<typename errorType> class error_tape
+{
+public:
+    static const size_t maxTagNumber = error_sum<errorType>::maxTagNumber;
+    const TapeNode* node; // last operation that contributed to the error (nullptr if there is no error)
+    // true if the node was recorded by this handle and is not shared with any other handle
+    // (an operation adding its rounding error then completes the node rather than recording a new one)
+    mutable bool ownsNode;
+
+    /*
+     * empty constructor : currently no error
+     */
+    constexpr explicit error_tape(): node(nullptr), ownsNode(false) {}
+
+    /*
+     * copy constructors, the node is then shared by both handles
+     */
+    error_tape(const error_tape& errorTape2): node(errorTape2.node), ownsNode(false)
+    {
+        errorTape2.ownsNode = false;
+    }
+    error_tape& operator=(const error_tape& errorTape2)
+    {
+        node = errorTape2.node;
+        ownsNode = false;
+        errorTape2.ownsNode = false;
+        return *this;
+    }
+
+    /*
+     * copy constructor that allows construction from a handle with another error type
+     */
+    template<typename errorType2>
+    error_tape(const error_tape<errorType2>& errorTape2): node(errorTape2.node), ownsNode(false)
+    {
+        errorTape2.ownsNode = false;
+    }
+
+    /*
+     * returns a handle with a single error
+     */
+    error_tape(Tag tag, errorType error): node(Shaman::detail::recordOperation(nullptr, 0, nullptr, 0, double(error), tag)), ownsNode(false) {}
+
+    /*
+     * returns a handle with a single error
+     * uses the current tag
+     */
+    explicit error_tape(errorType error): error_tape(CodeBlock::currentBlock(), error) {}
+
+    /*
+     * constructor that takes a linear function such that error = function(error1)
+     */
+    template<typename FUN>
+    error_tape(const error_tape& errorTape, FUN function): error_tape()
+    {
+        record(&errorTape, double(function(errorType(1))), nullptr, 0);
+    }
+
+    /*
+     * constructor that takes a linear function such that error = function(error1, error2)
+     */
+    template<typename FUN>
+    error_tape(const error_tape& errorTape1, const error_tape& errorTape2, FUN function): error_tape()
+    {
+        record(&errorTape1, double(function(errorType(1), errorType(0))), &errorTape2, double(function(errorType(0), errorType(1))));
+    }
+
+    //-------------------------------------------------------------------------
+    // OPERATIONS
+
+    /*
+     * += error
+     */
+    void addError(errorType error)
+    {
+        if(error == errorType(0)) return;
+        if(ownsNode and (node->localError == 0))
+        {
+            // completes the operation recorded by this handle
+            TapeNode* ownedNode = const_cast<TapeNode*>(node);
+            ownedNode->localError = double(error);
+            ownedNode->tag = CodeBlock::currentBlock();
+        }
+        else
+        {
+            node = Shaman::detail::recordOperation(node, 1, nullptr, 0, double(error), CodeBlock::currentBlock());
+            ownsNode = false;
+        }
+    }
+
+    /*
+     * *= scalar
+     */
+    template<typename T>
+    void multByScalar(T scalar)
+    {
+        record(this, double(scalar), nullptr, 0);
+    }
+
+    /*
+     * /= scalar
+     */
+    template<typename T>
+    void divByScalar(T scalar)
+    {
+        record(this, double(errorType(1) / scalar), nullptr, 0);
+    }
+
+    /*
+     * += errorComposants
+     */
+    void addErrors(const error_tape& errorTape2)
+    {
+        record(this, 1, &errorTape2, 1);
+    }
+
+    /*
+     * -= errorComposants
+     */
+    void subErrors(const error_tape& errorTape2)
+    {
+        record(this, 1, &errorTape2, -1);
+    }
+
+    /*
+     * += scalar * errorComposants
+     */
+    template<typename T>
+    void addErrorsTimeScalar(const error_tape& errorTape2, T scalar)
+    {
+        record(this, 1, &errorTape2, double(scalar));
+    }
+
+    //-------------------------------------------------------------------------
+    // ATTRIBUTION
+
+    /*
+     * attributes the error to the tags with a reverse sweep of the tape
+     */
+    operator error_sum<errorType>() const
+    {
+        error_sum<errorType> result;
+        Shaman::detail::sweepTape(node, [&result](const TapeNode& operation, double error)
+        {
+            result.addErrors(error_sum<errorType>(operation.tag, errorType(error)));
+        });
+        return result;
+    }
+
+    /*
+     * produces a readable string representation of the error terms (see error_sum)
+     */
+    explicit operator std::string() const
+    {
+        return std::string(error_sum<errorType>(*this));
+    }
+
+private:
+    /*
+     * records an operation without local error on the nodes of the given handles (nullptr for no operand)
+     * the handle owns the new node (if any) while the operands lose the ownership of their nodes,
+     * which are now parents of (or shared with) this handle and can thus no longer be completed in place
+     */
+    void record(const error_tape* operand1, double coefficient1, const error_tape* operand2, double coefficient2)
+    {
+        const TapeNode* parent1 = (operand1 == nullptr) ? nullptr : operand1->node;
+        const TapeNode* parent2 = (operand2 == nullptr) ? nullptr : operand2->node;
+        const TapeNode* newNode = Shaman::detail::recordOperation(parent1, coefficient1, parent2, coefficient2, 0, 0);
+        const bool isUnchanged = (operand1 == this) and (newNode == parent1);
+        if(not isUnchanged)
+        {
+            if(operand1 != nullptr) operand1->ownsNode = false;
+            if(operand2 != nullptr) operand2->ownsNode = false;
+            ownsNode = (newNode != nullptr) and (newNode != parent1) and (newNode != parent2);
+        }
+        node = newNode;
+    }
+};
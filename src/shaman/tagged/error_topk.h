@@ -0,0 +1,370 @@
+#pragma once
+
+#include <cmath>
+#include <array>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include "error_sum.h"
+
+#ifndef SHAMAN_TOPK
+#define SHAMAN_TOPK 4
+#endif
+
+/*
+ * TOP-K ERROR COMPOSANTS
+ *
+ * with SHAMAN_TOPK_ERROR, a number only keeps the error composants of the SHAMAN_TOPK tags with the largest errors
+ * the errors of the other tags are summed into a residual (displayed as 'other')
+ *
+ * an operation thus costs O(SHAMAN_TOPK) rather than O(SHAMAN_TAGNUMBER) and the number of tags is not bounded by SHAMAN_TAGNUMBER
+ * NOTE: a tag that is evicted into the residual cannot be recovered, its later errors are attributed to it again from zero
+ * NOTE: the conversion to error_sum drops the residual and the tags beyond SHAMAN_TAGNUMBER
+ */
+template<typename errorType> class error_topk
+{
+public:
+    static const size_t capacity = SHAMAN_TOPK;
+    static const size_t maxTagNumber = error_sum<errorType>::maxTagNumber;
+    // composants sorted by increasing tag, only the first 'size' are in use
+    std::array<Tag, capacity> tags;
+    std::array<errorType, capacity> errors;
+    unsigned int size;
+    errorType residual; // sum of the errors of the tags that are not kept
+
+    /*
+     * empty constructor : currently no error
+     */
+    constexpr explicit error_topk(): tags(), errors(), size(0), residual() {}
+
+    /*
+     * copy constructor that allows construction from composants with another error type
+     */
+    template<typename errorType2>
+    error_topk(const error_topk<errorType2>& errorTopk2): tags(errorTopk2.tags), errors(), size(errorTopk2.size), residual(errorTopk2.residual)
+    {
+        for(unsigned int i = 0; i < size; i++)
+        {
+            errors[i] = errorTopk2.errors[i];
+        }
+    }
+
+    /*
+     * returns composants with a single element (singleton)
+     */
+    error_topk(Tag tag, errorType error): error_topk()
+    {
+        tags[0] = tag;
+        errors[0] = error;
+        size = 1;
+    }
+
+    /*
+     * returns composants with a single element (singleton)
+     * uses the current tag
+     */
+    explicit error_topk(errorType error): error_topk(CodeBlock::currentBlock(), error) {}
+
+    /*
+     * constructor that takes a function such that errors[i] = function(errorsum1[i])
+     * NOTE: the function is assumed to be linear (which is the case of all error propagations)
+     */
+    template<typename FUN>
+    error_topk(const error_topk& errorTopk, FUN function): tags(errorTopk.tags), errors(), size(errorTopk.size), residual(function(errorTopk.residual))
+    {
+        std::transform(errorTopk.errors.begin(), errorTopk.errors.begin() + size, errors.begin(), function);
+    }
+
+    /*
+     * constructor that takes a function such that errors[i] = function(errorsum1[i], errorsum2[i])
+     * NOTE: the function is assumed to be linear (which is the case of all error propagations)
+     */
+    template<typename FUN>
+    error_topk(const error_topk& errorTopk1, const error_topk& errorTopk2, FUN function): error_topk()
+    {
+        merge(errorTopk1, errorTopk2, function);
+    }
+
+    //-------------------------------------------------------------------------
+    // OPERATIONS
+
+    /*
+     * += error
+     */
+    void addError(errorType error)
+    {
+        // a zero error would take a composant without contributing to it
+        if(error == errorType(0)) return;
+
+        const Tag tag = CodeBlock::currentBlock();
+
+        // finds the first composant whose tag is not smaller than the tag
+        unsigned int position = 0;
+        for(unsigned int i = 0; i < size; i++)
+        {
+            position += (tags[i] < tag);
+        }
+
+        if((position < size) and (tags[position] == tag))
+        {
+            errors[position] += error;
+        }
+        else if(size < capacity)
+        {
+            insert(position, tag, error);
+        }
+        else
+        {
+            // replaces the smallest composant if the error is larger
+            unsigned int smallest = 0;
+            for(unsigned int i = 1; i < size; i++)
+            {
+                smallest = (magnitude(errors[i]) < magnitude(errors[smallest])) ? i : smallest;
+            }
+            if(magnitude(error) <= magnitude(errors[smallest]))
+            {
+                residual += error;
+                return;
+            }
+            residual += errors[smallest];
+            remove(smallest);
+            if(smallest < position) position--;
+            insert(position, tag, error);
+        }
+    }
+
+    /*
+     * *= scalar
+     * (the scalar is not converted to errorType, which might not be able to represent it)
+     */
+    template<typename T>
+    void multByScalar(T scalar)
+    {
+        std::transform(errors.begin(), errors.begin() + size, errors.begin(), [scalar](errorType x){return x*scalar;});
+        residual = residual*scalar;
+    }
+
+    /*
+     * /= scalar
+     */
+    template<typename T>
+    void divByScalar(T scalar)
+    {
+        std::transform(errors.begin(), errors.begin() + size, errors.begin(), [scalar](errorType x){return x/scalar;});
+        residual = residual/scalar;
+    }
+
+    /*
+     * += errorComposants
+     */
+    void addErrors(const error_topk& errorTopk2)
+    {
+        const error_topk errorTopk1 = *this;
+        merge(errorTopk1, errorTopk2, std::plus<errorType>());
+    }
+
+    /*
+     * -= errorComposants
+     */
+    void subErrors(const error_topk& errorTopk2)
+    {
+        const error_topk errorTopk1 = *this;
+        merge(errorTopk1, errorTopk2, std::minus<errorType>());
+    }
+
+    /*
+     * += scalar * errorComposants
+     */
+    template<typename T>
+    void addErrorsTimeScalar(const error_topk& errorTopk2, T scalar)
+    {
+        const error_topk errorTopk1 = *this;
+        merge(errorTopk1, errorTopk2, [scalar](errorType e1, errorType e2){return e1 + e2*scalar;});
+    }
+
+    //-------------------------------------------------------------------------
+    // CONVERSION
+
+    /*
+     * copies the composants into an error_sum
+     * (the residual and the tags beyond SHAMAN_TAGNUMBER are dropped)
+     */
+    operator error_sum<errorType>() const
+    {
+        error_sum<errorType> result;
+        for(unsigned int i = 0; i < size; i++)
+        {
+            if(tags[i] < maxTagNumber) result.errors[tags[i]] = errors[i];
+        }
+        return result;
+    }
+
+    /*
+     * produces a readable string representation of the error terms (see error_sum)
+     * the residual is displayed as 'other'
+     */
+    explicit operator std::string() const
+    {
+        const int minErrorPercent = 5;
+
+        // computes the sum of abs(error) and the sign of the sum of errors
+        errorType totalAbsoluteError = std::fabs(residual);
+        errorType totalError = residual;
+        for(unsigned int i = 0; i < size; i++)
+        {
+            totalAbsoluteError += std::fabs(errors[i]);
+            totalError += errors[i];
+        }
+        totalAbsoluteError = std::copysign(totalAbsoluteError, totalError);
+        if(totalAbsoluteError == 0.)
+        {
+            return "[]";
+        }
+
+        // collects the relevant data expressed in percent of the total error
+        std::vector<std::pair<std::string, errorType>> data;
+        bool droppedNonSignificantTerms = false;
+        auto collect = [&](const std::string& name, errorType error)
+        {
+            if(std::isnan(error) || std::isinf(error))
+            {
+                data.push_back(std::make_pair(name, error));
+                return;
+            }
+            int percent = (error*100.) / totalAbsoluteError;
+            if(std::abs(percent) >= minErrorPercent)
+            {
+                data.push_back(std::make_pair(name, percent));
+            }
+            else if(error != 0)
+            {
+                droppedNonSignificantTerms = true;
+            }
+        };
+        for(unsigned int i = 0; i < size; i++)
+        {
+            collect(CodeBlock::nameOfTag(tags[i]), errors[i]);
+        }
+        collect("other", residual);
+
+        // sorts the vector by abs(error) descending
+        std::stable_sort(data.begin(), data.end(), [](const std::pair<std::string, errorType>& p1, const std::pair<std::string, errorType>& p2)
+                         {return std::fabs(p1.second) > std::fabs(p2.second);});
+
+        std::ostringstream output;
+        output << '[';
+        for(unsigned int i = 0; i < data.size(); i++)
+        {
+            if(i > 0) output << ", ";
+            output << data[i].first << ':' << data[i].second << '%';
+        }
+        if(droppedNonSignificantTerms)
+        {
+            output << "…";
+        }
+        output << ']';
+        return output.str();
+    }
+
+private:
+    /*
+     * absolute value used to rank the composants (nan ranks as the largest error)
+     */
+    static errorType magnitude(errorType error)
+    {
+        return std::isnan(error) ? std::numeric_limits<errorType>::infinity() : std::abs(error);
+    }
+
+    void insert(unsigned int position, Tag tag, errorType error)
+    {
+        for(unsigned int i = size; i > position; i--)
+        {
+            tags[i] = tags[i-1];
+            errors[i] = errors[i-1];
+        }
+        tags[position] = tag;
+        errors[position] = error;
+        size++;
+    }
+
+    void remove(unsigned int position)
+    {
+        for(unsigned int i = position; i + 1 < size; i++)
+        {
+            tags[i] = tags[i+1];
+            errors[i] = errors[i+1];
+        }
+        size--;
+    }
+
+    /*
+     * sets the composants to function(errorTopk1, errorTopk2)
+     * both operands being sorted by tag, they are joined in a single pass
+     * then only the 'capacity' largest composants are kept, the others being added to the residual
+     */
+    template<typename FUN>
+    void merge(const error_topk& errorTopk1, const error_topk& errorTopk2, FUN function)
+    {
+        std::array<Tag, 2*capacity> mergedTags;
+        std::array<errorType, 2*capacity> mergedErrors;
+        unsigned int mergedSize = 0;
+        unsigned int i1 = 0;
+        unsigned int i2 = 0;
+        while((i1 < errorTopk1.size) or (i2 < errorTopk2.size))
+        {
+            const bool has1 = (i1 < errorTopk1.size) and ((i2 == errorTopk2.size) or (errorTopk1.tags[i1] <= errorTopk2.tags[i2]));
+            const bool has2 = (i2 < errorTopk2.size) and ((i1 == errorTopk1.size) or (errorTopk2.tags[i2] <= errorTopk1.tags[i1]));
+            const errorType e1 = has1 ? errorTopk1.errors[i1] : errorType(0);
+            const errorType e2 = has2 ? errorTopk2.errors[i2] : errorType(0);
+            mergedTags[mergedSize] = has1 ? errorTopk1.tags[i1] : errorTopk2.tags[i2];
+            mergedErrors[mergedSize] = function(e1, e2);
+            mergedSize++;
+            i1 += has1;
+            i2 += has2;
+        }
+        residual = function(errorTopk1.residual, errorTopk2.residual);
+
+        // finds the magnitude of the smallest composant that is kept
+        errorType threshold = 0;
+        unsigned int kept = mergedSize;
+        if(mergedSize > capacity)
+        {
+            std::array<errorType, 2*capacity> magnitudes;
+            for(unsigned int i = 0; i < mergedSize; i++)
+            {
+                magnitudes[i] = magnitude(mergedErrors[i]);
+            }
+            std::nth_element(magnitudes.begin(), magnitudes.begin() + (capacity - 1), magnitudes.begin() + mergedSize, std::greater<errorType>());
+            threshold = magnitudes[capacity - 1];
+            kept = capacity;
+        }
+
+        // keeps the composants above the threshold, in tag order (ties are kept first come first served)
+        unsigned int strictlyAbove = 0;
+        for(unsigned int i = 0; i < mergedSize; i++)
+        {
+            strictlyAbove += (magnitude(mergedErrors[i]) > threshold);
+        }
+        unsigned int tiesLeft = kept - std::min(kept, strictlyAbove);
+        size = 0;
+        for(unsigned int i = 0; i < mergedSize; i++)
+        {
+            const errorType errorMagnitude = magnitude(mergedErrors[i]);
+            const bool isTie = (errorMagnitude == threshold) and (mergedSize > capacity);
+            const bool keep = (mergedSize <= capacity) or (errorMagnitude > threshold) or (isTie and (tiesLeft > 0));
+            tiesLeft -= (keep and isTie);
+            if(keep)
+            {
+                tags[size] = mergedTags[i];
+                errors[size] = mergedErrors[i];
+                size++;
+            }
+            else
+            {
+                residual += mergedErrors[i];
+            }
+        }
+    }
+};
@@ -1,13 +1,179 @@
 #include "global_vars.h"
 
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#if defined(__has_include)
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define SHAMAN_HAS_BACKTRACE
+#endif
+#endif
+
+//-----------------------------------------------------------------------------
+// SESSION
+
+namespace
+{
+    /*
+     * reads a strictly positive number from an environment variable
+     * returns false (and leaves the value untouched) if the variable is unset or invalid
+     */
+    template<typename T>
+    bool readEnvironment(const char* name, T& value)
+    {
+        const char* text = std::getenv(name);
+        if((text == nullptr) or (*text == '\0')) return false;
+        char* end = nullptr;
+        const double number = std::strtod(text, &end);
+        if((*end != '\0') or not std::isfinite(number) or not (T(number) > T(0)))
+        {
+            std::cerr << "#SHAMAN: ignoring " << name << "='" << text << "', a strictly positive number was expected." << std::endl;
+            return false;
+        }
+        value = T(number);
+        return true;
+    }
+
+    /*
+     * reads one of the given choices from an environment variable
+     * returns its index, or -1 if the variable is unset or invalid
+     */
+    int readEnvironmentChoice(const char* name, std::initializer_list<const char*> choices)
+    {
+        const char* text = std::getenv(name);
+        if((text == nullptr) or (*text == '\0')) return -1;
+        int index = 0;
+        for(const char* choice : choices)
+        {
+            if(std::strcmp(text, choice) == 0) return index;
+            index++;
+        }
+        std::cerr << "#SHAMAN: ignoring " << name << "='" << text << "', expected one of :";
+        for(const char* choice : choices) std::cerr << ' ' << choice;
+        std::cerr << std::endl;
+        return -1;
+    }
+}
+
+Shaman::Session::Session()
+{
+    double unstableDigits;
+    if(readEnvironment("SHAMAN_UNSTABLE_DIGITS", unstableDigits)) significanceBase = std::pow(10., unstableDigits);
+    if(const char* path = std::getenv("SHAMAN_REPORT_PATH")) reportPath = path;
+    readEnvironment("SHAMAN_POOL_CHUNK_SIZE", poolChunkSize);
+    readEnvironment("SHAMAN_WATCH_CAPACITY", watchCapacity);
+    readEnvironment("SHAMAN_UNSTABLE_BREAK", unstableBreak);
+    readEnvironment("SHAMAN_UNSTABLE_SAMPLING", unstableSampling);
+    const int action = readEnvironmentChoice("SHAMAN_UNSTABLE_ACTION", {"trap", "backtrace", "hook"});
+    if(action >= 0) unstableAction = UnstableAction(action);
+    const int counter = readEnvironmentChoice("SHAMAN_UNSTABLE_COUNTER", {"global", "thread"});
+    if(counter >= 0) unstableCounterPerThread = (counter == 1);
+}
+
+Shaman::Session::ReportWriter Shaman::Session::report()
+{
+    std::unique_lock<std::mutex> lock(mutexReport);
+    if(reportPath.empty())
+    {
+        reportFile.reset(); // closes the previous report file
+        return ReportWriter(std::move(lock), std::cout);
+    }
+    if((not reportFile) or (reportFilePath != reportPath))
+    {
+        reportFile = std::make_shared<std::ofstream>(reportPath, std::ios::app);
+        reportFilePath = reportPath;
+        if(not *reportFile)
+        {
+            std::cerr << "#SHAMAN: could not open the report file '" << reportPath << "', reporting to the standard output." << std::endl;
+            reportFile.reset();
+            reportPath.clear();
+            return ReportWriter(std::move(lock), std::cout);
+        }
+    }
+    return ReportWriter(std::move(lock), *reportFile);
+}
+
+void Shaman::Session::breakOnUnstableBranch(long long unstableTest)
+{
+    switch(unstableAction)
+    {
+        case UnstableAction::trap:
+            std::cerr << "#SHAMAN: stopping at unstable test number " << unstableTest << '.' << std::endl;
+            std::raise(SIGTRAP);
+            break;
+        case UnstableAction::backtrace:
+        {
+            std::cerr << "#SHAMAN: backtrace of unstable test number " << unstableTest << " :" << std::endl;
+            #ifdef SHAMAN_HAS_BACKTRACE
+            void* frames[128];
+            const int frameNumber = ::backtrace(frames, 128);
+            ::backtrace_symbols_fd(frames, frameNumber, 2);
+            #else
+            std::cerr << " -> backtraces are not available on this platform." << std::endl;
+            #endif
+            break;
+        }
+        case UnstableAction::hook:
+            if(unstableHook)
+            {
+                unstableHook(unstableTest);
+            }
+            else
+            {
+                std::cerr << "#SHAMAN: reached unstable test number " << unstableTest << " but no hook was given to Shaman::session().unstableHook." << std::endl;
+            }
+            break;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// GLOBALS
+
 // used to model the stacktrace
 const Tag ShamanGlobals::tagUntagged = 0;
 std::vector<std::string> ShamanGlobals::tagDecryptor = std::vector<std::string>({"untagged_block"}); // array that associate with tags (indexes) with block-names
 std::unordered_map<std::string, Tag> ShamanGlobals::nameEncryptor = {{"untagged_block", ShamanGlobals::tagUntagged}}; // hashtable that associate block-names with tags
 thread_local std::stack<Tag> ShamanGlobals::tagStack({ShamanGlobals::tagUntagged}); // contains the current stack
 std::mutex ShamanGlobals::mutexAddName;
+std::unordered_map<Tag, std::pair<Tag, Tag>> ShamanGlobals::callPaths;
+std::unordered_map<std::uint32_t, Tag> ShamanGlobals::pathEncryptor;
+thread_local std::unordered_map<std::uint32_t, Tag> ShamanGlobals::localPathEncryptor;
 
 // counter for the number of unstable branches
-std::atomic_int ShamanGlobals::unstableBranchCounter(0);
+std::atomic<long long> ShamanGlobals::unstableBranchCounter(0);
+thread_local long long ShamanGlobals::localUnstableBranchCounter = 0;
 std::unordered_map<Tag, unsigned int> ShamanGlobals::unstableBranchSummary;
+std::unordered_map<Tag, long long> ShamanGlobals::unstableBranchFirst;
 std::mutex ShamanGlobals::mutexAddUnstableBranch;
+
+// errors of the numbers that exited a Shaman::Region
+std::unordered_map<const void*, long double> ShamanGlobals::regionErrors;
+std::mutex ShamanGlobals::mutexRegionErrors;
+
+// buffers whose errors are tracked in shadow memory
+std::map<const char*, ShadowBuffer> ShamanGlobals::shadowBuffers;
+std::mutex ShamanGlobals::mutexShadowBuffers;
+
+// precision advisor
+ThreadRecords<PrecisionRecord> ShamanGlobals::precisionRecords;
+std::atomic_int ShamanGlobals::observedOutputCounter(0);
+
+// cancellation counters
+ThreadRecords<CancellationRecord> ShamanGlobals::cancellationRecords;
+
+// operation counters
+ThreadRecords<OperationRecord> ShamanGlobals::operationRecords;
+std::vector<std::string> ShamanGlobals::operationTypeNames;
+std::mutex ShamanGlobals::mutexOperationTypes;
+
+// error tape
+thread_local std::shared_ptr<TapeArena> ShamanGlobals::localTape;
+std::vector<std::shared_ptr<TapeArena>> ShamanGlobals::tapes;
+std::mutex ShamanGlobals::mutexTapes;
+
+// watched variables
+std::shared_ptr<Shaman::WatchRecorder> ShamanGlobals::watchRecorder;
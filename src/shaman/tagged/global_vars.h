@@ -4,24 +4,254 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <limits>
 #include <atomic>
+#include <cstdint>
 #include <mutex>
+#include <utility>
+#include <functional>
+#include <algorithm>
+#include <ostream>
 
 // represents a block
 using Tag = unsigned short int;
 
+// error array shadowing a buffer registered with Shaman::shadow_register
+struct ShadowBuffer
+{
+    std::size_t bytes; // size of the registered buffer
+    void* errors; // page-aligned error array, one error per element of the buffer
+    std::size_t mappedBytes; // size of the allocation holding the errors
+};
+
+/*
+ * field of a record written by a single thread and read by any thread when the records are merged
+ * the accesses are relaxed atomics (plain loads and stores on most platforms), updates are a load followed by a store as there is a single writer
+ */
+template<typename T>
+class RecordValue
+{
+    std::atomic<T> value;
+public:
+    RecordValue(T valueArg = T()): value(valueArg) {}
+    RecordValue(const RecordValue& other): value(T(other)) {}
+    RecordValue& operator=(const RecordValue& other) { return *this = T(other); }
+    RecordValue& operator=(T valueArg)
+    {
+        value.store(valueArg, std::memory_order_relaxed);
+        return *this;
+    }
+    RecordValue& operator+=(T increment) { return *this = T(*this) + increment; }
+    operator T() const { return value.load(std::memory_order_relaxed); }
+};
+
+// statistics gathered on a block by the precision advisor
+struct PrecisionRecord
+{
+    RecordValue<unsigned long long> valueNumber = 0; // number of values produced in the block
+    RecordValue<unsigned long long> exactValueNumber = 0; // number of those values that had no error
+    RecordValue<double> minRelativeError = std::numeric_limits<double>::infinity(); // relative error of the most precise inexact value produced in the block
+    RecordValue<double> maxRelativeError = 0.; // relative error of the least precise value produced in the block
+    RecordValue<double> unitRoundoff = 0.; // unit roundoff of the type used to compute in the block
+    RecordValue<double> maxOutputShare = 0.; // largest ratio between the error generated in the block and the error of an observed output
+};
+
+// statistics gathered on a block by the cancellation counters
+struct CancellationRecord
+{
+    // histogram[b] is the number of additions and subtractions of the block whose result lost b bits of exponent (63 or more are counted in histogram[63])
+    std::array<RecordValue<unsigned long long>, 64> histogram = {};
+};
+
+// kinds of operations counted by the operation counters
+namespace Shaman
+{
+    enum class Operation : unsigned char {addition, multiplication, division, function, comparison};
+    const std::size_t operationKindNumber = 5;
+}
+
+// statistics gathered on a block and a S type by the operation counters
+struct OperationRecord
+{
+    // counts[k] is the number of operations of kind Shaman::Operation(k)
+    std::array<RecordValue<unsigned long long>, Shaman::operationKindNumber> counts = {};
+};
+
+/*
+ * records of each thread (one record per tag, or per S type and tag), merged on demand
+ * each thread writes in its own records to avoid any synchronisation when recording
+ * the records of a thread are kept once it exits so that its statistics are not lost
+ * NOTE: the records of the current thread are stored in a thread_local per Record type, there is thus a single registry per Record type
+ */
+template<typename Record>
+class ThreadRecords
+{
+    std::vector<std::shared_ptr<std::vector<Record>>> threadRecords; // records of all the threads
+    std::mutex mutex; // guards against concurent addition of records in threadRecords
+
+public:
+    /*
+     * returns the records of the current thread, size records are created the first time the thread asks for them
+     */
+    std::vector<Record>& local(std::size_t size)
+    {
+        thread_local std::shared_ptr<std::vector<Record>> records;
+        if(not records)
+        {
+            records = std::make_shared<std::vector<Record>>(size);
+            std::lock_guard<std::mutex> guard(mutex);
+            threadRecords.push_back(records);
+        }
+        return *records;
+    }
+
+    /*
+     * returns size records such that merge(record, threadRecord) was called with the corresponding record of each thread
+     * the threads can keep recording while their records are merged
+     */
+    template<typename FUN>
+    std::vector<Record> merged(std::size_t size, FUN merge)
+    {
+        std::vector<Record> records(size);
+        std::lock_guard<std::mutex> guard(mutex);
+        for(const auto& thread : threadRecords)
+        {
+            for(std::size_t i = 0; i < std::min(size, thread->size()); i++) merge(records[i], (*thread)[i]);
+        }
+        return records;
+    }
+};
+
+// operation recorded on the error tape (see tagged/error_tape.h)
+struct TapeNode
+{
+    const TapeNode* parents[2]; // operations whose errors flow into this one (nullptr if unused)
+    double coefficients[2]; // derivatives of the error of this operation with respect to the errors of its parents
+    double localError; // error generated by the operation itself
+    Tag tag; // block in which the operation was performed
+};
+
+// storage for the operations recorded by a thread (defined in tagged/error_tape.h)
+class TapeArena;
+
+namespace Shaman
+{
+    // open watch file (defined in helpers/shaman_watch.h)
+    class WatchRecorder;
+
+    /*
+     * runtime configuration of Shaman, read from the SHAMAN_* environment variables when the program starts
+     * the fields can also be modified by the program (see Shaman::session)
+     */
+    class Session
+    {
+    public:
+        double significanceBase = 10; // a number is non significant if its error is above 1/significanceBase of its magnitude (SHAMAN_UNSTABLE_DIGITS, the base is 10^digits)
+        std::string reportPath; // file to which the reports are appended, the standard output if empty (SHAMAN_REPORT_PATH)
+        std::size_t poolChunkSize = 1024; // number of error blocks allocated at once by the pooled error composants (SHAMAN_POOL_CHUNK_SIZE)
+        std::size_t watchCapacity = 1 << 16; // default number of samples each thread can buffer when watching variables (SHAMAN_WATCH_CAPACITY)
+
+        // what to do when reaching the unstable test number unstableBreak
+        enum class UnstableAction {trap, backtrace, hook};
+        long long unstableBreak = 0; // number of the unstable test at which to stop, 0 to never stop (SHAMAN_UNSTABLE_BREAK)
+        UnstableAction unstableAction = UnstableAction::trap; // raise SIGTRAP, print a backtrace or call unstableHook (SHAMAN_UNSTABLE_ACTION=trap|backtrace|hook)
+        std::size_t unstableSampling = 1; // only one comparison out of unstableSampling (per thread) is checked for unstability (SHAMAN_UNSTABLE_SAMPLING)
+        bool unstableCounterPerThread = false; // whether unstable tests are numbered per thread rather than globally (SHAMAN_UNSTABLE_COUNTER=thread|global)
+        std::function<void(long long)> unstableHook; // called with the number of the unstable test by the hook action
+
+        Session();
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+
+        /*
+         * stream to which the display functions write a report
+         * the report stream stays locked while the writer lives, so that the reports of several threads are not interleaved
+         */
+        class ReportWriter
+        {
+        public:
+            ReportWriter(std::unique_lock<std::mutex> lockArg, std::ostream& streamArg): lock(std::move(lockArg)), stream(streamArg) {}
+            ReportWriter(ReportWriter&&) = default;
+
+            template<typename T>
+            std::ostream& operator<<(const T& value) { return stream << value; }
+            std::ostream& operator<<(std::ostream& (*manipulator)(std::ostream&)) { return stream << manipulator; }
+            operator std::ostream&() { return stream; }
+
+        private:
+            std::unique_lock<std::mutex> lock; // lock on the report stream
+            std::ostream& stream;
+        };
+        ReportWriter report();
+
+        // performs the unstableAction, called when reaching the unstable test number unstableBreak
+        void breakOnUnstableBranch(long long unstableTest);
+
+    private:
+        std::mutex mutexReport; // guards reportFile
+        std::shared_ptr<std::ostream> reportFile; // open report file (nullptr if the reports go to the standard output)
+        std::string reportFilePath; // path of reportFile
+    };
+}
+
 class ShamanGlobals
 {
 public:
+    // runtime configuration (constructed on first use, static initializers of other translation units can thus use it)
+    static Shaman::Session& session();
+
     // used to model the stacktrace
     static std::vector<std::string> tagDecryptor; // array that associate tags (indexes) with block-names
     static const Tag tagUntagged;
     static std::unordered_map<std::string, Tag> nameEncryptor; // hashtable that associate block-names with tags
     thread_local static std::stack<Tag> tagStack; // contains the current stack
     static std::mutex mutexAddName; // guards against concurent addition of names in the encryptor/decryptor
+    static std::unordered_map<Tag, std::pair<Tag, Tag>> callPaths; // hashtable that associate call path tags with their parent path and innermost block
+    static std::unordered_map<std::uint32_t, Tag> pathEncryptor; // trie of the call paths, associate (parent path, block) with the path tag
+    thread_local static std::unordered_map<std::uint32_t, Tag> localPathEncryptor; // transitions of the trie already taken by the current thread
 
     // counter for the number of unstable branches
-    static std::atomic_int unstableBranchCounter;
+    static std::atomic<long long> unstableBranchCounter;
+    thread_local static long long localUnstableBranchCounter; // number of unstable branches detected by the current thread
     static std::unordered_map<Tag, unsigned int> unstableBranchSummary; // hashtable that associate block-names with the number of untable branch detected within
+    static std::unordered_map<Tag, long long> unstableBranchFirst; // hashtable that associate block-names with the number of the first unstable branch detected within
     static std::mutex mutexAddUnstableBranch; // guards against concurent addition of unstable branches in unstableBranchSummary
+
+    // errors of the numbers that exited a Shaman::Region
+    static std::unordered_map<const void*, long double> regionErrors; // hashtable that associate addresses with the error of the number stored there
+    static std::mutex mutexRegionErrors; // guards against concurent accesses to regionErrors
+
+    // buffers whose errors are tracked in shadow memory
+    static std::map<const char*, ShadowBuffer> shadowBuffers; // sorted by address to find the buffer containing any given element
+    static std::mutex mutexShadowBuffers; // guards against concurent accesses to shadowBuffers
+
+    // precision advisor
+    static ThreadRecords<PrecisionRecord> precisionRecords; // records of all the threads (indexes are tags), merged when displayed
+    static std::atomic_int observedOutputCounter; // number of outputs given to Shaman::observe
+
+    // cancellation counters
+    static ThreadRecords<CancellationRecord> cancellationRecords; // records of all the threads (indexes are tags), merged when displayed
+
+    // operation counters
+    static ThreadRecords<OperationRecord> operationRecords; // records of all the threads (indexes are type * tag number + tag), merged when displayed
+    static std::vector<std::string> operationTypeNames; // names of the S types that performed an operation (indexes are types)
+    static std::mutex mutexOperationTypes; // guards against concurent addition of names in operationTypeNames
+
+    // error tape
+    thread_local static std::shared_ptr<TapeArena> localTape; // operations recorded by the current thread
+    static std::vector<std::shared_ptr<TapeArena>> tapes; // tapes of all the threads, kept alive until the end of the program
+    static std::mutex mutexTapes; // guards against concurent addition of tapes in tapes
+
+    // watched variables
+    static std::shared_ptr<Shaman::WatchRecorder> watchRecorder; // names, buffers and flusher of the open watch file (nullptr if there is none)
 };
+
+inline Shaman::Session& ShamanGlobals::session()
+{
+    static Shaman::Session instance;
+    return instance;
+}
@@ -16,15 +16,20 @@ class CodeBlock
 public:
     /*
      * declares that we are now in a given block
+     * (with SHAMAN_CALL_PATH, the current tag becomes the path from the enclosing blocks to this block)
      */
     CodeBlock(const std::string& name)
     {
         Tag blockTag = tagOfName(name);
+        #ifdef SHAMAN_CALL_PATH
+        blockTag = pathOfBlock(currentBlock(), blockTag);
+        #endif
         ShamanGlobals::tagStack.push(blockTag);
     }
 
     /*
      * declares that we are now in a given block
+     * NOTE : the tag is used as is, this is used to forward the current tag (or call path) to another thread
      */
     CodeBlock(Tag tag)
     {
@@ -79,6 +84,96 @@ public:
         }
     }
     
+    /*
+     * returns the tag of the call path made of the path 'parent' followed by the block 'block'
+     * the paths are interned in a trie, a transition already taken by the current thread costs a single hashtable lookup
+     * a block entered from the root is its own path and a block already on the current path (recursion, direct or not)
+     * takes back the path that ends with it, so that recursive calls do not create a path per level
+     */
+    static Tag pathOfBlock(Tag parent, Tag block)
+    {
+        if(parent == ShamanGlobals::tagUntagged) return block;
+        const std::uint32_t key = (std::uint32_t(parent) << 16) | std::uint32_t(block);
+        auto& localTransitions = ShamanGlobals::localPathEncryptor;
+        auto transition = localTransitions.find(key);
+        if(transition != localTransitions.end())
+        {
+            return transition->second;
+        }
+
+        Tag path;
+        {
+            std::lock_guard<std::mutex> guard(ShamanGlobals::mutexAddName);
+            auto knownPath = ShamanGlobals::pathEncryptor.find(key);
+            if(knownPath != ShamanGlobals::pathEncryptor.end())
+            {
+                path = knownPath->second;
+            }
+            else
+            {
+                // walks the current path up to its root looking for the block
+                Tag ancestor = parent;
+                bool isRecursive = false;
+                while(true)
+                {
+                    auto ancestorPath = ShamanGlobals::callPaths.find(ancestor);
+                    const bool isPath = ancestorPath != ShamanGlobals::callPaths.end();
+                    if((isPath ? ancestorPath->second.second : ancestor) == block)
+                    {
+                        isRecursive = true;
+                        break;
+                    }
+                    if(not isPath) break;
+                    ancestor = ancestorPath->second.first;
+                }
+
+                if(isRecursive)
+                {
+                    path = ancestor;
+                }
+                else
+                {
+                    const std::string name = ShamanGlobals::tagDecryptor[parent] + '/' + ShamanGlobals::tagDecryptor[block];
+                    auto potentialTag = ShamanGlobals::nameEncryptor.find(name);
+                    if(potentialTag != ShamanGlobals::nameEncryptor.end())
+                    {
+                        path = potentialTag->second;
+                    }
+                    else
+                    {
+                        path = (unsigned short int) ShamanGlobals::tagDecryptor.size();
+                        ShamanGlobals::tagDecryptor.push_back(name);
+                        ShamanGlobals::nameEncryptor[name] = path;
+                    }
+                    ShamanGlobals::callPaths[path] = std::make_pair(parent, block);
+                }
+                ShamanGlobals::pathEncryptor[key] = path;
+            }
+        }
+        localTransitions[key] = path;
+        return path;
+    }
+
+    /*
+     * returns the call path enclosing the given tag (the untagged block if it is not a call path)
+     */
+    static Tag parentOfTag(Tag tag)
+    {
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexAddName);
+        auto path = ShamanGlobals::callPaths.find(tag);
+        return (path != ShamanGlobals::callPaths.end()) ? path->second.first : ShamanGlobals::tagUntagged;
+    }
+
+    /*
+     * returns the innermost block of the given tag (the tag itself if it is not a call path)
+     */
+    static Tag leafOfTag(Tag tag)
+    {
+        std::lock_guard<std::mutex> guard(ShamanGlobals::mutexAddName);
+        auto path = ShamanGlobals::callPaths.find(tag);
+        return (path != ShamanGlobals::callPaths.end()) ? path->second.second : tag;
+    }
+
     /*
      * returns the number of tags currently declared
      */
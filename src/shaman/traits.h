@@ -45,7 +45,52 @@ namespace std
         static Snum denorm_min() {return Snum(std::numeric_limits<numberType>::denorm_min());};
     };
 
+    // numeric limits of the 16 bits floating point types
+    template<typename Format> class numeric_limits<Shaman::small_float<Format>>
+    {
+        using T = Shaman::small_float<Format>;
+    public:
+        // Member constants
+        static const bool is_specialized = true;
+        static const bool is_signed = true;
+        static const bool is_integer = false;
+        static const bool is_exact = false;
+        static const bool has_infinity = true;
+        static const bool has_quiet_NaN = true;
+        static const bool has_signaling_NaN = true;
+        static const std::float_denorm_style has_denorm = std::denorm_present;
+        static const bool has_denorm_loss = false;
+        static const std::float_round_style round_style = std::round_to_nearest;
+        static const bool is_iec559 = std::is_same<Format, Shaman::detail::half_format>::value;
+        static const bool is_bounded = true;
+        static const bool is_modulo = false;
+        static const int digits = Format::digits;
+        static const int digits10 = Format::digits10;
+        static const int max_digits10 = Format::max_digits10;
+        static const int radix = 2;
+        static const int min_exponent = Format::min_exponent;
+        static const int min_exponent10 = Format::min_exponent10;
+        static const int max_exponent = Format::max_exponent;
+        static const int max_exponent10 = Format::max_exponent10;
+        static const bool traps = false;
+        static const bool tinyness_before = false;
+
+        // Member functions
+        static constexpr T min() {return T::fromBits(Format::minBits);};
+        static constexpr T lowest() {return T::fromBits(Format::maxBits | 0x8000u);};
+        static constexpr T max() {return T::fromBits(Format::maxBits);};
+        static constexpr T epsilon() {return T::fromBits(Format::epsilonBits);};
+        static constexpr T round_error() {return T::fromBits(Format::roundErrorBits);};
+        static constexpr T infinity() {return T::fromBits(Format::infinityBits);};
+        static constexpr T quiet_NaN() {return T::fromBits(Format::quietNanBits);};
+        static constexpr T signaling_NaN() {return T::fromBits(Format::signalingNanBits);};
+        static constexpr T denorm_min() {return T::fromBits(Format::denormMinBits);};
+    };
+
     // type traits
+    template<typename Format> struct is_floating_point<Shaman::small_float<Format>> : std::true_type {};
+    template<typename Format> struct is_arithmetic<Shaman::small_float<Format>> : std::true_type {};
+    template<typename Format> struct is_signed<Shaman::small_float<Format>> : std::true_type {};
     templated struct is_floating_point<Snum> : std::is_floating_point<numberType> {};
     templated struct is_arithmetic<Snum> : std::is_arithmetic<numberType> {};
     templated struct is_signed<Snum> : std::is_signed<numberType> {};
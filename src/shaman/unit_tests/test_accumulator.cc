@@ -0,0 +1,146 @@
+#include <shaman.h>
+#include <shaman/helpers/shaman_accumulator.h>
+#include "test_block_error.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace
+{
+    // numbers of alternating signs and magnitudes that carry an error
+    std::vector<Sdouble> noisyTerms(std::size_t size)
+    {
+        std::vector<Sdouble> result;
+        for(std::size_t i = 0; i < size; i++)
+        {
+            const double sign = (i % 2 == 0) ? 1. : -1.;
+            result.push_back(Sdouble(sign * (1. + double(i % 17) * 1e8)) / 3. + Sdouble(1.) / double(i + 7));
+        }
+        return result;
+    }
+
+    // sequential sum
+    Sdouble sequentialSum(const std::vector<Sdouble>& values)
+    {
+        Sdouble sum = 0.;
+        for(const Sdouble& x : values) sum += x;
+        return sum;
+    }
+
+    // sum of the magnitudes of the terms
+    double magnitude(const std::vector<Sdouble>& values)
+    {
+        double sum = 0.;
+        for(const Sdouble& x : values) sum += std::abs(x.number);
+        return sum;
+    }
+
+    // the lanes change the order of the additions (hence the number) but not the corrected number
+    void expectSameSum(const Sdouble& result, const Sdouble& expected, double magnitude)
+    {
+        EXPECT_NEAR(result.number, expected.number, 1e-13 * magnitude);
+        EXPECT_NEAR(result.number + result.error, expected.number + expected.error, 1e-15 * magnitude);
+    }
+}
+
+TEST(ACCUMULATOR, sum)
+{
+    // sizes that are and are not multiples of the number of lanes
+    for(std::size_t size : {0, 1, 7, 8, 64, 1003})
+    {
+        const std::vector<Sdouble> values = noisyTerms(size);
+        Shaman::simd_accumulator<Sdouble> sum;
+        sum.add(values.data(), values.size());
+        expectSameSum(sum.result(), sequentialSum(values), magnitude(values));
+    }
+}
+
+TEST(ACCUMULATOR, terms)
+{
+    const std::vector<Sdouble> x = noisyTerms(501);
+    std::vector<Sdouble> y = noisyTerms(501);
+    for(Sdouble& value : y) value = 1. / value;
+
+    std::vector<Sdouble> products;
+    for(std::size_t i = 0; i < x.size(); i++) products.push_back(x[i] * y[i]);
+
+    Shaman::simd_accumulator<Sdouble> dot;
+    dot.add_terms(x.size(), [&](std::size_t i){return x[i] * y[i];});
+    expectSameSum(dot.result(), sequentialSum(products), magnitude(products));
+}
+
+TEST(ACCUMULATOR, merge)
+{
+    const std::vector<Sdouble> values = noisyTerms(300);
+
+    // two accumulators over two halves, one of them fed a value at a time
+    Shaman::simd_accumulator<Sdouble> first;
+    first.add(values.data(), 123);
+    Shaman::simd_accumulator<Sdouble> second;
+    for(std::size_t i = 123; i < values.size(); i++) second += values[i];
+    first += second;
+    expectSameSum(first.result(), sequentialSum(values), magnitude(values));
+}
+
+TEST(ACCUMULATOR, rounding_errors)
+{
+    // the rounding errors of the additions are kept by the lanes
+    Shaman::simd_accumulator<Sdouble> sum;
+    const std::vector<Sdouble> values = {Sdouble(1e16), Sdouble(1.), Sdouble(-1e16), Sdouble(1.)};
+    sum.add(values.data(), values.size());
+    sum += Sdouble(1e16);
+    sum += Sdouble(1.);
+    sum += Sdouble(-1e16);
+    const Sdouble result = sum.result();
+    EXPECT_EQ(result.number + result.error, 3.);
+}
+
+TEST(ACCUMULATOR, plain_numbers)
+{
+    std::vector<double> values;
+    for(int i = 1; i <= 100; i++) values.push_back(double(i));
+    Shaman::simd_accumulator<double, 4> sum;
+    sum.add(values.data(), values.size());
+    sum += 1.;
+    EXPECT_EQ(sum.result(), 5051.);
+}
+
+#ifdef SHAMAN_TAGGED_ERROR
+TEST(ACCUMULATOR, error_composants)
+{
+    std::vector<Sdouble> values;
+    {
+        LOCAL_BLOCK("accumulator_input_block");
+        values = noisyTerms(100);
+    }
+    Sdouble result;
+    {
+        LOCAL_BLOCK("accumulator_sum_block");
+        Shaman::simd_accumulator<Sdouble> sum;
+        sum.add(values.data(), values.size());
+        result = sum.result();
+    }
+    // the errors of the terms stay in their block, the rounding errors of the sum go to the block calling result
+    double inputError = 0.;
+    for(const Sdouble& x : values) inputError += blockError(x, "accumulator_input_block");
+    EXPECT_NEAR(blockError(result, "accumulator_input_block"), inputError, 1e-6 * std::abs(inputError));
+    EXPECT_NEAR(blockError(result, "accumulator_input_block") + blockError(result, "accumulator_sum_block"), result.error, 1e-6 * std::abs(result.error));
+}
+
+#ifdef SHAMAN_CANCELLATION
+TEST(ACCUMULATOR, cancellations)
+{
+    // the additions into the lanes are recorded as those of operator+
+    {
+        LOCAL_BLOCK("accumulator_cancellation_block");
+        Shaman::simd_accumulator<Sdouble> sum;
+        sum += Sdouble(1. + std::ldexp(1., -30));
+        sum += Sdouble(-1.); // loses 30 bits
+        EXPECT_EQ(sum.result().number, std::ldexp(1., -30));
+    }
+    EXPECT_EQ(Shaman::cancellationRecords()[CodeBlock::tagOfName("accumulator_cancellation_block")].histogram[30], 1u);
+}
+#endif //SHAMAN_CANCELLATION
+#endif //SHAMAN_TAGGED_ERROR
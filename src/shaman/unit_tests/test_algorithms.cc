@@ -0,0 +1,77 @@
+#include <shaman.h>
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version> // defines __cpp_lib_execution without including <execution>
+#endif
+#endif
+#include <shaman/helpers/shaman_algorithms.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    /*
+     * produces a sum with a lot of cancellations
+     */
+    std::vector<Sdouble> cancellingValues(int size)
+    {
+        std::vector<Sdouble> values;
+        for(int i = 0; i < size; i++)
+        {
+            double x = (i % 2 == 0) ? 1e10 + i : -1e10 + 0.1*i;
+            values.push_back(Sdouble(x) / 3.);
+        }
+        return values;
+    }
+
+    TEST(ALGORITHMS, reduce)
+    {
+        std::vector<Sdouble> values = cancellingValues(10001);
+
+        Sdouble sequential = 0.;
+        for(const Sdouble& x : values) sequential += x;
+        Sdouble parallel = Shaman::reduce(Shaman::execution::par, values.begin(), values.end(), Sdouble(0.));
+
+        // both sums have different numbers but they should agree on the corrected number
+        EXPECT_NEAR(parallel.corrected_number(), sequential.corrected_number(), 1e-6);
+        EXPECT_EQ(Shaman::reduce(Shaman::execution::seq, values.begin(), values.end()).number, sequential.number);
+    }
+
+    TEST(ALGORITHMS, dot)
+    {
+        std::vector<Sdouble> x = cancellingValues(1001);
+        std::vector<Sdouble> y(x.size(), Sdouble(0.5));
+
+        Sdouble sequential = 0.;
+        for(size_t i = 0; i < x.size(); i++) sequential += x[i] * y[i];
+        Sdouble parallel = Shaman::dot(Shaman::execution::par_unseq, x.begin(), x.end(), y.begin());
+
+        EXPECT_NEAR(parallel.corrected_number(), sequential.corrected_number(), 1e-6);
+    }
+
+    TEST(ALGORITHMS, inclusive_scan)
+    {
+        std::vector<Sdouble> values = cancellingValues(1000);
+        std::vector<Sdouble> scan(values.size());
+        Shaman::inclusive_scan(Shaman::execution::par, values.begin(), values.end(), scan.begin());
+
+        Sdouble sequential = 0.;
+        for(size_t i = 0; i < values.size(); i++)
+        {
+            sequential += values[i];
+            EXPECT_NEAR(scan[i].corrected_number(), sequential.corrected_number(), 1e-6);
+        }
+    }
+
+#ifdef SHAMAN_STD_EXECUTION
+    TEST(ALGORITHMS, std_policies)
+    {
+        std::vector<Sdouble> values = cancellingValues(1001);
+        Sdouble shamanPolicy = Shaman::reduce(Shaman::execution::par, values.begin(), values.end());
+        Sdouble stdPolicy = Shaman::reduce(std::execution::par, values.begin(), values.end());
+        EXPECT_EQ(stdPolicy.number, shamanPolicy.number);
+        EXPECT_TRUE(Shaman::execution::is_parallel<std::execution::parallel_unsequenced_policy>::value);
+        EXPECT_FALSE(Shaman::execution::is_parallel<std::execution::sequenced_policy>::value);
+    }
+#endif
+}
@@ -0,0 +1,209 @@
+#include <shaman.h>
+#include <shaman/helpers/shaman_batch.h>
+#include "test_block_error.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace
+{
+    // numbers regularly spaced over [begin;end] that carry an error
+    template<typename Stype>
+    std::vector<Stype> noisyRange(double begin, double end, std::size_t size)
+    {
+        std::vector<Stype> result;
+        for(std::size_t i = 0; i < size; i++)
+        {
+            const Stype x = Stype(begin) + (Stype(end - begin) / 7.) * (Stype(double(i)) * (7. / double(size - 1)));
+            result.push_back(x);
+        }
+        return result;
+    }
+
+    /*
+     * checks that the batch outputs match the scalar ones
+     * the numbers might differ by an ulp but the corrected numbers (number + error) must be the same
+     * (up to the precision of the long double computations of the scalar functions of Sdouble)
+     */
+    template<typename Stype, typename Function>
+    void expectScalarMatch(const std::vector<Stype>& inputs, const std::vector<Stype>& outputs, Function function)
+    {
+        using numberType = typename Stype::NumberType;
+        const long double epsilon = std::numeric_limits<numberType>::epsilon();
+        const long double preciseEpsilon = std::numeric_limits<long double>::epsilon();
+        ASSERT_EQ(inputs.size(), outputs.size());
+        for(std::size_t i = 0; i < inputs.size(); i++)
+        {
+            const Stype expected = function(inputs[i]);
+            const long double magnitude = std::abs((long double)expected.number);
+            EXPECT_LE(std::abs((long double)outputs[i].number - expected.number), epsilon * magnitude) << "input " << inputs[i];
+            const long double correctedOutput = (long double)outputs[i].number + (long double)outputs[i].error;
+            const long double correctedExpected = (long double)expected.number + (long double)expected.error;
+            const long double tolerance = 1e-3L * epsilon * magnitude + 4 * preciseEpsilon * (magnitude + std::abs((long double)inputs[i].number));
+            EXPECT_LE(std::abs(correctedOutput - correctedExpected), tolerance) << "input " << inputs[i];
+        }
+    }
+
+    // the fallback goes through the scalar function, the outputs are thus exactly the scalar ones
+    template<typename Stype>
+    void expectIdentical(const Stype& output, const Stype& expected)
+    {
+        if(std::isnan(expected.number))
+        {
+            EXPECT_TRUE(std::isnan(output.number));
+        }
+        else
+        {
+            EXPECT_EQ(output.number, expected.number);
+            if(std::isnan(expected.error)) EXPECT_TRUE(std::isnan(output.error));
+            else EXPECT_EQ(output.error, expected.error);
+        }
+    }
+
+    template<typename Stype>
+    void testUnaryFunctions()
+    {
+        std::vector<Stype> inputs = noisyRange<Stype>(-5., 5., 1001);
+        std::vector<Stype> outputs(inputs.size());
+        Sstd::exp(inputs, outputs);
+        expectScalarMatch(inputs, outputs, [](const Stype& x){return Sstd::exp(x);});
+
+        inputs = noisyRange<Stype>(0.1, 1.4, 1001); // away from the zeros of sin and cos
+        Sstd::sin(inputs, outputs);
+        expectScalarMatch(inputs, outputs, [](const Stype& x){return Sstd::sin(x);});
+        Sstd::cos(inputs.data(), outputs.data(), inputs.size());
+        expectScalarMatch(inputs, outputs, [](const Stype& x){return Sstd::cos(x);});
+
+        inputs = noisyRange<Stype>(1.5, 1000., 1001); // away from log(1) = 0
+        Sstd::log(inputs, outputs);
+        expectScalarMatch(inputs, outputs, [](const Stype& x){return Sstd::log(x);});
+        inputs = noisyRange<Stype>(0.001, 0.5, 1001);
+        Sstd::log(inputs, outputs);
+        expectScalarMatch(inputs, outputs, [](const Stype& x){return Sstd::log(x);});
+    }
+}
+
+TEST(BATCH, unary_functions)
+{
+    testUnaryFunctions<Sdouble>();
+    testUnaryFunctions<Sfloat>();
+    testUnaryFunctions<Sdouble_compact>();
+}
+
+TEST(BATCH, pow)
+{
+    const std::vector<Sdouble> x = noisyRange<Sdouble>(0.5, 10., 501);
+    const std::vector<Sdouble> y = noisyRange<Sdouble>(-2., 3., 501);
+    std::vector<Sdouble> outputs(x.size());
+
+    Sstd::pow(x, y, outputs);
+    for(std::size_t i = 0; i < x.size(); i++)
+    {
+        const Sdouble expected = Sstd::pow(x[i], y[i]);
+        EXPECT_NEAR(outputs[i].number, expected.number, std::abs(expected.number) * 2.3e-16);
+        EXPECT_NEAR((long double)outputs[i].number + outputs[i].error, (long double)expected.number + expected.error, std::abs(expected.number) * 1e-18);
+    }
+
+    const Sdouble exponent = Sdouble(17.) / 10.;
+    Sstd::pow(x, exponent, outputs);
+    expectScalarMatch(x, outputs, [&](const Sdouble& n){return Sstd::pow(n, exponent);});
+    Sstd::pow(x, 2, outputs); // exponent converted to Sdouble
+    expectScalarMatch(x, outputs, [](const Sdouble& n){return Sstd::pow(n, Sdouble(2.));});
+}
+
+TEST(BATCH, fallback)
+{
+    // inputs outside of the domain of the kernels
+    const std::vector<Sdouble> expInputs = {Sdouble(800.), Sdouble(-800.), Sdouble(INFINITY), Sdouble(NAN)};
+    std::vector<Sdouble> outputs(expInputs.size());
+    Sstd::exp(expInputs, outputs);
+    for(std::size_t i = 0; i < expInputs.size(); i++) expectIdentical(outputs[i], Sstd::exp(expInputs[i]));
+
+    const std::vector<Sdouble> logInputs = {Sdouble(-1.), Sdouble(0.), Sdouble(1e-310), Sdouble(INFINITY), Sdouble(NAN)};
+    outputs.resize(logInputs.size());
+    Sstd::log(logInputs, outputs);
+    for(std::size_t i = 0; i < logInputs.size(); i++) expectIdentical(outputs[i], Sstd::log(logInputs[i]));
+
+    const std::vector<Sdouble> sinInputs = {Sdouble(1e7) / 3., Sdouble(-1e7), Sdouble(INFINITY), Sdouble(NAN)};
+    outputs.resize(sinInputs.size());
+    Sstd::sin(sinInputs, outputs);
+    for(std::size_t i = 0; i < sinInputs.size(); i++) expectIdentical(outputs[i], Sstd::sin(sinInputs[i]));
+
+    const std::vector<Sdouble> powInputs = {Sdouble(-2.), Sdouble(0.), Sdouble(1e-310), Sdouble(1e300)};
+    outputs.resize(powInputs.size());
+    Sstd::pow(powInputs, Sdouble(3.), outputs);
+    for(std::size_t i = 0; i < powInputs.size(); i++) expectIdentical(outputs[i], Sstd::pow(powInputs[i], Sdouble(3.)));
+
+    // overflow of a float result
+    const std::vector<Sfloat> floatInputs = {Sfloat(100.f), Sfloat(-100.f)};
+    std::vector<Sfloat> floatOutputs(floatInputs.size());
+    Sstd::exp(floatInputs, floatOutputs);
+    for(std::size_t i = 0; i < floatInputs.size(); i++) expectIdentical(floatOutputs[i], Sstd::exp(floatInputs[i]));
+
+    // types without kernels use the scalar functions
+    const std::vector<Slong_double> longInputs = {Slong_double(1.) / 3., Slong_double(2.)};
+    std::vector<Slong_double> longOutputs(longInputs.size());
+    Sstd::exp(longInputs, longOutputs);
+    for(std::size_t i = 0; i < longInputs.size(); i++) expectIdentical(longOutputs[i], Sstd::exp(longInputs[i]));
+}
+
+TEST(BATCH, in_place)
+{
+    std::vector<Sdouble> values = noisyRange<Sdouble>(1., 2., 300); // several chunks
+    const std::vector<Sdouble> inputs = values;
+    std::vector<Sdouble> expected(values.size());
+    Sstd::log(inputs, expected);
+    Sstd::log(values, values);
+    for(std::size_t i = 0; i < values.size(); i++) expectIdentical(values[i], expected[i]);
+
+    // the exponent is copied before the output is written
+    values = inputs;
+    Sstd::pow(inputs, inputs[0], expected);
+    Sstd::pow(values, values[0], values);
+    for(std::size_t i = 0; i < values.size(); i++) expectIdentical(values[i], expected[i]);
+}
+
+TEST(BATCH, ranges)
+{
+    const std::array<Sdouble,3> inputs = {{Sdouble(1.), Sdouble(2.), Sdouble(3.)}};
+    std::array<Sdouble,3> outputs;
+    Sstd::exp(inputs, outputs);
+    EXPECT_NEAR(outputs[2].number, std::exp(3.), 1e-15 * std::exp(3.));
+
+    // the plain versions work on the traditional types (as needed with NO_SHAMAN)
+    const std::vector<double> plainInputs = {1., 2.};
+    std::vector<double> plainOutputs(2);
+    Shaman::batch::exp(plainInputs, plainOutputs);
+    EXPECT_EQ(plainOutputs[1], std::exp(2.));
+
+    std::vector<Sdouble> tooSmall(2);
+    EXPECT_THROW(Sstd::exp(inputs, tooSmall), std::invalid_argument);
+}
+
+#ifdef SHAMAN_TAGGED_ERROR
+TEST(BATCH, error_composants)
+{
+    std::vector<Sdouble> inputs;
+    {
+        LOCAL_BLOCK("batch_input_block");
+        inputs = noisyRange<Sdouble>(0.5, 2., 10);
+    }
+    std::vector<Sdouble> outputs(inputs.size());
+    {
+        LOCAL_BLOCK("batch_function_block");
+        Sstd::exp(inputs, outputs);
+    }
+    for(std::size_t i = 0; i < inputs.size(); i++)
+    {
+        // the composants of the input are multiplied by the derivative, the rounding error goes to the current block
+        const double inputError = blockError(inputs[i], "batch_input_block");
+        const double functionError = blockError(outputs[i], "batch_function_block");
+        EXPECT_NEAR(blockError(outputs[i], "batch_input_block"), inputError * outputs[i].number, 1e-6 * std::abs(inputError * outputs[i].number));
+        EXPECT_NEAR(blockError(outputs[i], "batch_input_block") + functionError, outputs[i].error, 1e-6 * std::abs(outputs[i].error));
+    }
+}
+#endif //SHAMAN_TAGGED_ERROR
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <shaman.h>
+#include <shaman/helpers/shaman_call_path.h>
+
+#include <map>
+#include <string>
+
+#ifdef SHAMAN_TAGGED_ERROR
+/*
+ * returns the error attributed to a block (0 if the block did not contribute to the error of x)
+ *
+ * the composants are read through Shaman::error_per_leaf rather than indexed by tag:
+ * only error_sum stores one composant per tag, the tape and the pool are converted to an error_sum
+ * while the top-K composants are read directly (their tags might be beyond SHAMAN_TAGNUMBER)
+ */
+inline double blockError(const Sdouble& x, const std::string& name)
+{
+    const std::map<std::string, double> errors = Shaman::error_per_leaf(x);
+    const auto error = errors.find(name);
+    return (error == errors.end()) ? 0. : error->second;
+}
+#endif //SHAMAN_TAGGED_ERROR
@@ -0,0 +1,114 @@
+#include <shaman.h>
+#include <shaman/helpers/shaman_call_path.h>
+
+#include <string>
+#include <gtest/gtest.h>
+
+#ifdef SHAMAN_TAGGED_ERROR
+namespace
+{
+    Sdouble sharedKernel(Sdouble x)
+    {
+        LOCAL_BLOCK("path_kernel");
+        return x / 3.;
+    }
+
+    Sdouble firstCaller(Sdouble x)
+    {
+        LOCAL_BLOCK("path_first_caller");
+        return sharedKernel(x);
+    }
+
+    Sdouble secondCaller(Sdouble x)
+    {
+        LOCAL_BLOCK("path_second_caller");
+        return sharedKernel(x * 7.);
+    }
+
+    Sdouble recursiveKernel(Sdouble x, int depth)
+    {
+        LOCAL_BLOCK("path_recursive");
+        if(depth == 0) return x / 3.;
+        return recursiveKernel(x, depth - 1) / 3.;
+    }
+
+    Sdouble oddKernel(Sdouble x, int depth);
+
+    Sdouble evenKernel(Sdouble x, int depth)
+    {
+        LOCAL_BLOCK("path_even");
+        if(depth == 0) return x / 3.;
+        return oddKernel(x, depth - 1) / 3.;
+    }
+
+    Sdouble oddKernel(Sdouble x, int depth)
+    {
+        LOCAL_BLOCK("path_odd");
+        return evenKernel(x, depth - 1) / 7.;
+    }
+}
+
+TEST(CALL_PATH, attribution)
+{
+    const Sdouble first = firstCaller(Sdouble(1.));
+    const Sdouble second = secondCaller(Sdouble(1.));
+    ASSERT_NE(first.error, 0.);
+    ASSERT_NE(second.error, 0.);
+    const Sdouble sum = first + second;
+
+    // the error of the kernel, whoever called it
+    std::map<std::string, double> leaves = Shaman::error_per_leaf(sum);
+    EXPECT_EQ(leaves["path_kernel"], first.error + second.error);
+
+    std::map<std::string, double> paths = Shaman::error_per_path(sum);
+    #ifdef SHAMAN_CALL_PATH
+    // the error of the kernel, per caller
+    EXPECT_EQ(paths["path_first_caller/path_kernel"], first.error);
+    EXPECT_EQ(paths["path_second_caller/path_kernel"], second.error);
+    EXPECT_EQ(paths.count("path_kernel"), 0u);
+    EXPECT_EQ(CodeBlock::leafOfTag(CodeBlock::tagOfName("path_first_caller/path_kernel")), CodeBlock::tagOfName("path_kernel"));
+    EXPECT_EQ(CodeBlock::parentOfTag(CodeBlock::tagOfName("path_first_caller/path_kernel")), CodeBlock::tagOfName("path_first_caller"));
+    #else
+    EXPECT_EQ(paths["path_kernel"], first.error + second.error);
+    #endif
+}
+
+TEST(CALL_PATH, recursion)
+{
+    // recursive calls do not create new paths
+    const Sdouble result = recursiveKernel(Sdouble(1.), 10);
+    ASSERT_NE(result.error, 0.);
+    const std::map<std::string, double> paths = Shaman::error_per_path(result);
+    ASSERT_EQ(paths.size(), 1u);
+    EXPECT_EQ(paths.begin()->first, "path_recursive");
+
+    // neither do indirect recursive calls
+    const Sdouble indirect = evenKernel(Sdouble(1.), 20);
+    const std::map<std::string, double> indirectPaths = Shaman::error_per_path(indirect);
+    #ifdef SHAMAN_CALL_PATH
+    ASSERT_EQ(indirectPaths.size(), 2u);
+    EXPECT_EQ(indirectPaths.count("path_even"), 1u);
+    EXPECT_EQ(indirectPaths.count("path_even/path_odd"), 1u);
+    #else
+    EXPECT_EQ(indirectPaths.size(), 2u);
+    #endif
+}
+
+#ifdef SHAMAN_TOPK_ERROR
+TEST(CALL_PATH, topk_residual)
+{
+    // the composants that are not kept are attributed to 'other'
+    Sdouble sum = 0.;
+    for(unsigned int i = 0; i < error_topk<double>::capacity + 2; i++)
+    {
+        LOCAL_BLOCK("path_topk_" + std::to_string(i));
+        sum += Sdouble(1.) / double(2 * i + 3);
+    }
+    const std::map<std::string, double> leaves = Shaman::error_per_leaf(sum);
+    EXPECT_EQ(leaves.count("other"), 1u);
+    double total = 0.;
+    for(const auto& leaf : leaves) total += leaf.second;
+    EXPECT_NEAR(total, sum.error, 1e-3 * std::abs(sum.error));
+}
+#endif //SHAMAN_TOPK_ERROR
+#endif //SHAMAN_TAGGED_ERROR
@@ -0,0 +1,67 @@
+#include <shaman.h>
+
+#include <algorithm>
+#include <cmath>
+#include <gtest/gtest.h>
+
+#ifdef SHAMAN_CANCELLATION
+namespace
+{
+    // histogram of the bits lost in a block
+    std::array<unsigned long long, 64> histogramOf(const std::string& name)
+    {
+        const CancellationRecord record = Shaman::cancellationRecords()[CodeBlock::tagOfName(name)];
+        std::array<unsigned long long, 64> histogram;
+        std::copy(record.histogram.begin(), record.histogram.end(), histogram.begin());
+        return histogram;
+    }
+}
+
+TEST(CANCELLATION, bits_lost)
+{
+    const Sdouble x = 1. + std::ldexp(1., -30);
+    const Sdouble y = 1.;
+    {
+        LOCAL_BLOCK("cancellation_block");
+        const Sdouble difference = x - y; // loses 30 bits
+        Sdouble accumulator = x;
+        accumulator -= 1.; // loses 30 bits
+        const Sdouble sum = x + y; // gains one bit
+        EXPECT_EQ(difference.number, std::ldexp(1., -30));
+        EXPECT_EQ(accumulator.number, std::ldexp(1., -30));
+        EXPECT_EQ(sum.number, 2. + std::ldexp(1., -30));
+    }
+    const std::array<unsigned long long, 64> histogram = histogramOf("cancellation_block");
+    EXPECT_EQ(histogram[30], 2u);
+    EXPECT_EQ(histogram[0], 1u);
+
+    // exact zeros are not counted
+    {
+        LOCAL_BLOCK("cancellation_zero_block");
+        const Sdouble zero = x - x;
+        EXPECT_EQ(zero.number, 0.);
+    }
+    for(unsigned long long count : histogramOf("cancellation_zero_block"))
+    {
+        EXPECT_EQ(count, 0u);
+    }
+
+    Shaman::displayCancellations(20);
+}
+
+TEST(CANCELLATION, float_and_long_double)
+{
+    {
+        LOCAL_BLOCK("cancellation_types_block");
+        const Sfloat xf = 1.f + std::ldexp(1.f, -10);
+        const Sfloat df = xf - Sfloat(1.f); // loses 10 bits
+        const Slong_double xl = 1.L + std::ldexp(1.L, -40);
+        const Slong_double dl = xl - Slong_double(1.L); // loses 40 bits
+        EXPECT_NE(df.number, 0.f);
+        EXPECT_NE(dl.number, 0.L);
+    }
+    const std::array<unsigned long long, 64> histogram = histogramOf("cancellation_types_block");
+    EXPECT_EQ(histogram[10], 1u);
+    EXPECT_EQ(histogram[40], 1u);
+}
+#endif //SHAMAN_CANCELLATION
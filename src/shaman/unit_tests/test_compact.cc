@@ -0,0 +1,87 @@
+#include <shaman.h>
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <gtest/gtest.h>
+
+TEST(COMPACT, layout)
+{
+    EXPECT_LE(sizeof(Sdouble_compact), sizeof(Sdouble));
+    #if defined(SHAMAN_PACKED) && !defined(SHAMAN_TAGGED_ERROR)
+    EXPECT_EQ(sizeof(Sdouble_compact), sizeof(double) + sizeof(float));
+    #endif
+
+    // operations with scalars keep the compact type
+    const Sdouble_compact x(1.);
+    static_assert(std::is_same<decltype(x * 2.), Sdouble_compact>::value, "");
+    static_assert(std::is_same<decltype(2 + x), Sdouble_compact>::value, "");
+    static_assert(std::is_same<decltype(Sstd::pow(x, 2.)), Sdouble_compact>::value, "");
+    // mixed operations use the widest error
+    static_assert(std::is_same<decltype(x + Sdouble(1.)), Sdouble>::value, "");
+}
+
+TEST(COMPACT, error_propagation)
+{
+    // the compact error matches the full error to float precision
+    Sdouble sum(0.);
+    Sdouble_compact compactSum(0.);
+    for(int i = 1; i <= 1000; i++)
+    {
+        sum += Sstd::sqrt(Sdouble(i)) / 3.;
+        compactSum += Sstd::sqrt(Sdouble_compact(i)) / 3.;
+    }
+    EXPECT_EQ(compactSum.number, sum.number);
+    EXPECT_NEAR(compactSum.error / sum.error, 1., 1e-5);
+}
+
+TEST(COMPACT, conversions)
+{
+    const Sdouble x = Sdouble(1.) / 3.;
+    const Sdouble_compact compact = x;
+    EXPECT_EQ(compact.number, x.number);
+    EXPECT_EQ(compact.error, static_cast<float>(x.error));
+
+    const Sdouble back = compact;
+    EXPECT_EQ(back.number, x.number);
+    EXPECT_EQ(back.error, static_cast<double>(compact.error));
+}
+
+TEST(COMPACT, error_range)
+{
+    // an error too large for a float becomes infinite, the number has no significant digits left
+    const Sdouble_compact huge = Sdouble_compact(1e300) / 7.;
+    EXPECT_TRUE(std::isinf(huge.error));
+    EXPECT_EQ(huge.digits(), 0.);
+    EXPECT_TRUE(huge.non_significant());
+    EXPECT_TRUE(std::isinf((huge * 3.).error));
+    EXPECT_EQ(Shaman::narrow_error<float>(1e300), std::numeric_limits<float>::infinity());
+    EXPECT_EQ(Shaman::narrow_error<float>(-1e300), -std::numeric_limits<float>::infinity());
+
+    // the error is never rounded below the largest float
+    const double justAbove = std::nextafter(double(std::numeric_limits<float>::max()), 1e300);
+    EXPECT_GE(double(Shaman::narrow_error<float>(justAbove)), justAbove);
+
+    // an infinite error stays infinite
+    EXPECT_TRUE(std::isinf(Shaman::narrow_error<float>(std::numeric_limits<double>::infinity())));
+
+    // a non-zero error too small for a float is kept non-zero
+    const Sdouble_compact tiny = Sdouble_compact(1e-300) / 7.;
+    EXPECT_EQ(std::abs(tiny.error), std::numeric_limits<float>::denorm_min());
+    EXPECT_EQ(Shaman::narrow_error<float>(-1e-300), -std::numeric_limits<float>::denorm_min());
+
+    // exact values stay exact
+    EXPECT_EQ(Shaman::narrow_error<float>(0.), 0.f);
+    EXPECT_EQ((Sdouble_compact(1e-300) * 2.).error, 0.f);
+}
+
+#ifdef SHAMAN_UNSTABLE_BRANCH
+TEST(COMPACT, overflowing_comparison)
+{
+    // numbers whose error left the float range have no significant digits, comparing them is deemed unstable
+    const Sdouble_compact huge = Sdouble_compact(1e300) / 7.;
+    const long long before = ShamanGlobals::unstableBranchCounter;
+    EXPECT_TRUE(huge > -huge);
+    EXPECT_EQ(ShamanGlobals::unstableBranchCounter, before + 1);
+}
+#endif //SHAMAN_UNSTABLE_BRANCH
@@ -0,0 +1,52 @@
+#include <shaman.h>
+
+#include <gtest/gtest.h>
+
+#ifdef SHAMAN_UNSTABLE_BRANCH
+namespace
+{
+    // number of unstable tests detected while running the function
+    template<typename Function>
+    long long unstableTestsOf(Function function)
+    {
+        const long long before = ShamanGlobals::unstableBranchCounter;
+        function();
+        return ShamanGlobals::unstableBranchCounter - before;
+    }
+
+    // a value that is only noise
+    Sdouble noise()
+    {
+        const Sdouble tenth = Sdouble(1.) / 10.;
+        return (tenth + tenth * 2.) - Sdouble(3.) / 10.;
+    }
+}
+
+TEST(COMPARISON, scalar_operands)
+{
+    const Sdouble x = noise();
+    const Sdouble y = 2.;
+    ASSERT_GT(x.number, 0.);
+    EXPECT_EQ(unstableTestsOf([&](){EXPECT_TRUE(x > 0.);}), 1);
+    EXPECT_EQ(unstableTestsOf([&](){EXPECT_TRUE(0 < x);}), 1);
+    EXPECT_EQ(unstableTestsOf([&](){EXPECT_FALSE(y == 1);}), 0);
+    EXPECT_EQ(unstableTestsOf([&](){EXPECT_TRUE(y >= 2.f);}), 0);
+    EXPECT_EQ(unstableTestsOf([&](){EXPECT_TRUE(Sfloat(0.5f) < 1.);}), 0);
+    // min and max check their comparison once
+    EXPECT_EQ(unstableTestsOf([&](){EXPECT_EQ(Sstd::min(x, Sdouble(0.)).number, 0.);}), 1);
+    EXPECT_EQ(unstableTestsOf([&](){EXPECT_EQ(Sstd::max(x, y).number, 2.);}), 0);
+}
+
+TEST(COMPARISON, sampling)
+{
+    const Sdouble x = noise();
+    Shaman::session().unstableSampling = 4;
+    const long long unstableTests = unstableTestsOf([&]()
+    {
+        for(int i = 0; i < 40; i++) EXPECT_TRUE(x > 0.);
+    });
+    Shaman::session().unstableSampling = 1;
+    EXPECT_EQ(unstableTests, 10);
+    EXPECT_EQ(unstableTestsOf([&](){EXPECT_TRUE(x > 0.);}), 1);
+}
+#endif //SHAMAN_UNSTABLE_BRANCH
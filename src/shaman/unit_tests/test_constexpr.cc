@@ -0,0 +1,98 @@
+#include <shaman.h>
+
+#include <array>
+#include <gtest/gtest.h>
+
+/*
+ * compiled in C++20 where, without tagged error, the arithmetic operators can be evaluated at compile time
+ * the constant results must be the ones computed at runtime (numbers and errors)
+ */
+namespace
+{
+    // Taylor coefficients of exp, 1/n!
+    template<typename Stype>
+    CONSTEXPR20 std::array<Stype, 12> inverseFactorials()
+    {
+        std::array<Stype, 12> result{};
+        Stype factorial = 1;
+        for(int n = 0; n < 12; n++)
+        {
+            if(n > 0) factorial *= Stype(n);
+            result[n] = 1 / factorial;
+        }
+        return result;
+    }
+
+    // a few steps using all the operators
+    template<typename Stype>
+    CONSTEXPR20 Stype mixedOperations(Stype x)
+    {
+        Stype y = x / 3;
+        y += x * 0.1;
+        y -= Stype(2) / 7;
+        y *= -x;
+        y /= x + 1;
+        ++y;
+        y--;
+        return 0.5 - y * 10;
+    }
+
+    template<typename Stype>
+    void expectIdentical(const Stype& constant, const Stype& runtime)
+    {
+        EXPECT_EQ(constant.number, runtime.number);
+        EXPECT_EQ(constant.error, runtime.error);
+    }
+}
+
+#ifdef SHAMAN_CONSTEXPR_ARITHMETIC
+TEST(CONSTEXPR, constant_folding)
+{
+    constexpr Sdouble third = Sdouble(1) / 3;
+    static_assert(third.number == 1. / 3., "the number is the runtime number");
+    static_assert(third.error != 0, "the rounding error is computed at compile time");
+    static_assert((third * 3).error == 0, "the errors compensate at compile time");
+
+    volatile int one = 1; // forces the runtime evaluation
+    expectIdentical(third, Sdouble(one) / 3);
+    constexpr Sfloat floatTenth = Sfloat(0.1) * 3; // 0.1 is converted into a float with its error
+    volatile double tenth = 0.1;
+    expectIdentical(floatTenth, Sfloat(tenth) * 3);
+}
+
+TEST(CONSTEXPR, coefficient_table)
+{
+    constexpr std::array<Sdouble, 12> constantCoefficients = inverseFactorials<Sdouble>();
+    static_assert(constantCoefficients[3].error != 0, "the table is computed at compile time");
+    const std::array<Sdouble, 12> runtimeCoefficients = inverseFactorials<Sdouble>();
+    for(std::size_t n = 0; n < constantCoefficients.size(); n++)
+    {
+        expectIdentical(constantCoefficients[n], runtimeCoefficients[n]);
+    }
+
+    constexpr std::array<Sfloat, 12> floatCoefficients = inverseFactorials<Sfloat>();
+    const std::array<Sfloat, 12> runtimeFloatCoefficients = inverseFactorials<Sfloat>();
+    expectIdentical(floatCoefficients[11], runtimeFloatCoefficients[11]);
+}
+
+TEST(CONSTEXPR, operators)
+{
+    volatile double input = 1.3;
+    constexpr Sdouble constant = mixedOperations(Sdouble(1.3));
+    expectIdentical(constant, mixedOperations(Sdouble(input)));
+    constexpr Sfloat floatConstant = mixedOperations(Sfloat(1.3f));
+    expectIdentical(floatConstant, mixedOperations(Sfloat(float(input))));
+    constexpr Sdouble_compact compactConstant = mixedOperations(Sdouble_compact(1.3));
+    expectIdentical(compactConstant, mixedOperations(Sdouble_compact(input)));
+}
+#endif //SHAMAN_CONSTEXPR_ARITHMETIC
+
+// with tagged error the operators are evaluated at runtime
+TEST(CONSTEXPR, runtime_operators)
+{
+    const std::array<Sdouble, 12> coefficients = inverseFactorials<Sdouble>();
+    EXPECT_EQ(coefficients[4].number, 1. / 24.);
+    EXPECT_NE(coefficients[3].error, 0.);
+    const Sdouble result = mixedOperations(Sdouble(1.3));
+    EXPECT_NEAR(result.number + result.error, 0.5 - 10. * (-1.3 * (1.3 / 3. + 0.13 - 2. / 7.) / 2.3), 1e-14);
+}
@@ -1,5 +1,7 @@
 #include "../eft.h"
 
+#include <vector>
+#include <string>
 #include <gtest/gtest.h>
 
 /*
@@ -43,6 +45,16 @@ namespace
         return (error == 0);
     }
 
+    /*
+     * hides a value from the optimizer so that the EFT are computed at runtime rather than folded at compile time
+     */
+    template<typename F>
+    F opaque(F x)
+    {
+        volatile F result = x;
+        return result;
+    }
+
     TEST(EFT_SUM, float)
     {
         // cancellation
@@ -71,6 +83,50 @@ namespace
         EXPECT_FALSE(test_exactSub<double>(1.11, 4.111));
     }
 
+    /*
+     * the EFT stay exact when the compiler is allowed to reassociate (this file is also compiled with -ffast-math)
+     * a compiler seeing through TwoSum would simplify ((x+y) - x) into y and return a zero error
+     */
+    TEST(EFT_SUM, exact)
+    {
+        const double x = opaque(1.);
+        const double y = opaque(numOfHex<double>("0x1.8p-53")); // three quarters of an ulp of 1, rounded up
+        const double z = x + y;
+        EXPECT_EQ(z, 1. + numOfHex<double>("0x1p-52"));
+        EXPECT_EQ(EFT::TwoSum(x, y, z), -numOfHex<double>("0x1p-54"));
+        EXPECT_EQ(EFT::TwoSum(y, x, z), -numOfHex<double>("0x1p-54"));
+        EXPECT_EQ(EFT::FastTwoSum(x, y, z), -numOfHex<double>("0x1p-54"));
+
+        // compensated sum of 0.1 : the errors account exactly for the rounding of each addition
+        const double tenth = opaque(0.1);
+        double sum = 0.;
+        double error = 0.;
+        for(int i = 0; i < 10; i++)
+        {
+            const double newSum = opaque(sum + tenth); // the sum itself is not protected from reassociation
+            error += EFT::TwoSum(sum, tenth, newSum);
+            sum = newSum;
+        }
+        EXPECT_EQ(sum, numOfHex<double>("0x1.fffffffffffffp-1"));
+        EXPECT_EQ(error, numOfHex<double>("0x1.8p-53")); // 10*0.1 = 1 + 2^-54 in exact arithmetic
+    }
+
+    TEST(EFT_FMA, exact)
+    {
+        // the product 1 + 2^-29 + 2^-60 is lost below the ulp of the result
+        const double a = opaque(1. + numOfHex<double>("0x1p-30"));
+        const double c = opaque(numOfHex<double>("0x1p60"));
+        const double result = std::fma(a, a, c);
+        EXPECT_EQ(result, c);
+        EXPECT_EQ(EFT::ErrorFma(a, a, c, result), 1. + numOfHex<double>("0x1p-29"));
+
+        // the result of the fma is exact
+        const double minusOne = opaque(-1.);
+        const double exactResult = std::fma(a, a, minusOne);
+        EXPECT_EQ(exactResult, numOfHex<double>("0x1p-29") + numOfHex<double>("0x1p-60"));
+        EXPECT_EQ(EFT::ErrorFma(a, a, minusOne, exactResult), 0.);
+    }
+
     // tests inspired by https://bugs.python.org/file46304/fma_reference.py
     // exponent should go from to 64 and from to 127 for tests to be valid at float precision (but not all tests can be converted to float precision)
     TEST(EFT_FMA, double)
@@ -86,7 +142,9 @@ namespace
         double b = a;
         double c = numOfHex<double>("0x1p1023");
         EXPECT_EQ(std::fma(a, b, -c), c);
+        #ifndef __FAST_MATH__
         EXPECT_NE(a*b-c, c); // could pass if the compiler introduces an fma
+        #endif
 
         // single rounding
         a = numOfHex<double>("0x1p-50");
@@ -119,7 +177,9 @@ namespace
             double rc = numOfHex<double>(test_values[i+2].c_str());
             double expected = numOfHex<double>(test_values[i+3].c_str());
             EXPECT_EQ(std::fma(ra, rb, rc), expected);
+            #ifndef __FAST_MATH__
             EXPECT_NE(ra*rb+rc, expected); // could pass if the compiler introduces an fma
+            #endif
         }
     }
 }
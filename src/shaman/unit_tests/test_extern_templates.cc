@@ -0,0 +1,45 @@
+#include <shaman.h>
+
+#include <sstream>
+#include <gtest/gtest.h>
+
+// built with SHAMAN_EXTERN_TEMPLATES (see CMakeLists.txt) : every function declared in shaman/instantiations.h is used here
+// so that an instantiation missing from instantiations.cpp fails the link
+#ifdef SHAMAN_EXTERN_TEMPLATES
+namespace
+{
+    // calls every function instantiated for Stype, returns the sum of their results
+    template<typename Stype>
+    Stype callInstantiations()
+    {
+        const Stype x = Stype(1) / Stype(3);
+        const Stype y = Stype(2) / Stype(7);
+        Stype sum = 0;
+        sum += Sstd::cos(x) + Sstd::sin(x) + Sstd::tan(x) + Sstd::atan(x) + Sstd::acos(x) + Sstd::asin(x);
+        sum += Sstd::cosh(x) + Sstd::sinh(x) + Sstd::tanh(x) + Sstd::asinh(x) + Sstd::acosh(Stype(1) + x) + Sstd::atanh(x);
+        sum += Sstd::exp(x) + Sstd::exp2(x) + Sstd::expm1(x) + Sstd::ilogb(x);
+        sum += Sstd::log(x) + Sstd::log10(x) + Sstd::log1p(x) + Sstd::log2(x) + Sstd::logb(x);
+        sum += Sstd::cbrt(x) + Sstd::sqrt(x) + Sstd::erf(x) + Sstd::erfc(x) + Sstd::tgamma(x) + Sstd::lgamma(x);
+        sum += Sstd::ceil(x) + Sstd::floor(x) + Sstd::trunc(x) + Sstd::round(x) + Sstd::rint(x) + Sstd::nearbyint(x);
+
+        int exponent = 0;
+        int quotient = 0;
+        Stype integralPart;
+        sum += Sstd::atan2(x, y) + Sstd::pow(x, y) + Sstd::hypot(x, y) + Sstd::hypot(x, y, x);
+        sum += Sstd::fmod(x, y) + Sstd::remainder(x, y) + Sstd::remquo(x, y, &quotient) + Sstd::fma(x, y, x);
+        sum += Sstd::frexp(x, &exponent) + Sstd::ldexp(x, 2) + Sstd::modf(x, &integralPart) + Sstd::scalbn(x, 2) + Sstd::scalbln(x, 2L);
+
+        std::istringstream input(x.to_string());
+        Stype parsed;
+        input >> parsed;
+        return sum + parsed;
+    }
+}
+
+TEST(EXTERN_TEMPLATES, instantiations)
+{
+    EXPECT_TRUE(std::isfinite(callInstantiations<Sfloat>().number));
+    EXPECT_TRUE(std::isfinite(callInstantiations<Sdouble>().number));
+    EXPECT_TRUE(std::isfinite(callInstantiations<Slong_double>().number));
+}
+#endif //SHAMAN_EXTERN_TEMPLATES
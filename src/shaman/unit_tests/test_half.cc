@@ -0,0 +1,106 @@
+#include <shaman.h>
+
+#include <cmath>
+#include <limits>
+#include <gtest/gtest.h>
+
+namespace
+{
+    /*
+     * reference rounding of a double to a format with the given number of mantissa bits and minimum exponent
+     * (computed in double, where it is exact for the 16 bits formats)
+     */
+    double roundReference(double x, int digits, int minExponent)
+    {
+        if((x == 0) || !std::isfinite(x)) return x;
+        const int exponent = std::max(std::ilogb(x), minExponent - 1);
+        const double ulp = std::ldexp(1., exponent - digits + 1);
+        return std::nearbyint(x / ulp) * ulp; // nearbyint rounds to nearest even
+    }
+
+    /*
+     * checks all encodings of a 16 bits format : round trip through float and rounding of the midpoints
+     */
+    template<typename T>
+    void testConversions()
+    {
+        const int digits = std::numeric_limits<T>::digits;
+        const int minExponent = std::numeric_limits<T>::min_exponent;
+        const float max = std::numeric_limits<T>::max();
+
+        for(unsigned int bits = 0; bits < 0x10000u; bits++)
+        {
+            const T x = T::fromBits(static_cast<std::uint16_t>(bits));
+            const float f = x;
+            if(std::isnan(f))
+            {
+                EXPECT_TRUE(std::isnan(static_cast<float>(T(f))));
+                continue;
+            }
+            EXPECT_EQ(T(f).bits, x.bits);
+            if(!std::isfinite(f) || (std::abs(f) >= max)) continue;
+
+            // values between x and its successor (of larger magnitude)
+            const float next = T::fromBits(static_cast<std::uint16_t>(bits + 1));
+            const double midpoint = (double(f) + double(next)) / 2.;
+            EXPECT_EQ(static_cast<float>(T(midpoint)), roundReference(midpoint, digits, minExponent));
+            EXPECT_EQ(static_cast<float>(T(static_cast<float>(midpoint))), roundReference(midpoint, digits, minExponent));
+            EXPECT_EQ(static_cast<float>(T(std::nextafter(midpoint, 0.))), f);
+            EXPECT_EQ(static_cast<float>(T(std::nextafter(midpoint, 2.*midpoint))), next);
+        }
+    }
+}
+
+TEST(HALF, conversions)
+{
+    testConversions<Shaman::half>();
+    testConversions<Shaman::bfloat16>();
+
+    EXPECT_EQ(static_cast<float>(std::numeric_limits<Shaman::half>::max()), 65504.f);
+    EXPECT_EQ(static_cast<float>(std::numeric_limits<Shaman::half>::epsilon()), std::ldexp(1.f, -10));
+    EXPECT_EQ(static_cast<float>(std::numeric_limits<Shaman::bfloat16>::epsilon()), std::ldexp(1.f, -7));
+    EXPECT_TRUE(std::isinf(static_cast<float>(Shaman::half(65520.f))));
+}
+
+TEST(HALF, eft)
+{
+    const Shaman::half x(1.f/3.f);
+    const Shaman::half y(2.f/7.f);
+
+    // the errors are exact
+    const Shaman::half sum = x + y;
+    EXPECT_EQ(double(sum) + double(EFT::TwoSum(x, y, sum)), double(x) + double(y));
+    const Shaman::half product = x * y;
+    EXPECT_EQ(double(product) + double(EFT::FastTwoProd(x, y, product)), double(x) * double(y));
+    const Shaman::half quotient = x / y;
+    EXPECT_EQ(double(quotient) * double(y) + double(EFT::RemainderDiv(x, y, quotient)), double(x));
+
+    // the error of a product of small numbers is representable in float but not in half
+    const Shaman::half small(1e-4f);
+    const Shaman::half smallProduct = small * small;
+    EXPECT_EQ(double(smallProduct) + double(EFT::FastTwoProd(small, small, smallProduct)), double(small) * double(small));
+}
+
+TEST(HALF, error_propagation)
+{
+    // the error of a sum of halves matches the difference with the same sum computed in double
+    Shalf sum(Shaman::half(0.f));
+    double preciseSum = 0.;
+    for(int i = 1; i <= 100; i++)
+    {
+        const Shalf x = Shalf(Shaman::half(1.f)) / Shalf(Shaman::half(float(i)));
+        sum += x;
+        preciseSum += 1. / i;
+    }
+    EXPECT_NEAR(double(sum.number) + sum.error, preciseSum, 1e-6);
+    EXPECT_GT(std::abs(sum.error), 1e-3);
+
+    Sbfloat16 product(Shaman::bfloat16(1.f));
+    double preciseProduct = 1.;
+    for(int i = 1; i <= 20; i++)
+    {
+        product *= Sbfloat16(Shaman::bfloat16(1.1f));
+        preciseProduct *= double(Shaman::bfloat16(1.1f));
+    }
+    EXPECT_NEAR((double(product.number) + product.error) / preciseProduct, 1., 1e-5);
+}
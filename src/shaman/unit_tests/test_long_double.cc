@@ -0,0 +1,36 @@
+#include <shaman.h>
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+#ifdef SHAMAN_QUAD_PRECISION
+
+TEST(LONG_DOUBLE, function_error)
+{
+    // the precise type measures the rounding error of the long double functions
+    const Slong_double x(1.L);
+    const Slong_double result = Sstd::sin(x);
+    const long double expectedError = static_cast<long double>(sinq(1) - std::sin(1.L));
+    EXPECT_NE(result.error, 0.L);
+    EXPECT_EQ(result.error, expectedError);
+}
+
+#else
+
+TEST(LONG_DOUBLE, first_order_error)
+{
+    // the error of x is too small to change x+error but is still propagated by the functions
+    const Slong_double x = Slong_double(1.L) / Slong_double(3.L);
+    ASSERT_NE(x.error, 0.L);
+    ASSERT_EQ(x.number + x.error, x.number);
+
+    const Slong_double expResult = Sstd::exp(x);
+    EXPECT_NEAR(expResult.error / (std::exp(x.number) * x.error), 1.L, 1e-6L);
+    const Slong_double sinResult = Sstd::sin(x);
+    EXPECT_NEAR(sinResult.error / (std::cos(x.number) * x.error), 1.L, 1e-6L);
+
+    // an exact input stays exact
+    EXPECT_EQ(Sstd::exp(Slong_double(1.L)).error, 0.L);
+}
+
+#endif
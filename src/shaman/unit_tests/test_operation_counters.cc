@@ -0,0 +1,93 @@
+#include <shaman.h>
+#include <shaman/helpers/shaman_accumulator.h>
+
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#ifdef SHAMAN_OPERATION_COUNTERS
+namespace
+{
+    // operations performed by a S type in a block (all the operations without tagged error)
+    template<typename Stype>
+    OperationRecord recordOf(const std::string& name)
+    {
+        #ifdef SHAMAN_TAGGED_ERROR
+        const Tag tag = CodeBlock::tagOfName(name);
+        #else
+        const Tag tag = ShamanGlobals::tagUntagged;
+        #endif
+        const std::size_t type = Shaman::operationTypeOf<Stype>(); // registers the type before merging the records
+        return Shaman::operationCounts()[type][tag];
+    }
+
+    unsigned long long countOf(const OperationRecord& record, Shaman::Operation operation)
+    {
+        return record.counts[std::size_t(operation)];
+    }
+}
+
+TEST(OPERATION_COUNTERS, kinds)
+{
+    const OperationRecord before = recordOf<Sfloat>("operation_counters_block");
+    {
+        LOCAL_BLOCK("operation_counters_block");
+        Sfloat x = 2.f;
+        Sfloat y = x + x; // addition
+        y = y - 1.f; // addition (scalar)
+        y *= x; // multiplication
+        y = y / 3.f; // division
+        y = Sstd::sqrt(y) + Sstd::exp(x); // two function calls and an addition
+        EXPECT_TRUE(y > x); // comparison
+    }
+    const OperationRecord after = recordOf<Sfloat>("operation_counters_block");
+    EXPECT_EQ(countOf(after, Shaman::Operation::addition) - countOf(before, Shaman::Operation::addition), 3u);
+    EXPECT_EQ(countOf(after, Shaman::Operation::multiplication) - countOf(before, Shaman::Operation::multiplication), 1u);
+    EXPECT_EQ(countOf(after, Shaman::Operation::division) - countOf(before, Shaman::Operation::division), 1u);
+    EXPECT_EQ(countOf(after, Shaman::Operation::function) - countOf(before, Shaman::Operation::function), 2u);
+    EXPECT_EQ(countOf(after, Shaman::Operation::comparison) - countOf(before, Shaman::Operation::comparison), 1u);
+
+    Shaman::displayOperationCounts({1., 1., 5., 20., 1.});
+}
+
+TEST(OPERATION_COUNTERS, types_and_threads)
+{
+    const OperationRecord beforeDouble = recordOf<Sdouble>("operation_counters_thread_block");
+    const OperationRecord beforeCompact = recordOf<Sdouble_compact>("operation_counters_thread_block");
+    auto work = []()
+    {
+        LOCAL_BLOCK("operation_counters_thread_block");
+        Sdouble x = 1.;
+        Sdouble_compact y = 1.;
+        for(int i = 0; i < 100; i++)
+        {
+            x = x * 1.5;
+            y = y * 1.5;
+        }
+    };
+    std::thread thread1(work);
+    std::thread thread2(work);
+    thread1.join();
+    thread2.join();
+
+    EXPECT_NE(Shaman::operationTypeOf<Sdouble>(), Shaman::operationTypeOf<Sdouble_compact>());
+    const OperationRecord afterDouble = recordOf<Sdouble>("operation_counters_thread_block");
+    const OperationRecord afterCompact = recordOf<Sdouble_compact>("operation_counters_thread_block");
+    EXPECT_EQ(countOf(afterDouble, Shaman::Operation::multiplication) - countOf(beforeDouble, Shaman::Operation::multiplication), 200u);
+    EXPECT_EQ(countOf(afterCompact, Shaman::Operation::multiplication) - countOf(beforeCompact, Shaman::Operation::multiplication), 200u);
+}
+
+TEST(OPERATION_COUNTERS, accumulator)
+{
+    const OperationRecord before = recordOf<Sdouble>("operation_counters_accumulator_block");
+    {
+        LOCAL_BLOCK("operation_counters_accumulator_block");
+        const std::vector<Sdouble> values(1000, Sdouble(0.1));
+        Shaman::simd_accumulator<Sdouble> sum;
+        sum.add(values.data(), values.size());
+        sum += values[0];
+    }
+    const OperationRecord after = recordOf<Sdouble>("operation_counters_accumulator_block");
+    EXPECT_EQ(countOf(after, Shaman::Operation::addition) - countOf(before, Shaman::Operation::addition), 1001u);
+}
+#endif //SHAMAN_OPERATION_COUNTERS
@@ -0,0 +1,118 @@
+#include <shaman.h>
+#include "test_block_error.h"
+
+#include <cmath>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#ifdef SHAMAN_TAGGED_ERROR
+namespace
+{
+    Sdouble pooledBlock(Sdouble x)
+    {
+        LOCAL_BLOCK("pool_block");
+        return x / 3.;
+    }
+}
+
+TEST(POOL, copy_on_write)
+{
+    const Sdouble x = pooledBlock(Sdouble(1.));
+    ASSERT_NE(x.error, 0.);
+
+    // modifying a copy does not modify the original
+    const Sdouble z = pooledBlock(Sdouble(2.));
+    Sdouble y = x;
+    y += z;
+    EXPECT_EQ(blockError(x, "pool_block"), x.error);
+    EXPECT_EQ(blockError(y, "pool_block"), x.error + z.error);
+
+    // the composants survive the resizing of a vector
+    std::vector<Sdouble> values;
+    for(int i = 1; i <= 100; i++)
+    {
+        values.push_back(pooledBlock(Sdouble(double(i))));
+    }
+    for(const Sdouble& value : values)
+    {
+        EXPECT_EQ(blockError(value, "pool_block"), value.error);
+    }
+}
+
+TEST(POOL, threads)
+{
+    // numbers computed on a thread outlive it
+    std::vector<Sdouble> values(4);
+    std::vector<std::thread> threads;
+    for(std::size_t t = 0; t < values.size(); t++)
+    {
+        threads.emplace_back([&values, t]()
+        {
+            LOCAL_BLOCK("pool_block");
+            Sdouble sum = 0.;
+            for(int i = 1; i <= 100; i++)
+            {
+                sum += pooledBlock(Sdouble(double(i + t)));
+            }
+            values[t] = sum;
+        });
+    }
+    for(std::thread& thread : threads) thread.join();
+
+    for(const Sdouble& value : values)
+    {
+        EXPECT_NEAR(blockError(value, "pool_block"), value.error, 1e-3 * std::abs(value.error) + 1e-20);
+    }
+}
+
+#ifdef SHAMAN_POOLED_ERROR
+TEST(POOL, sharing)
+{
+    // exact numbers do not use a block
+    const Sdouble exact = Sdouble(1.) + Sdouble(2.);
+    EXPECT_EQ(exact.errorComposants.block, nullptr);
+
+    // copies share their block until they are modified
+    const Sdouble x = pooledBlock(Sdouble(1.));
+    ASSERT_NE(x.errorComposants.block, nullptr);
+    Sdouble y = x;
+    EXPECT_EQ(y.errorComposants.block, x.errorComposants.block);
+    y *= 3.;
+    EXPECT_NE(y.errorComposants.block, x.errorComposants.block);
+
+    // adding an error to a number without error shares the composants
+    Sdouble z = exact;
+    z.errorComposants.addErrors(x.errorComposants);
+    EXPECT_EQ(z.errorComposants.block, x.errorComposants.block);
+
+    // a number only stores a pointer to its composants
+    EXPECT_LE(sizeof(Sdouble), 3 * sizeof(double));
+}
+
+namespace
+{
+    // destroyed at program exit, after the pool of the main thread
+    Sdouble staticValue;
+}
+
+TEST(POOL, destroyed_pool)
+{
+    // a static number still holding an error when the program exits
+    staticValue = pooledBlock(Sdouble(1.));
+    ASSERT_NE(staticValue.errorComposants.block, nullptr);
+
+    // a thread_local number constructed before the pool of its thread is destroyed after it
+    std::thread thread([]()
+    {
+        thread_local Sdouble threadValue;
+        threadValue = pooledBlock(Sdouble(2.));
+    });
+    thread.join();
+
+    // the blocks given back by the thread can be used
+    const Sdouble x = pooledBlock(Sdouble(4.));
+    EXPECT_EQ(blockError(x, "pool_block"), x.error);
+}
+#endif //SHAMAN_POOLED_ERROR
+#endif //SHAMAN_TAGGED_ERROR
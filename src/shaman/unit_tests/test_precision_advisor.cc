@@ -0,0 +1,87 @@
+#include <shaman.h>
+
+#include <gtest/gtest.h>
+
+#ifdef SHAMAN_PRECISION_ADVISOR
+namespace
+{
+    // precision advised for a block
+    std::string advisedPrecisionOf(const std::string& name)
+    {
+        return Shaman::advisedPrecision(Shaman::precisionRecords()[CodeBlock::tagOfName(name)]);
+    }
+
+    // a number whose relative error, generated in the current block, is relativeError
+    Sdouble noisy(double number, double relativeError)
+    {
+        error_composants<double> composants;
+        composants.addError(number * relativeError);
+        return Sdouble(number, number * relativeError, composants);
+    }
+}
+
+// NOTE: runs before any output is observed
+TEST(PRECISION_ADVISOR, values_produced)
+{
+    {
+        LOCAL_BLOCK("advisor_noisy_block");
+        for(int i = 1; i <= 10; i++) EXPECT_GT(noisy(i, 1e-2).number, 0.);
+    }
+    EXPECT_EQ(advisedPrecisionOf("advisor_noisy_block"), "bfloat16");
+
+    {
+        LOCAL_BLOCK("advisor_float_block");
+        for(int i = 1; i <= 10; i++) EXPECT_GT(noisy(i, 1e-5).number, 0.);
+    }
+    EXPECT_EQ(advisedPrecisionOf("advisor_float_block"), "float");
+
+    // a single precise value is enough to keep the precision of a block
+    {
+        LOCAL_BLOCK("advisor_mixed_block");
+        for(int i = 1; i <= 10; i++) EXPECT_GT(noisy(i, 1e-2).number, 0.);
+        EXPECT_GT(noisy(1., 1e-12).number, 0.);
+    }
+    EXPECT_EQ(advisedPrecisionOf("advisor_mixed_block"), "");
+
+    // exact values do not keep the precision of a block
+    {
+        LOCAL_BLOCK("advisor_exact_block");
+        for(int i = 1; i <= 10; i++) EXPECT_GT(noisy(i, 1e-2).number, 0.);
+        EXPECT_EQ((Sdouble(1.) + Sdouble(2.)).error, 0.);
+        EXPECT_EQ((Sdouble(3.) * 2.).error, 0.);
+    }
+    const PrecisionRecord exactRecord = Shaman::precisionRecords()[CodeBlock::tagOfName("advisor_exact_block")];
+    EXPECT_EQ(exactRecord.exactValueNumber, 2u);
+    EXPECT_EQ(advisedPrecisionOf("advisor_exact_block"), "bfloat16");
+
+    // a block of exact values gives no information on the precision it needs
+    {
+        LOCAL_BLOCK("advisor_only_exact_block");
+        EXPECT_EQ((Sdouble(1.) + Sdouble(2.)).error, 0.);
+    }
+    EXPECT_EQ(advisedPrecisionOf("advisor_only_exact_block"), "");
+
+    Shaman::displayPrecisionAdvice();
+}
+
+TEST(PRECISION_ADVISOR, observed_outputs)
+{
+    Sdouble input;
+    {
+        LOCAL_BLOCK("advisor_input_block");
+        input = noisy(1., 1e-2);
+    }
+    Sdouble output;
+    {
+        LOCAL_BLOCK("advisor_output_block");
+        output = input / 3. + Sdouble(1.) / 7.;
+    }
+    Shaman::observe(output);
+
+    // the error of the output comes from the input, the rounding errors of its computation are negligible
+    EXPECT_EQ(advisedPrecisionOf("advisor_input_block"), "");
+    EXPECT_EQ(advisedPrecisionOf("advisor_output_block"), "bfloat16");
+
+    Shaman::displayPrecisionAdvice();
+}
+#endif //SHAMAN_PRECISION_ADVISOR
@@ -0,0 +1,70 @@
+#include <shaman.h>
+#include <shaman/helpers/shaman_region.h>
+
+#include <vector>
+#include <gtest/gtest.h>
+
+TEST(REGION, write_back)
+{
+    std::vector<double> data = {1., 2., 3.};
+    {
+        Shaman::Region<double> x(data.data(), data.size());
+        EXPECT_EQ(x[1].error, 0.); // values enter the region exact
+        for(auto& xi : x) xi = xi / 3.;
+    }
+
+    for(std::size_t i = 0; i < data.size(); i++)
+    {
+        const Sdouble expected = Sdouble(i + 1.) / 3.;
+        EXPECT_EQ(data[i], expected.number);
+        EXPECT_EQ(Shaman::region_error(&data[i]), expected.error);
+        EXPECT_EQ(Shaman::region_value(data[i]).error, expected.error);
+    }
+
+    Shaman::clear_region_errors(data.data(), data.size());
+}
+
+TEST(REGION, exact_values_are_not_stored)
+{
+    double x = 1.;
+    {
+        Shaman::Region<double> region(x);
+        region[0] = region[0] / 3.;
+    }
+    EXPECT_NE(Shaman::region_error(&x), 0.L);
+    {
+        // a later exact result replaces the previous error
+        Shaman::Region<double> region(x);
+        region[0] = 2.;
+    }
+    EXPECT_EQ(Shaman::region_error(&x), 0.L);
+    EXPECT_EQ(x, 2.);
+}
+
+TEST(REGION, reentry)
+{
+    std::vector<double> data = {1., 2.};
+    {
+        Shaman::Region<double> x(data.data(), data.size());
+        for(auto& xi : x) xi = xi / 3.;
+    }
+
+    // entering the region again resumes from the stored errors
+    const Sdouble first = Sdouble(1.) / 3.;
+    const Sdouble second = (Sdouble(2.) / 3.) * 3.;
+    {
+        Shaman::Region<double> x(data.data(), data.size());
+        EXPECT_EQ(x[0].error, first.error);
+        x[1] = x[1] * 3.;
+    }
+    EXPECT_EQ(Shaman::region_error(&data[0]), first.error);
+    EXPECT_EQ(Shaman::region_error(&data[1]), second.error);
+
+    // numbers that became exact leave no entry behind
+    {
+        Shaman::Region<double> x(data.data(), data.size());
+        for(auto& xi : x) xi = 1.;
+    }
+    EXPECT_EQ(Shaman::region_error(&data[0]), 0.L);
+    EXPECT_EQ(Shaman::region_error(&data[1]), 0.L);
+}
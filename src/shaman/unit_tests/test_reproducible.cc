@@ -0,0 +1,99 @@
+#include <shaman.h>
+#include <shaman/helpers/shaman_reproducible.h>
+
+#include <random>
+#include <algorithm>
+#include <gtest/gtest.h>
+
+namespace
+{
+    /*
+     * values spanning a large range of magnitudes with a lot of cancellations
+     */
+    std::vector<Sdouble> randomValues(int size)
+    {
+        std::mt19937_64 generator(42);
+        std::uniform_real_distribution<double> mantissa(-1., 1.);
+        std::uniform_int_distribution<int> exponent(-60, 60);
+        std::vector<Sdouble> values;
+        for(int i = 0; i < size; i++)
+        {
+            values.push_back(Sdouble(std::ldexp(mantissa(generator), exponent(generator))) / 3.);
+        }
+        return values;
+    }
+
+    /*
+     * sums the values cut in a given number of contiguous chunks
+     */
+    Sdouble chunkedSum(const std::vector<Sdouble>& values, size_t chunkNumber)
+    {
+        std::vector<Shaman::reproducible_sum<Sdouble>> partials(chunkNumber);
+        for(size_t chunk = 0; chunk < chunkNumber; chunk++)
+        {
+            for(size_t i = (values.size()*chunk)/chunkNumber; i < (values.size()*(chunk+1))/chunkNumber; i++)
+            {
+                partials[chunk] += values[i];
+            }
+        }
+        Shaman::reproducible_sum<Sdouble> sum;
+        for(auto& partial : partials) sum += partial;
+        return sum.result();
+    }
+
+    TEST(REPRODUCIBLE_SUM, exact)
+    {
+        Shaman::reproducible_sum<double> sum;
+        sum += 1e100;
+        sum += 1.;
+        sum += -1e100;
+        EXPECT_EQ(sum.result(), 1.);
+
+        // ties are rounded to even
+        Shaman::reproducible_sum<double> tie;
+        tie += 1.;
+        tie += std::ldexp(1., -53);
+        EXPECT_EQ(tie.result(), 1.);
+        tie += std::ldexp(1., -80);
+        EXPECT_EQ(tie.result(), 1. + std::ldexp(1., -52));
+
+        // subnormal results are exact
+        Shaman::reproducible_sum<double> subnormal;
+        subnormal += std::numeric_limits<double>::denorm_min();
+        subnormal += std::numeric_limits<double>::denorm_min();
+        EXPECT_EQ(subnormal.result(), 2*std::numeric_limits<double>::denorm_min());
+
+        Shaman::reproducible_sum<float> negative;
+        negative += -1.5f;
+        negative += 0.25f;
+        EXPECT_EQ(negative.result(), -1.25f);
+    }
+
+    TEST(REPRODUCIBLE_SUM, order_independence)
+    {
+        std::vector<Sdouble> values = randomValues(100000);
+        Sdouble reference = chunkedSum(values, 1);
+
+        for(size_t chunkNumber : {2, 3, 7, 64, 2048})
+        {
+            Sdouble sum = chunkedSum(values, chunkNumber);
+            EXPECT_EQ(sum.number, reference.number);
+            EXPECT_EQ(sum.error, reference.error);
+        }
+
+        std::reverse(values.begin(), values.end());
+        Sdouble reversed = Shaman::reproducible_reduce(Shaman::execution::par, values.begin(), values.end());
+        EXPECT_EQ(reversed.number, reference.number);
+        EXPECT_EQ(reversed.error, reference.error);
+    }
+
+    TEST(REPRODUCIBLE_SUM, special_values)
+    {
+        Shaman::reproducible_sum<double> sum;
+        sum += 1.;
+        sum += std::numeric_limits<double>::infinity();
+        EXPECT_EQ(sum.result(), std::numeric_limits<double>::infinity());
+        sum += -std::numeric_limits<double>::infinity();
+        EXPECT_TRUE(std::isnan(sum.result()));
+    }
+}
@@ -0,0 +1,85 @@
+#include <shaman.h>
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+namespace
+{
+    /*
+     * checks that two S numbers are identical (number, error and, in tagged mode, error composants)
+     */
+    template<typename Stype>
+    void expectIdentical(const Stype& x, const Stype& y)
+    {
+        EXPECT_EQ(x.number, y.number);
+        EXPECT_EQ(x.error, y.error);
+        #ifdef SHAMAN_TAGGED_ERROR
+        using errorType = decltype(x.error);
+        const error_sum<errorType> composants1 = x.errorComposants;
+        const error_sum<errorType> composants2 = y.errorComposants;
+        for(unsigned int i = 0; i < composants1.maxTagNumber; i++)
+        {
+            EXPECT_EQ(composants1.errors[i], composants2.errors[i]);
+        }
+        #endif
+    }
+
+    /*
+     * the scalar operations give the same result as the S-S operations with a zero error scalar
+     */
+    template<typename Stype, typename T>
+    void testScalarOperations(const Stype& x, T scalar)
+    {
+        const Stype s(scalar);
+        expectIdentical<Stype>(x + scalar, x + s);
+        expectIdentical<Stype>(scalar + x, s + x);
+        expectIdentical<Stype>(x - scalar, x - s);
+        expectIdentical<Stype>(scalar - x, s - x);
+        expectIdentical<Stype>(x * scalar, x * s);
+        expectIdentical<Stype>(scalar * x, s * x);
+        expectIdentical<Stype>(x / scalar, x / s);
+        expectIdentical<Stype>(scalar / x, s / x);
+    }
+
+    // a number with a non zero error
+    template<typename Stype>
+    Stype inexactNumber()
+    {
+        Stype x = Stype(1) / Stype(3);
+        x = x * Stype(7) - Stype(2) / Stype(11);
+        return x;
+    }
+}
+
+TEST(SCALAR, matches_S_operations)
+{
+    const Sdouble x = inexactNumber<Sdouble>();
+    ASSERT_NE(x.error, 0.);
+    testScalarOperations(x, 2.);
+    testScalarOperations(x, 0.1);
+    testScalarOperations(x, -3.5f);
+    testScalarOperations(x, 7);
+
+    const Sfloat y = inexactNumber<Sfloat>();
+    ASSERT_NE(y.error, 0.f);
+    testScalarOperations(y, 0.1f);
+    testScalarOperations(y, 42);
+
+    // the number type of a Sdouble_compact is preserved
+    const Sdouble_compact z = inexactNumber<Sdouble_compact>();
+    testScalarOperations(z, 0.1);
+}
+
+TEST(SCALAR, inexact_scalar)
+{
+    // 2^24+1 is not representable in float, the rounding of the integer is still accounted for
+    const Sfloat x(1.5f);
+    const int large = 16777217;
+    const Sfloat sum = x + large;
+    EXPECT_EQ(double(sum.number) + double(sum.error), 16777218.5);
+
+    // a double operand promotes a Sfloat to a Sdouble
+    const Sdouble product = Sfloat(3.f) * 0.1;
+    EXPECT_EQ(product.number, 3. * 0.1);
+    EXPECT_EQ(product.error, std::fma(3., 0.1, -product.number));
+}
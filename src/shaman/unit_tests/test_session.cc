@@ -0,0 +1,71 @@
+#include <shaman.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <gtest/gtest.h>
+
+namespace
+{
+    // the session can be used by the static initializers of any translation unit
+    const double staticSignificanceBase = Shaman::session().significanceBase;
+}
+
+TEST(SESSION, environment)
+{
+    setenv("SHAMAN_UNSTABLE_DIGITS", "3", 1);
+    setenv("SHAMAN_POOL_CHUNK_SIZE", "64", 1);
+    setenv("SHAMAN_WATCH_CAPACITY", "not_a_number", 1);
+    const Shaman::Session session;
+    unsetenv("SHAMAN_UNSTABLE_DIGITS");
+    unsetenv("SHAMAN_POOL_CHUNK_SIZE");
+    unsetenv("SHAMAN_WATCH_CAPACITY");
+
+    EXPECT_DOUBLE_EQ(session.significanceBase, 1000.);
+    EXPECT_EQ(session.poolChunkSize, 64u);
+    EXPECT_EQ(session.watchCapacity, std::size_t(1) << 16); // invalid values are ignored
+    EXPECT_TRUE(session.reportPath.empty());
+}
+
+TEST(SESSION, significance)
+{
+    EXPECT_GT(staticSignificanceBase, 1.);
+    const double base = Shaman::session().significanceBase;
+    // 1 +- 0.01 has two significant digits
+    EXPECT_FALSE(Sdouble::non_significant(1., 0.01));
+    Shaman::session().significanceBase = 1000.;
+    EXPECT_TRUE(Sdouble::non_significant(1., 0.01));
+    Shaman::session().significanceBase = base;
+    EXPECT_FALSE(Sdouble::non_significant(1., 0.01));
+}
+
+TEST(SESSION, report)
+{
+    const std::string path = "shaman_test_report.txt";
+    std::remove(path.c_str());
+    Shaman::session().reportPath = path;
+    Shaman::session().report() << "#SHAMAN: report" << std::endl;
+    Shaman::session().reportPath.clear();
+
+    std::ifstream file(path);
+    std::stringstream content;
+    content << file.rdbuf();
+    EXPECT_EQ(content.str(), "#SHAMAN: report\n");
+    std::remove(path.c_str());
+}
+
+TEST(SESSION, report_lock)
+{
+    // a report keeps the others waiting until it is complete
+    std::future<void> otherReport;
+    {
+        Shaman::Session::ReportWriter report = Shaman::session().report();
+        otherReport = std::async(std::launch::async, [](){Shaman::session().report() << "#SHAMAN: second report" << std::endl;});
+        EXPECT_EQ(otherReport.wait_for(std::chrono::milliseconds(50)), std::future_status::timeout);
+        report << "#SHAMAN: first report" << std::endl;
+    }
+    otherReport.get();
+}
@@ -0,0 +1,43 @@
+#include <shaman.h>
+#include <shaman/helpers/shaman_shadow.h>
+
+#include <vector>
+#include <gtest/gtest.h>
+
+TEST(SHADOW, tracks_errors)
+{
+    std::vector<double> data = {1., 2., 3.};
+    Shaman::shadow_register(data.data(), data.size());
+
+    Shaman::ShadowArray<double> x(data.data());
+    EXPECT_EQ(x[1].value().error, 0.); // registered buffers start exact
+    for(std::size_t i = 0; i < data.size(); i++) x[i] = x[i] / 3.;
+    x[2] += x[0] * x[1];
+
+    Sdouble expected[3] = {Sdouble(1.) / 3., Sdouble(2.) / 3., Sdouble(3.) / 3.};
+    expected[2] += expected[0] * expected[1];
+    for(std::size_t i = 0; i < data.size(); i++)
+    {
+        EXPECT_EQ(data[i], expected[i].number);
+        EXPECT_EQ(Shaman::shadow_value(data[i]).error, expected[i].error);
+    }
+
+    Shaman::shadow_unregister(data.data());
+    EXPECT_EQ(Shaman::shadow_errors(&data[0]), nullptr);
+}
+
+TEST(SHADOW, registration)
+{
+    std::vector<float> data(10);
+    Shaman::shadow_register(data.data(), data.size());
+
+    // interior pointers find their buffer
+    Shaman::ShadowArray<float> x(&data[4]);
+    EXPECT_EQ(x.errors(), Shaman::shadow_errors(data.data()) + 4);
+
+    // overlapping registrations are refused
+    EXPECT_THROW(Shaman::shadow_register(&data[5], 10), std::invalid_argument);
+
+    Shaman::shadow_unregister(data.data());
+    EXPECT_THROW(Shaman::ShadowArray<float> y(data.data()), std::invalid_argument);
+}
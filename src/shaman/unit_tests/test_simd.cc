@@ -0,0 +1,71 @@
+#include <shaman.h>
+
+// the lane types require the error composants of error_sum
+#if !defined(SHAMAN_PACKED) && !defined(SHAMAN_TAPE) && !defined(SHAMAN_POOLED_ERROR) && !defined(SHAMAN_TOPK_ERROR)
+#include <shaman/helpers/shaman_simd.h>
+
+#include <vector>
+#include <gtest/gtest.h>
+
+using Svector = Shaman::Ssimd<double>;
+
+namespace
+{
+    // scalar reference of the kernel
+    template<typename T>
+    T kernel(const T& x, const T& y)
+    {
+        T result = (x * x + y) / 3.;
+        result = Sstd::sqrt(result) - x / 7.;
+        return Sstd::fma(result, y, x);
+    }
+}
+
+TEST(SIMD, lanes_match_scalar)
+{
+    const std::size_t size = Svector().number.size();
+    std::vector<Sdouble> x(size);
+    std::vector<Sdouble> y(size);
+    for(std::size_t i = 0; i < size; i++)
+    {
+        x[i] = Sdouble(1.) / Sdouble(double(i + 1));
+        y[i] = Sdouble(double(i + 2)) / 11.;
+    }
+
+    const Svector result = kernel(Shaman::simd_load<double>(x.data()), Shaman::simd_load<double>(y.data()));
+    std::vector<Sdouble> output(size);
+    Shaman::simd_store(result, output.data());
+
+    for(std::size_t i = 0; i < size; i++)
+    {
+        const Sdouble expected = kernel(x[i], y[i]);
+        EXPECT_EQ(output[i].number, expected.number);
+        EXPECT_EQ(output[i].error, expected.error);
+    }
+}
+
+TEST(SIMD, comparisons)
+{
+    const std::size_t size = Svector().number.size();
+    std::vector<Sdouble> x(size);
+    for(std::size_t i = 0; i < size; i++) x[i] = Sdouble(double(i));
+    const Svector vector = Shaman::simd_load<double>(x.data());
+
+    const auto mask = vector < 1.;
+    EXPECT_TRUE(mask[0]);
+    for(std::size_t i = 1; i < size; i++) EXPECT_FALSE(mask[i]);
+
+    const Svector clamped = Sstd::min(vector, Svector(1.));
+    for(std::size_t i = 0; i < size; i++) EXPECT_EQ(Shaman::lane(clamped, i).number, (i == 0) ? 0. : 1.);
+
+    #if defined(SHAMAN_UNSTABLE_BRANCH) && !defined(SHAMAN_TAGGED_ERROR)
+    // a value that is only noise is unstable in every lane
+    const Svector tenth = Svector(1.) / 10.;
+    const Svector noise = (tenth + tenth * 2.) - Svector(3.) / 10.;
+    const int before = ShamanGlobals::unstableBranchCounter;
+    (void)(noise == 0.);
+    EXPECT_EQ(ShamanGlobals::unstableBranchCounter - before, int(size));
+    #endif
+}
+
+#endif //SHAMAN_PACKED && SHAMAN_TAPE && SHAMAN_POOLED_ERROR && SHAMAN_TOPK_ERROR
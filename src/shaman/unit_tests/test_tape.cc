@@ -0,0 +1,112 @@
+#include <shaman.h>
+#include <shaman/helpers/shaman_tape.h>
+#include "test_block_error.h"
+
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+
+#ifdef SHAMAN_TAGGED_ERROR
+namespace
+{
+    Sdouble firstBlock(Sdouble x)
+    {
+        LOCAL_BLOCK("tape_first_block");
+        return x / 3.;
+    }
+
+    Sdouble secondBlock(Sdouble x)
+    {
+        LOCAL_BLOCK("tape_second_block");
+        Sdouble sum = x;
+        for(int i = 1; i <= 100; i++)
+        {
+            sum += x / double(i);
+        }
+        return sum;
+    }
+}
+
+TEST(TAPE, attribution)
+{
+    const Sdouble result = secondBlock(firstBlock(Sdouble(1.)));
+
+    // the composants add up to the error
+    const double first = blockError(result, "tape_first_block");
+    const double second = blockError(result, "tape_second_block");
+    EXPECT_NE(first, 0.);
+    EXPECT_NE(second, 0.);
+    EXPECT_NEAR(first + second, result.error, 1e-3 * std::abs(result.error));
+
+    // the error of the first block is amplified by the second block
+    const Sdouble input = firstBlock(Sdouble(1.));
+    EXPECT_NEAR(first, input.error * (result.number / input.number), 1e-3 * std::abs(first));
+}
+
+TEST(TAPE, shared_operations)
+{
+    // an operation completed in place must not change the attribution of the numbers computed from it
+    Sdouble x = Sdouble(1.) / 3.;
+    const Sdouble y = Sdouble(2.) / 7.;
+    const Sdouble w = Sdouble(3.) / 11.;
+    const Sdouble v = Sdouble(1e-20) / 3.; // its sum with x has a rounding error
+    x *= y;
+    const Sdouble z = x * w;
+    const error_sum<double> before = z.errorComposants;
+    x += v;
+    const error_sum<double> after = z.errorComposants;
+    for(size_t tag = 0; tag < error_sum<double>::maxTagNumber; tag++)
+    {
+        EXPECT_EQ(after.errors[tag], before.errors[tag]);
+    }
+    double total = 0;
+    for(double error : after.errors) total += error;
+    EXPECT_NEAR(total, z.error, 1e-3 * std::abs(z.error));
+
+    // an operation that leaves the error of its operand unchanged shares the operand's node
+    Sdouble a = Sdouble(1.) / 3.;
+    a *= y;
+    const Sdouble copy = a + Sdouble(0.);
+    const error_sum<double> copyBefore = copy.errorComposants;
+    a += v;
+    const error_sum<double> copyAfter = copy.errorComposants;
+    for(size_t tag = 0; tag < error_sum<double>::maxTagNumber; tag++)
+    {
+        EXPECT_EQ(copyAfter.errors[tag], copyBefore.errors[tag]);
+    }
+}
+
+#ifdef SHAMAN_TAPE
+TEST(TAPE, contributions)
+{
+    const Sdouble result = secondBlock(firstBlock(Sdouble(1.)));
+    const std::vector<Shaman::TapeContribution> contributions = Shaman::tape_contributions(result, 3);
+    ASSERT_EQ(contributions.size(), 3u);
+    EXPECT_GE(std::abs(contributions[0].error), std::abs(contributions[1].error));
+    EXPECT_GE(std::abs(contributions[1].error), std::abs(contributions[2].error));
+    EXPECT_LT(contributions[0].operation, Shaman::tape_size());
+
+    // an exact number has no contribution
+    EXPECT_TRUE(Shaman::tape_contributions(Sdouble(2.), 3).empty());
+}
+
+TEST(TAPE, checkpoint)
+{
+    std::vector<Sdouble> state = {firstBlock(Sdouble(1.)), secondBlock(Sdouble(2.))};
+    state[1] = secondBlock(state[0] + state[1]);
+    const double first = blockError(state[1], "tape_first_block");
+    const double second = blockError(state[1], "tape_second_block");
+    EXPECT_GT(Shaman::tape_size(), 100u);
+
+    // at most one operation per block (first, second and untagged) and number remains
+    Shaman::tape_checkpoint(state.begin(), state.end());
+    EXPECT_LE(Shaman::tape_size(), 4u);
+    EXPECT_DOUBLE_EQ(blockError(state[1], "tape_first_block"), first);
+    EXPECT_DOUBLE_EQ(blockError(state[1], "tape_second_block"), second);
+
+    // later operations are recorded after the checkpoint
+    const Sdouble next = state[1] / 7.;
+    EXPECT_DOUBLE_EQ(blockError(next, "tape_first_block"), first / 7.);
+}
+#endif //SHAMAN_TAPE
+#endif //SHAMAN_TAGGED_ERROR
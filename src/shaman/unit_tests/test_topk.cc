@@ -0,0 +1,143 @@
+#include <shaman.h>
+
+#include <cmath>
+#include <string>
+#include <gtest/gtest.h>
+
+#ifdef SHAMAN_TOPK_ERROR
+namespace
+{
+    using Composants = error_topk<double>;
+
+    // composants with an error of (i+1) in the block "topk_i", for i in [first;last[
+    Composants composants(int first, int last)
+    {
+        Composants result;
+        for(int i = first; i < last; i++)
+        {
+            CodeBlock block("topk_" + std::to_string(i));
+            result.addError(double(i + 1));
+        }
+        return result;
+    }
+
+    // error kept for a block (0 if it is not kept)
+    double errorOf(const Composants& composants, int i)
+    {
+        const Tag tag = CodeBlock::tagOfName("topk_" + std::to_string(i));
+        for(unsigned int k = 0; k < composants.size; k++)
+        {
+            if(composants.tags[k] == tag) return composants.errors[k];
+        }
+        return 0.;
+    }
+}
+
+TEST(TOPK, eviction)
+{
+    const int capacity = Composants::capacity;
+
+    // the largest errors are kept, the others go to the residual
+    const Composants result = composants(0, capacity + 2);
+    EXPECT_EQ(result.size, unsigned(capacity));
+    EXPECT_EQ(result.residual, 1. + 2.);
+    for(int i = 2; i < capacity + 2; i++)
+    {
+        EXPECT_EQ(errorOf(result, i), double(i + 1));
+    }
+
+    // the composants stay sorted by tag
+    for(unsigned int k = 1; k < result.size; k++)
+    {
+        EXPECT_LT(result.tags[k-1], result.tags[k]);
+    }
+}
+
+TEST(TOPK, merge)
+{
+    const int capacity = Composants::capacity;
+
+    // the tags shared by both operands are combined before being ranked
+    Composants sum = composants(0, capacity);
+    sum.addErrors(composants(capacity, 2 * capacity));
+    EXPECT_EQ(sum.size, unsigned(capacity));
+    double expectedResidual = 0.;
+    for(int i = 0; i < capacity; i++) expectedResidual += double(i + 1);
+    EXPECT_EQ(sum.residual, expectedResidual);
+
+    Composants difference = composants(0, capacity);
+    difference.subErrors(composants(0, 1));
+    EXPECT_EQ(errorOf(difference, 0), 0.);
+    EXPECT_EQ(errorOf(difference, 1), 2.);
+
+    // the total error is preserved by linear operations
+    Composants scaled(sum, [](double e){return 2. * e;});
+    double total = scaled.residual;
+    for(unsigned int k = 0; k < scaled.size; k++) total += scaled.errors[k];
+    double expectedTotal = 0.;
+    for(int i = 0; i < 2 * capacity; i++) expectedTotal += 2. * double(i + 1);
+    EXPECT_EQ(total, expectedTotal);
+}
+
+TEST(TOPK, numbers)
+{
+    // more blocks than kept composants
+    Sdouble sum = 0.;
+    for(int i = 0; i < 20; i++)
+    {
+        CodeBlock block("topk_number_" + std::to_string(i));
+        sum += Sdouble(1.) / double(3 * i + 7);
+    }
+    ASSERT_NE(sum.error, 0.);
+
+    double total = sum.errorComposants.residual;
+    for(unsigned int k = 0; k < sum.errorComposants.size; k++) total += sum.errorComposants.errors[k];
+    EXPECT_NEAR(total, sum.error, 1e-3 * std::abs(sum.error));
+    EXPECT_NE(std::string(sum.errorComposants).find("other"), std::string::npos);
+}
+
+TEST(TOPK, zero_error)
+{
+    // zero errors do not take composants
+    Composants result = composants(0, 2);
+    for(int i = 2; i < 2 + int(Composants::capacity); i++)
+    {
+        CodeBlock block("topk_" + std::to_string(i));
+        result.addError(0.);
+    }
+    EXPECT_EQ(result.size, 2u);
+    EXPECT_EQ(result.residual, 0.);
+    EXPECT_EQ(errorOf(result, 0), 1.);
+    EXPECT_EQ(errorOf(result, 1), 2.);
+}
+
+TEST(TOPK, tag_overflow)
+{
+    // declares enough blocks for the next one to be beyond SHAMAN_TAGNUMBER
+    const size_t maxTagNumber = Composants::maxTagNumber;
+    for(size_t i = CodeBlock::tagNumber(); i <= maxTagNumber; i++)
+    {
+        CodeBlock block("topk_overflow_" + std::to_string(i));
+    }
+
+    // the tags beyond SHAMAN_TAGNUMBER are kept like any other
+    Sdouble x = 1.;
+    {
+        CodeBlock block("topk_overflow_block");
+        x /= 3.;
+    }
+    const Tag tag = CodeBlock::tagOfName("topk_overflow_block");
+    ASSERT_GE(tag, maxTagNumber);
+    ASSERT_EQ(x.errorComposants.size, 1u);
+    EXPECT_EQ(x.errorComposants.tags[0], tag);
+    EXPECT_EQ(x.errorComposants.errors[0], x.error);
+    EXPECT_NE(std::string(x.errorComposants).find("topk_overflow_block"), std::string::npos);
+
+    // they are dropped by the conversion to error_sum
+    const error_sum<double> sum = x.errorComposants;
+    for(double error : sum.errors)
+    {
+        EXPECT_EQ(error, 0.);
+    }
+}
+#endif //SHAMAN_TOPK_ERROR
@@ -0,0 +1,51 @@
+#include <shaman.h>
+
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+TEST(UNSTABLE_BREAK, hook)
+{
+    std::vector<long long> stops;
+    Shaman::Session& session = Shaman::session();
+    session.unstableAction = Shaman::Session::UnstableAction::hook;
+    session.unstableHook = [&stops](long long unstableTest){stops.push_back(unstableTest);};
+    session.unstableBreak = ShamanGlobals::unstableBranchCounter + 3;
+
+    for(int i = 0; i < 5; i++) Shaman::unstability();
+    ASSERT_EQ(stops.size(), 1u);
+    EXPECT_EQ(stops[0], session.unstableBreak);
+
+    // per thread numbering, each thread stops on its own third unstable test
+    session.unstableCounterPerThread = true;
+    session.unstableBreak = 3;
+    stops.clear();
+    std::thread thread([]()
+    {
+        for(int i = 0; i < 5; i++) Shaman::unstability();
+    });
+    thread.join();
+    ASSERT_EQ(stops.size(), 1u);
+    EXPECT_EQ(stops[0], 3);
+
+    session.unstableCounterPerThread = false;
+    session.unstableBreak = 0;
+    session.unstableHook = nullptr;
+    session.unstableAction = Shaman::Session::UnstableAction::trap;
+}
+
+TEST(UNSTABLE_BREAK, environment)
+{
+    setenv("SHAMAN_UNSTABLE_BREAK", "42", 1);
+    setenv("SHAMAN_UNSTABLE_ACTION", "backtrace", 1);
+    setenv("SHAMAN_UNSTABLE_COUNTER", "thread", 1);
+    const Shaman::Session session;
+    unsetenv("SHAMAN_UNSTABLE_BREAK");
+    unsetenv("SHAMAN_UNSTABLE_ACTION");
+    unsetenv("SHAMAN_UNSTABLE_COUNTER");
+
+    EXPECT_EQ(session.unstableBreak, 42);
+    EXPECT_TRUE(session.unstableAction == Shaman::Session::UnstableAction::backtrace);
+    EXPECT_TRUE(session.unstableCounterPerThread);
+}
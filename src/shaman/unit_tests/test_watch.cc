@@ -0,0 +1,118 @@
+#include <shaman.h>
+#include <shaman/helpers/shaman_watch.h>
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+namespace
+{
+    struct Sample
+    {
+        std::uint32_t thread;
+        std::uint64_t step;
+        double number;
+        double error;
+        float digits;
+    };
+
+    /*
+     * reads a watch file (see shaman_watch.h for the format)
+     */
+    std::map<std::string, std::vector<Sample>> readWatchFile(const std::string& path)
+    {
+        std::map<std::uint32_t, std::string> names;
+        std::map<std::uint32_t, std::vector<Sample>> samples;
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        EXPECT_NE(file, nullptr);
+        if(file == nullptr) return {};
+
+        char magic[8];
+        EXPECT_EQ(std::fread(magic, 1, 8, file), 8u);
+        EXPECT_EQ(std::memcmp(magic, "SHAMANW1", 8), 0);
+        std::uint32_t variable;
+        while(std::fread(&variable, sizeof(variable), 1, file) == 1)
+        {
+            if(variable & 0x80000000u)
+            {
+                std::uint32_t length;
+                EXPECT_EQ(std::fread(&length, sizeof(length), 1, file), 1u);
+                std::string name(length, ' ');
+                EXPECT_EQ(std::fread(&name[0], 1, length, file), length);
+                names[variable & 0x7FFFFFFFu] = name;
+            }
+            else
+            {
+                Sample sample;
+                bool complete = std::fread(&sample.thread, sizeof(sample.thread), 1, file) == 1;
+                complete = complete and (std::fread(&sample.step, sizeof(sample.step), 1, file) == 1);
+                complete = complete and (std::fread(&sample.number, sizeof(sample.number), 1, file) == 1);
+                complete = complete and (std::fread(&sample.error, sizeof(sample.error), 1, file) == 1);
+                complete = complete and (std::fread(&sample.digits, sizeof(sample.digits), 1, file) == 1);
+                EXPECT_TRUE(complete);
+                samples[variable].push_back(sample);
+            }
+        }
+        std::fclose(file);
+
+        std::map<std::string, std::vector<Sample>> result;
+        for(const auto& variableSamples : samples)
+        {
+            EXPECT_EQ(names.count(variableSamples.first), 1u);
+            result[names[variableSamples.first]] = variableSamples.second;
+        }
+        return result;
+    }
+}
+
+TEST(WATCH, time_series)
+{
+    const std::string path = "shaman_test_watch.shw";
+    ASSERT_TRUE(Shaman::watch_open(path));
+
+    Sdouble x = 1.;
+    Shaman::WatchedVariable watchedX("x");
+    for(int step = 0; step < 100; step++)
+    {
+        Shaman::watch_step(step);
+        x = x / 3.;
+        Shaman::watch("x_by_name", x);
+        Shaman::watch(std::string("x_by_") + "runtime_name", x);
+        watchedX(x);
+    }
+
+    // samples of another thread
+    std::thread thread([]()
+    {
+        for(int i = 0; i < 10; i++) Shaman::watch("other_thread", Sdouble(1.) / double(i + 3));
+    });
+    thread.join();
+    Shaman::watch_close();
+
+    std::map<std::string, std::vector<Sample>> variables = readWatchFile(path);
+    ASSERT_EQ(variables.size(), 4u);
+    ASSERT_EQ(variables["x"].size(), 100u);
+    ASSERT_EQ(variables["x_by_name"].size(), 100u);
+    ASSERT_EQ(variables["x_by_runtime_name"].size(), 100u);
+    EXPECT_EQ(variables["other_thread"].size(), 10u);
+    EXPECT_NE(variables["other_thread"][0].thread, variables["x"][0].thread);
+
+    Sdouble expected = 1.;
+    for(std::uint64_t step = 0; step < 100; step++)
+    {
+        expected = expected / 3.;
+        const Sample& sample = variables["x"][step];
+        EXPECT_EQ(sample.step, step);
+        EXPECT_EQ(sample.number, expected.number);
+        EXPECT_EQ(sample.error, double(expected.error));
+        EXPECT_FLOAT_EQ(sample.digits, float(expected.digits()));
+    }
+    std::remove(path.c_str());
+
+    // without an open file, watching does nothing
+    Shaman::watch("x_by_name", x);
+}
@@ -0,0 +1,94 @@
+# SHAMAN WATCH : reads the files written by Shaman::watch_open/Shaman::watch
+#
+# usage : $ python3 shaman_watch.py run.shw               # summary of each watched variable
+#         $ python3 shaman_watch.py run.shw --csv out.csv # all the samples as csv
+#         $ python3 shaman_watch.py run.shw --plot        # significant digits per step (requires matplotlib)
+#
+# file format (native endianness) : the 8 bytes "SHAMANW1" followed by a sequence of records starting with a uint32
+# - name of a variable : 0x80000000 | variable, uint32 length, the 'length' characters of the name
+# - sample : variable, uint32 thread, uint64 step, double number, double error, float digits
+
+import sys
+import struct
+import argparse
+from collections import defaultdict
+
+MAGIC = b"SHAMANW1"
+NAME_FLAG = 0x80000000
+SAMPLE_FORMAT = struct.Struct("=IQddf") # thread, step, number, error, digits (the variable is read first)
+
+#------------------------------------------------------------------------------
+# PARSING
+
+def read_watch_file(path):
+    """returns a dictionary associating each variable name with its list of (thread, step, number, error, digits)"""
+    with open(path, "rb") as file:
+        data = file.read()
+    if data[:len(MAGIC)] != MAGIC:
+        raise ValueError(path + " is not a Shaman watch file")
+
+    names = {}
+    samples = defaultdict(list)
+    position = len(MAGIC)
+    while position + 4 <= len(data):
+        (variable,) = struct.unpack_from("=I", data, position)
+        position += 4
+        if variable & NAME_FLAG:
+            (length,) = struct.unpack_from("=I", data, position)
+            position += 4
+            names[variable & ~NAME_FLAG] = data[position:position+length].decode()
+            position += length
+        else:
+            if position + SAMPLE_FORMAT.size > len(data): break # truncated file (the program is still running)
+            samples[variable].append(SAMPLE_FORMAT.unpack_from(data, position))
+            position += SAMPLE_FORMAT.size
+
+    # the name of a variable might be written after its first samples
+    return {names.get(variable, "variable_" + str(variable)): values for variable, values in samples.items()}
+
+#------------------------------------------------------------------------------
+# OUTPUTS
+
+def display_summary(variables):
+    """displays, for each variable, its number of samples and its worst precision"""
+    for name, samples in sorted(variables.items()):
+        worst = min(samples, key=lambda sample: sample[4])
+        last = samples[-1]
+        print("{} : {} samples from step {} to {}, last value {} ({:.3g} digits), worst precision {:.3g} digits at step {}".format(
+              name, len(samples), samples[0][1], last[1], last[2], last[4], worst[4], worst[1]))
+
+def write_csv(variables, path):
+    """writes all the samples in a csv file"""
+    with open(path, "w") as file:
+        file.write("variable,thread,step,number,error,digits\n")
+        for name, samples in sorted(variables.items()):
+            for thread, step, number, error, digits in samples:
+                file.write("{},{},{},{!r},{!r},{!r}\n".format(name, thread, step, number, error, digits))
+
+def plot(variables):
+    """plots the significant digits of each variable as a function of the step"""
+    import matplotlib.pyplot as plt
+    for name, samples in sorted(variables.items()):
+        plt.plot([sample[1] for sample in samples], [sample[4] for sample in samples], label=name)
+    plt.xlabel("step")
+    plt.ylabel("significant digits")
+    plt.legend()
+    plt.show()
+
+#------------------------------------------------------------------------------
+# MAIN
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Reads the files written by Shaman::watch.")
+    parser.add_argument("file", help="file given to Shaman::watch_open")
+    parser.add_argument("--csv", help="writes all the samples to the given csv file")
+    parser.add_argument("--plot", action="store_true", help="plots the significant digits per step (requires matplotlib)")
+    arguments = parser.parse_args()
+
+    variables = read_watch_file(arguments.file)
+    if not variables:
+        print("no sample found in " + arguments.file)
+        sys.exit(0)
+    display_summary(variables)
+    if arguments.csv: write_csv(variables, arguments.csv)
+    if arguments.plot: plot(variables)